@@ -1,64 +1,146 @@
 #pragma once
 
-#include <memory>
+#include <atomic>
+#include <condition_variable>
 #include <mutex>
-#include <thread>
+#include <optional>
+#include <utility>
 
+// Two-lock concurrent queue (Michael and Scott, "Simple, Fast, and Practical Non-Blocking and Blocking Concurrent Queue
+// Algorithms", 1996). The list always starts with a dummy node, so the head (popping) and the tail (pushing) never
+// touch the same node's data and each end has its own mutex: one producer and one consumer run at the same time
+// without contending. The only node both ends share is the dummy's next pointer when the queue is empty, which is
+// atomic.
+//
+// Popped nodes are recycled through a free list instead of deleted: the popping side pushes them on a lock-free stack
+// and the pushing side takes the whole stack in one exchange when its spare list runs out. Taking everything at once
+// means the stack has no ABA problem. Once the queue has reached its largest size, push and pop never allocate.
+//
+// waitPop blocks on a condition variable tied to the head mutex. A producer only takes the head mutex to notify when
+// a consumer is waiting, so producers and consumers stay on separate locks otherwise.
 template <typename T>
 class SequentialQueue {
 public:
 
-    // We create a dummy node with no real data to help with concurrent access to both pop and push at the same
-    // time.
-    SequentialQueue(): mHead(new Node), mTail(mHead.get()) {}
+    SequentialQueue(): mHead(new Node), mTail(mHead) {}
 
-    Node *getTail(void) {
-        std::lock_guard<std::mutex> lg(mTailMutex);
-        return mTail;
+    ~SequentialQueue() {
+        deleteList(mHead);
+        deleteList(mSpare);
+        deleteList(mFreeList.load());
     }
 
-    void push(T value) {
+    // No copying
+    SequentialQueue(const SequentialQueue &) = delete;
+    SequentialQueue &operator=(const SequentialQueue &) = delete;
 
-        // change current dummy nodes data value
-        auto newData = std::make_shared<T>(std::move(value));
-        auto p = std::make_unique<Node>();
-        const Node *newTail = p.get();
+    void push(T value) {
         {
             std::lock_guard<std::mutex> tlg(mTailMutex);
-            mTail->data = newData;
-            mTail->next = std::move(p);
-            mTail = newTail;
+            Node *node = takeNode();
+            node->data.emplace(std::move(value));
+            node->next.store(nullptr, std::memory_order_relaxed);
+
+            // Publishes the node to the head side (and, being sequentially consistent, orders it before the read of
+            // mWaiters below).
+            mTail->next.store(node);
+            mTail = node;
         }
-    }
 
-    std::shared_ptr<T> pop(void) {
+        if (mWaiters.load() > 0) {
+            std::lock_guard<std::mutex> hlg(mHeadMutex);
+            mDataCondition.notify_one();
+        }
+    }
 
-        // If we just lock the head mutex here (since we are only modifying mHead) we get a race condition with the 
-        // push function. We need to lock both, but that constrains concurrent access to this data structure. Only 
-        // one thread can use the data structure at a time.
+    // Returns the front value, or nothing if the queue is empty.
+    std::optional<T> pop(void) {
+        std::lock_guard<std::mutex> hlg(mHeadMutex);
+        return popHead();
+    }
 
-        std::lock_guard<std::mutex> lg(mHeadMutex);
-        if (head.get() == getTail()) {
-            return std::shared_ptr<T>();
+    // Waits until there is a value to pop.
+    T waitPop(void) {
+        std::unique_lock<std::mutex> hlk(mHeadMutex);
+        if (std::optional<T> value = popHead()) {
+            return std::move(*value);
         }
-        const auto res = std::make_shared<T>(std::move(mHead->data));
-        const auto oldHead = std::move(mHead);
-        mHead = std::move(oldHead->next);
-        return res;  
+
+        // Registering as a waiter before checking for a node means a push either sees the waiter and notifies, or
+        // linked its node before the check.
+        mWaiters.fetch_add(1);
+        mDataCondition.wait(hlk, [this] { return mHead->next.load() != nullptr; });
+        mWaiters.fetch_sub(1);
+        return std::move(*popHead());
+    }
+
+    bool empty(void) {
+        std::lock_guard<std::mutex> hlg(mHeadMutex);
+        return mHead->next.load(std::memory_order_acquire) == nullptr;
     }
 
 private:
 
     struct Node {
-        T mData;
-        std::unique_ptr<Node> mNext;
-
-        Node(T data) : mData(std::move(data)) {}
+        std::atomic<Node *> next = nullptr;
+        std::optional<T> data;      // Empty in the dummy node and in recycled nodes
     };
 
-    std::unique_ptr<Node> mHead;
-    Node *mTail;
+    // Head mutex held.
+    std::optional<T> popHead(void) {
+        Node *next = mHead->next.load(std::memory_order_acquire);
+        if (next == nullptr) {
+            return std::nullopt;
+        }
+
+        // The next node becomes the dummy, and the old dummy is recycled.
+        std::optional<T> value(std::move(next->data));
+        next->data.reset();
+        Node *oldHead = mHead;
+        mHead = next;
+        recycle(oldHead);
+        return value;
+    }
+
+    // Head mutex held, so there is one pusher on the free list at a time.
+    void recycle(Node *node) {
+        Node *top = mFreeList.load(std::memory_order_relaxed);
+        do {
+            node->next.store(top, std::memory_order_relaxed);
+        } while (!mFreeList.compare_exchange_weak(top, node, std::memory_order_release, std::memory_order_relaxed));
+    }
+
+    // Tail mutex held.
+    Node *takeNode(void) {
+        if (mSpare == nullptr) {
+            mSpare = mFreeList.exchange(nullptr, std::memory_order_acquire);
+        }
+        if (mSpare == nullptr) {
+            return new Node;
+        }
+        Node *node = mSpare;
+        mSpare = node->next.load(std::memory_order_relaxed);
+        return node;
+    }
+
+    static void deleteList(Node *node) {
+        while (node != nullptr) {
+            Node *next = node->next.load(std::memory_order_relaxed);
+            delete node;
+            node = next;
+        }
+    }
+
+    // Head side.
     std::mutex mHeadMutex;
-    std::mutex mTailMutex;
+    Node *mHead;
+    std::condition_variable mDataCondition;
+    std::atomic<int> mWaiters = 0;
+
+    // Tail side, on its own cache line so pushing doesn't invalidate the head side's.
+    alignas(64) std::mutex mTailMutex;
+    Node *mTail;
+    Node *mSpare = nullptr;     // Recycled nodes taken from the free list
 
-};
\ No newline at end of file
+    alignas(64) std::atomic<Node *> mFreeList = nullptr;
+};
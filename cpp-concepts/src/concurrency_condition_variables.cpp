@@ -1,3 +1,4 @@
+#include <chrono>
 #include <condition_variable>
 #include <cmath>
 #include <cstdio>
@@ -10,6 +11,8 @@
 #include <thread>
 #include <vector>
 
+#include "sequential_queue.h"
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Condition Variable
 // ------------------
@@ -104,6 +107,88 @@ public:
 
 }
 
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Queue Benchmark
+// ---------------
+// ThreadSafeQueue puts both ends behind one mutex and allocates a shared_ptr per push. SequentialQueue (see
+// sequential_queue.h) locks the head and tail separately and recycles its nodes, so a producer and a consumer don't
+// contend and steady state push/pop doesn't allocate. Each run moves the same number of items from P producers to C
+// consumers, which block in waitPop.
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace queuebenchmark {
+
+template <typename Queue>
+double itemsPerSecond(int producers, int consumers, int items) {
+    Queue queue;
+    std::vector<std::thread> threads;
+    std::atomic<long> checksum = 0;
+
+    const auto start = std::chrono::steady_clock::now();
+    for (int p = 0; p < producers; p++) {
+        threads.emplace_back([&queue, p, producers, items] {
+            for (int i = p; i < items; i += producers) {
+                queue.push(i);
+            }
+        });
+    }
+    for (int c = 0; c < consumers; c++) {
+        threads.emplace_back([&queue, &checksum, c, consumers, items] {
+            long sum = 0;
+            for (int i = c; i < items; i += consumers) {
+                sum += *queue.waitPop();
+            }
+            checksum += sum;
+        });
+    }
+    for (auto &t : threads) {
+        t.join();
+    }
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    if (checksum != long(items) * (items - 1) / 2) {
+        std::cout << "Lost items!" << std::endl;
+    }
+    return items / elapsed.count();
+}
+
+// waitPop returns a shared_ptr from ThreadSafeQueue and a value from SequentialQueue; this gives both a pointer-like
+// interface for the benchmark.
+template <typename T>
+class SequentialQueueAdapter {
+public:
+
+    void push(T value) {
+        mQueue.push(std::move(value));
+    }
+
+    std::optional<T> waitPop(void) {
+        return mQueue.waitPop();
+    }
+
+private:
+
+    SequentialQueue<T> mQueue;
+};
+
+void run(void) {
+
+    std::cout << "-----------------------------------------" << std::endl;
+    std::cout << "-- QUEUE BENCHMARK" << std::endl;
+    std::cout << "-----------------------------------------" << std::endl;
+
+    const int items = 1000000;
+    printf("%u hardware threads, %d items\n", std::thread::hardware_concurrency(), items);
+    printf("producers/consumers  ThreadSafeQueue  SequentialQueue  (items/s)\n");
+    for (int threads : {1, 2, 4}) {
+        const double single = itemsPerSecond<threadsafequeue::ThreadSafeQueue<int>>(threads, threads, items);
+        const double twoLock = itemsPerSecond<SequentialQueueAdapter<int>>(threads, threads, items);
+        printf("%9d/%-9d %16.0f %16.0f\n", threads, threads, single, twoLock);
+    }
+}
+
+}
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Futures
 // -------
@@ -383,4 +468,5 @@ int main() {
     promises::run();
     // promiseswithexceptions::run();  // asks for user input
     sharedfutures::run();
+    queuebenchmark::run();
 }
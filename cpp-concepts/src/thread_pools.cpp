@@ -1,17 +1,35 @@
+#include <algorithm>
 #include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <ctime>
 #include <functional>
+#include <future>
 #include <iostream>
+#include <memory>
 #include <mutex>
 #include <optional>
 #include <queue>
 #include <thread>
+#include <type_traits>
 #include <vector>
 
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Yielding Thread Pool
+// --------------------
+// The simplest pool: one mutex protected queue, with idle workers spinning on std::this_thread::yield(). Every submit
+// and every pop contends on the same mutex, idle workers burn a core each, and the destructor stops the workers
+// without running the tasks still queued. Kept as the baseline for the benchmarks below.
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace yielding {
+
 class ThreadPool {
 public:
 
     ThreadPool() {
-        const auto threadCount = std::thread::hardware_concurrency();
+        const auto threadCount = std::max(1u, std::thread::hardware_concurrency());
         for (size_t i = 0; i < threadCount; i++) {
             mThreads.emplace_back(&ThreadPool::workerThread, this);
         }
@@ -55,25 +73,461 @@ private:
 
     std::queue<std::function<void()>> mQueue;
 
+    std::mutex mMutex;
+
+    // Declared last so the workers are joined before the queue and mutex they use are destroyed.
     std::vector<std::jthread> mThreads;
+};
 
-    std::mutex mMutex;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Work Stealing Deque
+// -------------------
+// Chase-Lev deque (with the C++11 memory orderings of Le, Pop, Cohen and Zappa Nardelli, "Correct and Efficient
+// Work-Stealing for Weak Memory Models", 2013). The owning thread pushes and pops at the bottom like a stack, which
+// keeps recently pushed (cache hot) work local, while other threads steal the oldest items from the top. Push and pop
+// only need a CAS when racing a thief for the last item; a steal is one CAS.
+//
+// The circular buffer grows when full. A thief may still be reading the old buffer, so replaced buffers are kept
+// until the deque is destroyed (they total less than the final buffer).
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace workstealing {
+
+template <typename T>
+class WorkStealingDeque {
+
+    static_assert(std::is_trivially_copyable_v<T>, "Items are copied with plain atomic loads and stores");
+
+public:
+
+    explicit WorkStealingDeque(int64_t capacity = 1024): mTop(0), mBottom(0) {
+        auto array = std::make_unique<Array>(capacity);
+        mArray.store(array.get(), std::memory_order_relaxed);
+        mArrays.push_back(std::move(array));
+    }
+
+    WorkStealingDeque(const WorkStealingDeque &) = delete;
+    WorkStealingDeque &operator=(const WorkStealingDeque &) = delete;
+
+    // Owner only.
+    void push(T item) {
+        const int64_t bottom = mBottom.load(std::memory_order_relaxed);
+        const int64_t top = mTop.load(std::memory_order_acquire);
+        Array *array = mArray.load(std::memory_order_relaxed);
+        if (bottom - top > array->capacity - 1) {
+            array = grow(array, top, bottom);
+        }
+        array->put(bottom, item);
+        // Publishes the item to thieves, which read bottom with acquire (the paper's release fence, as a store).
+        mBottom.store(bottom + 1, std::memory_order_release);
+    }
+
+    // Owner only.
+    std::optional<T> pop(void) {
+        const int64_t bottom = mBottom.load(std::memory_order_relaxed) - 1;
+        Array *array = mArray.load(std::memory_order_relaxed);
+        mBottom.store(bottom, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t top = mTop.load(std::memory_order_relaxed);
+
+        if (top > bottom) {
+            // Empty.
+            mBottom.store(bottom + 1, std::memory_order_relaxed);
+            return std::nullopt;
+        }
+
+        T item = array->get(bottom);
+        if (top == bottom) {
+            // Last item: whoever moves top first gets it.
+            const bool won = mTop.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst,
+                                                          std::memory_order_relaxed);
+            mBottom.store(bottom + 1, std::memory_order_relaxed);
+            if (!won) {
+                return std::nullopt;
+            }
+        }
+        return item;
+    }
+
+    // Any thread.
+    std::optional<T> steal(void) {
+        int64_t top = mTop.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        const int64_t bottom = mBottom.load(std::memory_order_acquire);
+        if (top >= bottom) {
+            return std::nullopt;
+        }
+
+        Array *array = mArray.load(std::memory_order_acquire);
+        T item = array->get(top);
+        if (!mTop.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+            return std::nullopt;
+        }
+        return item;
+    }
+
+    bool empty(void) const {
+        return mBottom.load(std::memory_order_relaxed) <= mTop.load(std::memory_order_relaxed);
+    }
+
+private:
+
+    struct Array {
+        int64_t capacity;   // Always a power of two, so indices wrap with a mask
+        std::unique_ptr<std::atomic<T>[]> items;
+
+        explicit Array(int64_t c): capacity(c), items(new std::atomic<T>[c]) {}
+
+        T get(int64_t i) const { return items[i & (capacity - 1)].load(std::memory_order_relaxed); }
+        void put(int64_t i, T item) { items[i & (capacity - 1)].store(item, std::memory_order_relaxed); }
+    };
+
+    Array *grow(Array *array, int64_t top, int64_t bottom) {
+        auto bigger = std::make_unique<Array>(array->capacity * 2);
+        for (int64_t i = top; i < bottom; i++) {
+            bigger->put(i, array->get(i));
+        }
+        Array *result = bigger.get();
+        mArrays.push_back(std::move(bigger));
+        mArray.store(result, std::memory_order_release);
+        return result;
+    }
+
+    // Top and bottom are written by different threads, so they get a cache line each.
+    alignas(64) std::atomic<int64_t> mTop;
+    alignas(64) std::atomic<int64_t> mBottom;
+    alignas(64) std::atomic<Array *> mArray;
+    std::vector<std::unique_ptr<Array>> mArrays;    // Current and replaced buffers, owner only
 };
 
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Work Stealing Thread Pool
+// -------------------------
+// Each worker owns a Chase-Lev deque. Tasks submitted from a worker (e.g. a task splitting its work) go on that
+// worker's deque; tasks submitted from any other thread go on a global injection queue. An idle worker looks in its
+// own deque, then the injection queue, then tries to steal from the others.
+//
+// A worker that finds nothing parks on a condition variable instead of spinning. mPending counts the tasks queued and
+// not yet taken; a worker only sleeps while it is zero, and submit only takes the sleep mutex to wake someone when a
+// worker is parked. Both sides update their own counter before reading the other's (sequentially consistent), so
+// either the worker sees the new task or the submitter sees the sleeping worker, and no wake-up is lost.
+//
+// Only one wake-up is in flight at a time (mWaking): a burst of submits costs one notify rather than one each, and
+// the woken worker, once it has a task, wakes the next sleeper if there is more work.
+//
+// submit returns a std::future for the task's result; post runs a task without one, which saves the future's shared
+// state when nothing waits on the result (an exception escaping a posted task terminates the program, as it would on
+// a std::thread; submit stores it in the future instead). The destructor drains the pool: every task submitted before
+// it (and every task those tasks submit) runs before the workers are joined.
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+class ThreadPool {
+public:
+
+    explicit ThreadPool(size_t threadCount = std::max(1u, std::thread::hardware_concurrency())) {
+        for (size_t i = 0; i < threadCount; i++) {
+            mQueues.push_back(std::make_unique<WorkStealingDeque<Task *>>());
+        }
+        for (size_t i = 0; i < threadCount; i++) {
+            mThreads.emplace_back(&ThreadPool::workerThread, this, i);
+        }
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard lock(mSleepMutex);
+            mStopping.store(true);
+        }
+        mWakeUp.notify_all();
+        for (auto &thread : mThreads) {
+            thread.join();
+        }
+    }
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    template <typename F>
+    std::future<std::invoke_result_t<F>> submit(F f) {
+        std::packaged_task<std::invoke_result_t<F>()> task(std::move(f));
+        auto future = task.get_future();
+        schedule(new Task(std::move(task)));
+        return future;
+    }
+
+    template <typename F>
+    void post(F f) {
+        schedule(new Task(std::move(f)));
+    }
+
+    size_t size(void) const {
+        return mThreads.size();
+    }
+
+private:
+
+    using Task = std::move_only_function<void()>;
+
+    void schedule(Task *task) {
+        if (tlsPool == this) {
+            mQueues[tlsIndex]->push(task);
+        } else {
+            std::lock_guard lock(mInjectionMutex);
+            mInjectionQueue.push(task);
+        }
+
+        mPending.fetch_add(1);
+        wakeOne();
+    }
+
+    void wakeOne(void) {
+        if (mSleeping.load() > 0 && !mWaking.exchange(true)) {
+            std::lock_guard lock(mSleepMutex);
+            mWakeUp.notify_one();
+        }
+    }
+
+    Task *findTask(size_t index) {
+        if (auto task = mQueues[index]->pop()) {
+            return *task;
+        }
+        {
+            std::lock_guard lock(mInjectionMutex);
+            if (!mInjectionQueue.empty()) {
+                Task *task = mInjectionQueue.front();
+                mInjectionQueue.pop();
+                return task;
+            }
+        }
+        for (size_t i = 1; i < mQueues.size(); i++) {
+            if (auto task = mQueues[(index + i) % mQueues.size()]->steal()) {
+                return *task;
+            }
+        }
+        return nullptr;
+    }
+
+    // Sleeps until there is a task to take or the pool is stopping. Returns false once it is stopping with nothing
+    // left to run.
+    bool park(void) {
+        std::unique_lock lock(mSleepMutex);
+        mSleeping.fetch_add(1);
+
+        // mWaking is cleared before every check of mPending, so a submit that saw it set (and so didn't notify) is
+        // seen. That includes a wake-up that finds nothing to do: mPending can briefly go negative (a task taken
+        // before its push is counted), and the notify that brings it back to zero must not leave mWaking set.
+        mWaking.store(false);
+        while (mPending.load() <= 0 && !mStopping.load()) {
+            mWakeUp.wait(lock);
+            mWaking.store(false);
+        }
+        mSleeping.fetch_sub(1);
+        return mPending.load() > 0 || !mStopping.load();
+    }
+
+    void workerThread(size_t index) {
+        tlsPool = this;
+        tlsIndex = index;
+
+        while (true) {
+            if (Task *task = findTask(index)) {
+                if (mPending.fetch_sub(1) > 1) {
+                    wakeOne();
+                }
+                (*task)();
+                delete task;
+            } else if (mPending.load() <= 0 && !park()) {
+                break;
+            }
+        }
+        tlsPool = nullptr;
+    }
+
+    // Pool and deque of the worker running on this thread, if any.
+    static inline thread_local ThreadPool *tlsPool = nullptr;
+    static inline thread_local size_t tlsIndex = 0;
+
+    std::vector<std::unique_ptr<WorkStealingDeque<Task *>>> mQueues;
+
+    std::mutex mInjectionMutex;
+    std::queue<Task *> mInjectionQueue;
+
+    // Tasks pushed and not yet taken. Signed, as a task can be taken before its push is counted.
+    std::atomic<int64_t> mPending = 0;
+    std::atomic<int> mSleeping = 0;
+    std::atomic<bool> mWaking = false;
+    std::atomic<bool> mStopping = false;
+    std::mutex mSleepMutex;
+    std::condition_variable mWakeUp;
+
+    std::vector<std::thread> mThreads;
+};
+
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Benchmarks
+// ----------
+// Throughput: many tiny tasks submitted from the main thread, and a binary tree of tasks spawned from inside the pool
+// (where the work stealing pool keeps each worker on its own deque).
+// Latency: time from submit to the task starting on an idle pool, and the CPU time an idle pool burns.
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace benchmarks {
+
+using Clock = std::chrono::steady_clock;
+
+// Runs f on the pool without a future: post on the work stealing pool, submit on the yielding one.
+template <typename Pool, typename F>
+void post(Pool &pool, F f) {
+    if constexpr (requires { pool.post(f); }) {
+        pool.post(std::move(f));
+    } else {
+        pool.submit(std::move(f));
+    }
+}
+
+// Waits for a counter the tasks increment, as the yielding pool has no futures.
+void waitFor(const std::atomic<int> &counter, int target) {
+    while (counter.load() < target) {
+        std::this_thread::yield();
+    }
+}
+
+template <typename Pool>
+double flatThroughput(Pool &pool, int taskCount) {
+    std::atomic<int> done = 0;
+    const auto start = Clock::now();
+    for (int i = 0; i < taskCount; i++) {
+        post(pool, [&done] { done.fetch_add(1); });
+    }
+    waitFor(done, taskCount);
+    return taskCount / std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+// Same, through submit and its futures.
+double futureThroughput(workstealing::ThreadPool &pool, int taskCount) {
+    std::vector<std::future<void>> results;
+    results.reserve(taskCount);
+    const auto start = Clock::now();
+    for (int i = 0; i < taskCount; i++) {
+        results.push_back(pool.submit([] {}));
+    }
+    for (auto &result : results) {
+        result.get();
+    }
+    return taskCount / std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+template <typename Pool>
+void spawnTree(Pool &pool, std::atomic<int> &leaves, int depth) {
+    if (depth == 0) {
+        leaves.fetch_add(1);
+        return;
+    }
+    post(pool, [&pool, &leaves, depth] { spawnTree(pool, leaves, depth - 1); });
+    post(pool, [&pool, &leaves, depth] { spawnTree(pool, leaves, depth - 1); });
+}
+
+template <typename Pool>
+double treeThroughput(Pool &pool, int depth) {
+    std::atomic<int> leaves = 0;
+    const auto start = Clock::now();
+    post(pool, [&pool, &leaves, depth] { spawnTree(pool, leaves, depth); });
+    waitFor(leaves, 1 << depth);
+    const int taskCount = (2 << depth) - 1;
+    return taskCount / std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+struct Latency {
+    double median;
+    double p99;
+};
+
+template <typename Pool>
+Latency submitLatency(Pool &pool, int samples) {
+    std::vector<double> latencies;
+    for (int i = 0; i < samples; i++) {
+        // Let the pool go idle (and park) between samples.
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+        std::atomic<int> done = 0;
+        Clock::time_point started;
+        const auto submitted = Clock::now();
+        post(pool, [&done, &started] {
+            started = Clock::now();
+            done.store(1);
+        });
+        waitFor(done, 1);
+        latencies.push_back(std::chrono::duration<double, std::micro>(started - submitted).count());
+    }
+    std::sort(latencies.begin(), latencies.end());
+    return {latencies[latencies.size() / 2], latencies[latencies.size() * 99 / 100]};
+}
+
+// Process CPU time used while the pool sits idle for the given wall time, as a fraction of that time.
+template <typename Pool>
+double idleCpuLoad(Pool &, std::chrono::milliseconds idle) {
+    const std::clock_t start = std::clock();
+    std::this_thread::sleep_for(idle);
+    return double(std::clock() - start) / CLOCKS_PER_SEC / std::chrono::duration<double>(idle).count();
+}
+
+template <typename Pool>
+void runAll(const char *name, Pool &pool) {
+    const double flat = flatThroughput(pool, 200000);
+    const double tree = treeThroughput(pool, 16);
+    const Latency latency = submitLatency(pool, 500);
+    const double idle = idleCpuLoad(pool, std::chrono::milliseconds(200));
+    printf("%-14s %10.0f %10.0f %10.2f %10.2f %9.2f\n", name, flat, tree, latency.median, latency.p99, idle);
+}
+
+void run(void) {
+
+    std::cout << "------------------------------" << std::endl;
+    std::cout << "-- THREAD POOL BENCHMARKS" << std::endl;
+    std::cout << "------------------------------" << std::endl;
+
+    printf("%u hardware threads\n", std::thread::hardware_concurrency());
+    printf("%-14s %10s %10s %10s %10s %9s\n", "", "flat/s", "tree/s", "lat p50us", "lat p99us", "idle CPU");
+    {
+        yielding::ThreadPool pool;
+        runAll("yielding", pool);
+    }
+    {
+        workstealing::ThreadPool pool;
+        runAll("work stealing", pool);
+        printf("work stealing submit with futures: %.0f tasks/s\n", futureThroughput(pool, 200000));
+    }
+}
+
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
 int main() {
 
     std::cout << "------------------------------" << std::endl;
     std::cout << "-- THREAD POOL" << std::endl;
     std::cout << "------------------------------" << std::endl;
 
-    ThreadPool pool;
+    {
+        workstealing::ThreadPool pool;
+        std::vector<std::future<int>> results;
+        for (int i = 0; i < 100; i++) {
+            results.push_back(pool.submit([=] {
+                std::cout << i << " printed by thread - " << std::this_thread::get_id() << std::endl;
+                return i * i;
+            }));
+        }
 
-    for (int i = 0; i < 100; i++) {
-        pool.submit([=]{
-            std::cout << i << " printed by thread - " << std::this_thread::get_id() << std::endl;
-        });
+        int sum = 0;
+        for (auto &result : results) {
+            sum += result.get();
+        }
+        std::cout << "sum of squares - " << sum << std::endl;
     }
 
-    std::this_thread::sleep_for(std::chrono::milliseconds(500));
-
-}
\ No newline at end of file
+    benchmarks::run();
+}
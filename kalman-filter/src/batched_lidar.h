@@ -0,0 +1,112 @@
+#ifndef INCLUDE_AKFSFSIM_BATCHED_LIDAR_H
+#define INCLUDE_AKFSFSIM_BATCHED_LIDAR_H
+
+#include <cmath>
+#include <vector>
+#include <Eigen/Dense>
+
+#include "beacons.h"
+#include "sensors.h"
+#include "utils.h"
+
+// Batched lidar update of the EKF filters (LidarUpdateMode::Batched). Targets that link one of them define
+// KALMAN_FILTER_BATCHED_LIDAR.
+
+// Maximum number of lidar returns stacked into one batched update. Larger scans are fused in several batches, which
+// keeps the stacked matrices on the stack.
+constexpr int LIDAR_BATCH_SIZE = 16;
+
+// Stacked measurement of up to MaxRows components. The storage is inline (Eigen's MaxRows), so stacking a scan and
+// updating with it does not allocate.
+template <int MaxRows> using StackedVector = Eigen::Matrix<double, Eigen::Dynamic, 1, 0, MaxRows, 1>;
+template <int MaxRows, int NX> using StackedMeasurementMatrix =
+    Eigen::Matrix<double, Eigen::Dynamic, NX, Eigen::RowMajor, MaxRows, NX>;
+
+// Kalman update of the state x and covariance P with a stacked innovation y, measurement Jacobian H and uncorrelated
+// measurement noise with variances r (the diagonal of a block-diagonal R).
+template <int NX, int MaxRows>
+void stackedUpdate(Eigen::Matrix<double, NX, 1>& x, Eigen::Matrix<double, NX, NX>& P,
+                   const StackedVector<MaxRows>& y, const StackedMeasurementMatrix<MaxRows, NX>& H,
+                   const StackedVector<MaxRows>& r)
+{
+    using StateMatrix = Eigen::Matrix<double, NX, NX>;
+
+    if (H.rows() <= NX)
+    {
+        using StackedMatrix = Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, 0, MaxRows, MaxRows>;
+        using StackedGainTranspose = Eigen::Matrix<double, Eigen::Dynamic, NX, 0, MaxRows, NX>;
+
+        const StackedGainTranspose HP = H * P;
+        StackedMatrix S = HP * H.transpose();
+        S.diagonal() += r;
+
+        // K = P H^T S^-1, computed as (S^-1 H P)^T since S is symmetric positive definite.
+        const StackedGainTranspose Kt = S.llt().solve(HP);
+        x += Kt.transpose() * y;
+        P -= Kt.transpose() * HP;
+    }
+    else
+    {
+        // With more measurement rows than states the information form is cheaper: it only factorises NX x NX
+        // matrices, and with a diagonal R, H^T R^-1 H is a weighted sum over the rows.
+        // P+ = (P^-1 + H^T R^-1 H)^-1 and x+ = x + P+ H^T R^-1 y.
+        const StackedVector<MaxRows> r_inv = r.cwiseInverse();
+        StateMatrix information = P.llt().solve(StateMatrix::Identity());
+        information.noalias() += H.transpose() * r_inv.asDiagonal() * H;
+        P = information.llt().solve(StateMatrix::Identity());
+        x += P * (H.transpose() * r_inv.cwiseProduct(y));
+    }
+}
+
+// Stacks the map-matched returns of a scan (still uncorrelated, so R is block diagonal) and runs one stackedUpdate per
+// batch, linearised about the same state. Uses the range/bearing model of the EKF filters, with the position in
+// states 0 and 1 and the heading in state heading_index. Returns without a matching map beacon are skipped.
+template <int NX>
+void batchedLidarUpdate(Eigen::Matrix<double, NX, 1>& x, Eigen::Matrix<double, NX, NX>& P,
+                        const std::vector<LidarMeasurement>& dataset, const BeaconMap& map,
+                        double range_std, double theta_std, int heading_index = 2)
+{
+    StackedVector<2*LIDAR_BATCH_SIZE> y, r;
+    StackedMeasurementMatrix<2*LIDAR_BATCH_SIZE, NX> H;
+    size_t next = 0;
+    while (next < dataset.size())
+    {
+        y.resize(2*LIDAR_BATCH_SIZE);
+        r.resize(2*LIDAR_BATCH_SIZE);
+        H.setZero(2*LIDAR_BATCH_SIZE, NX);
+
+        int count = 0;
+        for (; next < dataset.size() && count < LIDAR_BATCH_SIZE; ++next)
+        {
+            const LidarMeasurement& meas = dataset[next];
+            BeaconData map_beacon = map.getBeaconWithId(meas.id); // Match Beacon with Data Association Id
+            if (meas.id == -1 || map_beacon.id == -1) {continue;}
+
+            // Innovation and Sensitivity Rows of this Return (Same Model as handleLidarMeasurement)
+            double delta_x = map_beacon.x - x[0];
+            double delta_y = map_beacon.y - x[1];
+            double zhat_range = sqrt(delta_x*delta_x + delta_y*delta_y);
+            double zhat_theta = atan2(delta_y,delta_x) - x[heading_index];
+
+            const int row = 2*count;
+            y(row) = meas.range - zhat_range;
+            y(row+1) = wrapAngle(meas.theta - zhat_theta); // Wrap the Heading Innovation
+            r(row) = range_std*range_std;
+            r(row+1) = theta_std*theta_std;
+            H(row,0) = -delta_x/zhat_range;
+            H(row,1) = -delta_y/zhat_range;
+            H(row+1,0) = delta_y/zhat_range/zhat_range;
+            H(row+1,1) = -delta_x/zhat_range/zhat_range;
+            H(row+1,heading_index) = -1;
+            ++count;
+        }
+        if (count == 0) {break;}
+
+        y.conservativeResize(2*count);
+        r.conservativeResize(2*count);
+        H.conservativeResize(2*count, NX);
+        stackedUpdate(x, P, y, H, r);
+    }
+}
+
+#endif  // INCLUDE_AKFSFSIM_BATCHED_LIDAR_H
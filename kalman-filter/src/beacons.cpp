@@ -1,10 +1,11 @@
 #include "beacons.h"
 
+#include <algorithm>
 #include <cmath>
 #include <random>
-#include "display.h"
 
 BeaconMap::BeaconMap()
+:m_min_cell_x(0),m_max_cell_x(-1),m_min_cell_y(0),m_max_cell_y(-1)
 {
     std::mt19937 rand_gen;
     std::uniform_real_distribution<double> pos_dis(-500.0,500.0);
@@ -13,39 +14,126 @@ BeaconMap::BeaconMap()
 
 void BeaconMap::addBeacon(double x, double y)
 {
-    m_beacon_map.push_back(BeaconData(x,y,m_beacon_map.size()));
+    const int id = m_beacon_map.size();
+    m_beacon_map.push_back(BeaconData(x,y,id));
+
+    const int cell_x = cellCoordinate(x);
+    const int cell_y = cellCoordinate(y);
+    m_grid[cellKey(cell_x, cell_y)].push_back(id);
+    if (m_min_cell_x > m_max_cell_x)
+    {
+        m_min_cell_x = m_max_cell_x = cell_x;
+        m_min_cell_y = m_max_cell_y = cell_y;
+    }
+    else
+    {
+        m_min_cell_x = std::min(m_min_cell_x, cell_x);
+        m_max_cell_x = std::max(m_max_cell_x, cell_x);
+        m_min_cell_y = std::min(m_min_cell_y, cell_y);
+        m_max_cell_y = std::max(m_max_cell_y, cell_y);
+    }
 }
 
 BeaconData BeaconMap::getBeaconWithId(int id) const
 {
-    for (const BeaconData& beacon : m_beacon_map){if (beacon.id == id){return beacon;}}
+    // Beacon ids are their index in the map.
+    if (id >= 0 && id < static_cast<int>(m_beacon_map.size())){return m_beacon_map[id];}
     return BeaconData();
 }
 
 std::vector<BeaconData> BeaconMap::getBeaconsWithinRange(double x, double y, double range) const
 {
     std::vector<BeaconData> beacons;
-    for (const BeaconData& beacon : m_beacon_map)
+    getBeaconsWithinRange(x, y, range, beacons);
+    return beacons;
+}
+
+void BeaconMap::getBeaconsWithinRange(double x, double y, double range, std::vector<BeaconData>& beacons) const
+{
+    beacons.clear();
+    const double range_sq = range * range;
+    // Clamp to the occupied cells before converting, so a very large range can't overflow the cell coordinates.
+    const int cell_x_begin = std::max<double>(std::floor((x - range) / GRID_CELL_SIZE), m_min_cell_x);
+    const int cell_x_end = std::min<double>(std::floor((x + range) / GRID_CELL_SIZE), m_max_cell_x);
+    const int cell_y_begin = std::max<double>(std::floor((y - range) / GRID_CELL_SIZE), m_min_cell_y);
+    const int cell_y_end = std::min<double>(std::floor((y + range) / GRID_CELL_SIZE), m_max_cell_y);
+    for (int cell_x = cell_x_begin; cell_x <= cell_x_end; ++cell_x)
     {
-        double delta_x = beacon.x - x;
-        double delta_y = beacon.y - y;
-        double beacon_range = std::sqrt(delta_x*delta_x + delta_y*delta_y);
-        if (beacon_range < range)
+        for (int cell_y = cell_y_begin; cell_y <= cell_y_end; ++cell_y)
         {
-            beacons.push_back(beacon);
+            auto cell = m_grid.find(cellKey(cell_x, cell_y));
+            if (cell == m_grid.end()){continue;}
+            for (int id : cell->second)
+            {
+                const BeaconData& beacon = m_beacon_map[id];
+                double delta_x = beacon.x - x;
+                double delta_y = beacon.y - y;
+                if (delta_x*delta_x + delta_y*delta_y < range_sq){beacons.push_back(beacon);}
+            }
         }
     }
-    return beacons;
+    std::sort(beacons.begin(), beacons.end(), [](const BeaconData& a, const BeaconData& b){return a.id < b.id;});
+}
+
+BeaconData BeaconMap::getNearestBeacon(double x, double y, double max_range) const
+{
+    BeaconData nearest;
+    double nearest_sq = max_range * max_range;
+    if (m_beacon_map.empty()){return nearest;}
+
+    // Search rings of cells around the cell of (x,y), outwards. Every beacon in ring k+1 or beyond is at least 
+    // k cell sizes away, so stop once the nearest beacon found is closer than that, the rings pass max_range, or 
+    // they cover the whole grid.
+    const int centre_x = cellCoordinate(x);
+    const int centre_y = cellCoordinate(y);
+    const int max_ring = std::max({centre_x - m_min_cell_x, m_max_cell_x - centre_x, 
+                                   centre_y - m_min_cell_y, m_max_cell_y - centre_y});
+    for (int ring = 0; ring <= max_ring; ++ring)
+    {
+        for (int cell_x = centre_x - ring; cell_x <= centre_x + ring; ++cell_x)
+        {
+            // Interior rows of the ring only contribute their two edge cells.
+            const bool edge_column = (cell_x == centre_x - ring || cell_x == centre_x + ring);
+            const int step = edge_column ? 1 : 2 * ring;
+            for (int cell_y = centre_y - ring; cell_y <= centre_y + ring; cell_y += step)
+            {
+                auto cell = m_grid.find(cellKey(cell_x, cell_y));
+                if (cell == m_grid.end()){continue;}
+                for (int id : cell->second)
+                {
+                    const BeaconData& beacon = m_beacon_map[id];
+                    double delta_x = beacon.x - x;
+                    double delta_y = beacon.y - y;
+                    double beacon_sq = delta_x*delta_x + delta_y*delta_y;
+                    if (beacon_sq < nearest_sq){nearest = beacon; nearest_sq = beacon_sq;}
+                }
+            }
+        }
+
+        const double searched = ring * GRID_CELL_SIZE;
+        if ((nearest.id != -1 && nearest_sq <= searched * searched) || searched >= max_range){break;}
+    }
+    return nearest;
 }
 
-std::vector<BeaconData> BeaconMap::getBeacons() const
+void BeaconMap::getNearestBeacons(const std::vector<Vector2>& points, double max_range, 
+                                  std::vector<BeaconData>& nearest) const
+{
+    nearest.resize(points.size());
+    for (size_t i = 0; i < points.size(); ++i){nearest[i] = getNearestBeacon(points[i].x, points[i].y, max_range);}
+}
+
+const std::vector<BeaconData>& BeaconMap::getBeacons() const
 {
     return m_beacon_map;
 }
 
-void BeaconMap::render(Display& disp) const
+int BeaconMap::cellCoordinate(double position)
+{
+    return static_cast<int>(std::floor(position / GRID_CELL_SIZE));
+}
+
+std::int64_t BeaconMap::cellKey(int cell_x, int cell_y)
 {
-    const std::vector<Vector2> beacon_lines = {{1,0},{0,1},{0,-1},{1,0}};
-    disp.setDrawColour(255,255,0);
-    for (const auto& beacon : m_beacon_map){disp.drawLines(offsetPoints(beacon_lines, Vector2(beacon.x,beacon.y)));}
-}
\ No newline at end of file
+    return (static_cast<std::int64_t>(cell_x) << 32) | static_cast<std::uint32_t>(cell_y);
+}
@@ -1,8 +1,12 @@
 #ifndef INCLUDE_AKFSFSIM_BEACONS_H
 #define INCLUDE_AKFSFSIM_BEACONS_H
 
+#include <cstdint>
+#include <unordered_map>
 #include <vector>
 
+#include "utils.h"
+
 class Display;
 
 struct BeaconData
@@ -24,13 +28,34 @@ class BeaconMap
 
         BeaconData getBeaconWithId(int id) const;
         std::vector<BeaconData> getBeaconsWithinRange(double x, double y, double range) const;
-        std::vector<BeaconData> getBeacons() const;
+        const std::vector<BeaconData>& getBeacons() const;
+
+        // Writes the beacons closer than range to (x,y) into beacons (which is cleared first), in id order. Only the 
+        // grid cells overlapping the query circle are visited, so the cost depends on the beacon density rather than
+        // the size of the map, and reusing the buffer avoids allocating per query.
+        void getBeaconsWithinRange(double x, double y, double range, std::vector<BeaconData>& beacons) const;
+
+        // Nearest beacon to (x,y) that is closer than max_range, or a beacon with id -1 if there is none.
+        BeaconData getNearestBeacon(double x, double y, double max_range) const;
+
+        // Nearest neighbour association of a set of points (e.g. lidar returns projected into the map frame): 
+        // nearest[i] is getNearestBeacon() of points[i].
+        void getNearestBeacons(const std::vector<Vector2>& points, double max_range, 
+                               std::vector<BeaconData>& nearest) const;
 
         void render(Display& disp) const;
 
     private:
 
+        // Uniform grid over the map, keyed by the packed integer cell coordinates. Each cell holds the ids of its 
+        // beacons, so the index is updated in place as beacons are added.
+        static constexpr double GRID_CELL_SIZE = 50.0;
+        static int cellCoordinate(double position);
+        static std::int64_t cellKey(int cell_x, int cell_y);
+
         std::vector<BeaconData> m_beacon_map;    
+        std::unordered_map<std::int64_t, std::vector<int>> m_grid;
+        int m_min_cell_x, m_max_cell_x, m_min_cell_y, m_max_cell_y;
 };
 
 
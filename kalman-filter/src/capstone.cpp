@@ -49,11 +49,9 @@ static constexpr double GPS_POS_STD = 3.0;
 static constexpr double LIDAR_RANGE_STD = 3.0;
 static constexpr double LIDAR_THETA_STD = 0.02;
 static constexpr double BIAS_STD = 0.005/180.0 * M_PI;
-static constexpr size_t NX = 5;
-static constexpr size_t NW = 3;
-static constexpr size_t NZ_LIDAR = 2;
-
-static VectorXd sInitialState = VectorXd::Zero(NX);
+static constexpr int NX = 5;
+static constexpr int NW = 3;
+static constexpr int NZ_LIDAR = 2;
 
 ///////////////////////////////////////////////////////////////////////////////
 // KALMAN FILTER CLASS FUNCTIONS
@@ -63,8 +61,8 @@ void KalmanFilter::handleLidarMeasurement(LidarMeasurement meas, const BeaconMap
 {
     if (isInitialised())
     {
-        VectorXd state = getState();
-        MatrixXd cov = getCovariance();
+        StateVector& state = mutableState();
+        CovarianceMatrix& cov = mutableCovariance();
 
         // Implement The Kalman Filter Update Step for the Lidar Measurements in the section below
         // HINT: Use the normaliseState() and normaliseLidarMeasurement() functions to always keep angle values within 
@@ -79,34 +77,26 @@ void KalmanFilter::handleLidarMeasurement(LidarMeasurement meas, const BeaconMap
         if (meas.id != -1 && map_beacon.id != -1) // Check that we have a valid beacon match
         {
             // Augmentation of state and covariance.
-            const size_t na = NX + NZ_LIDAR;
+            using AugSigmaPoints = SigmaPoints<NX + NZ_LIDAR>;
 
-            VectorXd augState = VectorXd::Zero(na);
-            augState.head(NX) = state;
+            AugSigmaPoints::Vector augState = AugSigmaPoints::Vector::Zero();
+            augState.head<NX>() = state;
 
-            MatrixXd augCov = MatrixXd::Zero(na, na);
-            augCov.topLeftCorner(NX, NX) = cov;
+            AugSigmaPoints::Matrix augCov = AugSigmaPoints::Matrix::Zero();
+            augCov.topLeftCorner<NX, NX>() = cov;
             augCov(NX, NX) = LIDAR_RANGE_STD * LIDAR_RANGE_STD;
             augCov(NX + 1, NX + 1) = LIDAR_THETA_STD * LIDAR_THETA_STD;
 
-            // Generate sigma points and weights.
-            auto sigmaPoints = generateSigmaPoints(augState, augCov);
-            auto weights = generateSigmaWeights(na);
+            // Generate sigma points.
+            AugSigmaPoints sigmaPoints;
+            sigmaPoints.generate(augState, augCov);
 
             // Transform sigma points using lidar model.
-            std::vector<Vector2d> transformedPoints;
-            transformedPoints.push_back(lidarMeasurementModel(sigmaPoints[0], map_beacon.x, map_beacon.y, 
-                std::nullopt));
-            for (size_t i = 1; i < sigmaPoints.size(); i++) {
-                transformedPoints.push_back(lidarMeasurementModel(sigmaPoints[i], map_beacon.x, map_beacon.y, 
-                    transformedPoints[0](1)));
-            }
+            AugSigmaPoints::TransformedPoints<NZ_LIDAR> transformedPoints = 
+                lidarMeasurementModel(sigmaPoints.points(), map_beacon.x, map_beacon.y);
 
             // Calculate the mean of the transformed sigma points
-            Vector2d zhat = Vector2d::Zero();
-            for (size_t i = 0; i < transformedPoints.size(); i++) {
-                zhat += weights[i] * transformedPoints[i];
-            }
+            Vector2d zhat = AugSigmaPoints::mean(transformedPoints);
             
             // Calculate the innovation.
             Vector2d z = Vector2d::Zero();
@@ -114,34 +104,25 @@ void KalmanFilter::handleLidarMeasurement(LidarMeasurement meas, const BeaconMap
             Vector2d innovation = normaliseLidarMeasurement(z - zhat);
 
             // Calculate the covariance of the transformed signal.
-            Matrix2d innovationcov = Matrix2d::Zero();
-            for (size_t i = 0; i < transformedPoints.size(); i++) {
-                Vector2d err = normaliseLidarMeasurement(transformedPoints[i] - zhat);
-                innovationcov += weights[i] * err * err.transpose();
-            }
+            AugSigmaPoints::TransformedPoints<NZ_LIDAR> errz = 
+                normaliseLidarMeasurement(transformedPoints.colwise() - zhat);
+            Matrix2d innovationcov = AugSigmaPoints::covariance(errz, errz);
 
             // Calculate the cross covariance
-            using CrossCovMatrix = Eigen::Matrix<double, NX, NZ_LIDAR>;
-            CrossCovMatrix crosscov = CrossCovMatrix::Zero();
-            for (size_t i = 0; i < transformedPoints.size(); i++) {
-                Vector2d errz = normaliseLidarMeasurement(transformedPoints[i] - zhat);
-                VectorXd errx = normaliseState(sigmaPoints[i].head(NX) - state);
-                crosscov += weights[i] * errx * errz.transpose();
-            }
+            AugSigmaPoints::TransformedPoints<NX> errx = 
+                normaliseState(sigmaPoints.points().topRows<NX>().colwise() - state);
+            GainMatrix<NZ_LIDAR> crosscov = AugSigmaPoints::covariance(errx, errz);
 
             // UKF update step equations.
             // TODO: There is an issue with the lidar measurement, it is giving a positive velocity when in fact the 
             // vehicle is moving backward. I feel the cross-covariance of row(3) and row(4) (zero based) has the wrong
             // sign or should be zero since the lidar model doesn't use them.
             
-            MatrixXd kalmanGain = crosscov * innovationcov.inverse();
+            GainMatrix<NZ_LIDAR> kalmanGain = crosscov * innovationcov.inverse();
             state += kalmanGain * innovation;
             cov -= kalmanGain * innovationcov * kalmanGain.transpose();
         }
 
-        setState(state);
-        setCovariance(cov);
-
     }
 }
 
@@ -149,8 +130,8 @@ void KalmanFilter::predictionStep(GyroMeasurement gyro, double dt)
 {
     if (isInitialised()) {
         
-        VectorXd state = getState();
-        MatrixXd cov = getCovariance();
+        StateVector& state = mutableState();
+        CovarianceMatrix& cov = mutableCovariance();
 
         // Implement The Kalman Filter Prediction Step for the system in the section below.
         // HINT: Assume the state vector has the form [PX, PY, PSI, V, BIAS].
@@ -159,40 +140,27 @@ void KalmanFilter::predictionStep(GyroMeasurement gyro, double dt)
         // HINT: Use the normaliseState() function to always keep angle values within correct range.
         // HINT: Do NOT normalise during sigma point calculation!
 
-        size_t na = NX + NW;
+        using AugSigmaPoints = SigmaPoints<NX + NW>;
 
-        VectorXd augState = VectorXd::Zero(na);
-        augState.head(NX) = state;
+        AugSigmaPoints::Vector augState = AugSigmaPoints::Vector::Zero();
+        augState.head<NX>() = state;
 
-        MatrixXd covAug = MatrixXd::Zero(na, na);
-        covAug.topLeftCorner(NX, NX) = cov;
+        AugSigmaPoints::Matrix covAug = AugSigmaPoints::Matrix::Zero();
+        covAug.topLeftCorner<NX, NX>() = cov;
         covAug(NX + 0, NX + 0) =  GYRO_STD * GYRO_STD;
         covAug(NX + 1, NX + 1) =  ACCEL_STD * ACCEL_STD;
         covAug(NX + 2, NX + 2) =  BIAS_STD * BIAS_STD;
 
-        auto sigmaPoints = generateSigmaPoints(augState, covAug);
-        auto weights = generateSigmaWeights(na);
+        AugSigmaPoints sigmaPoints;
+        sigmaPoints.generate(augState, covAug);
 
-        std::vector<VectorXd> transformedPoints;
-        std::transform(sigmaPoints.begin(), sigmaPoints.end(), std::back_inserter(transformedPoints), 
-            [=](const auto &p) {
-                return vehicleProcessModel(p, gyro.psi_dot, dt);
-            }
-        );
+        AugSigmaPoints::TransformedPoints<NX> transformedPoints = 
+            vehicleProcessModel(sigmaPoints.points(), gyro.psi_dot, dt);
         
-        state = VectorXd::Zero(NX);
-        for (size_t i = 0; i < transformedPoints.size(); i++) {
-            state = state + weights[i] * transformedPoints[i];
-        }
-
-        cov = MatrixXd::Zero(NX, NX);
-        for (size_t i = 0; i < transformedPoints.size(); i++) {
-            VectorXd err = normaliseState(transformedPoints[i] - state);
-            cov = cov + weights[i] * err * err.transpose();
-        }
+        state = AugSigmaPoints::mean(transformedPoints);
 
-        setState(state);
-        setCovariance(cov);
+        AugSigmaPoints::TransformedPoints<NX> err = normaliseState(transformedPoints.colwise() - state);
+        cov = AugSigmaPoints::covariance(err, err);
 
     }
 }
@@ -204,45 +172,43 @@ void KalmanFilter::handleGPSMeasurement(GPSMeasurement meas)
     // so the UKF update state would just produce the same result.
     if(isInitialised())
     {
-        VectorXd state = getState();
-        MatrixXd cov = getCovariance();
+        StateVector& state = mutableState();
+        CovarianceMatrix& cov = mutableCovariance();
 
-        VectorXd z = Vector2d::Zero();
-        MatrixXd H = MatrixXd(2, NX);
-        MatrixXd R = Matrix2d::Zero();
+        Vector2d z = Vector2d::Zero();
+        MeasurementMatrix<2> H;
+        Matrix2d R = Matrix2d::Zero();
 
         z << meas.x, meas.y;
         H << 1.0, 0.0, 0.0, 0.0, 0.0, 0.0, 1.0, 0.0, 0.0, 0.0;
         R(0, 0) = GPS_POS_STD * GPS_POS_STD;
         R(1, 1) = GPS_POS_STD * GPS_POS_STD;
 
-        VectorXd z_hat = H * state;
-        VectorXd y = z - z_hat;
-        MatrixXd S = H * cov * H.transpose() + R;
-        MatrixXd K = cov*H.transpose()*S.inverse();
+        Vector2d z_hat = H * state;
+        Vector2d y = z - z_hat;
+        Matrix2d S = H * cov * H.transpose() + R;
+        GainMatrix<2> K = cov*H.transpose()*S.inverse();
 
         // Innovation check
-        VectorXd NIS = y.transpose()*S.inverse()*y;
-        if (NIS(0) < 5.99) {
+        double NIS = y.dot(S.inverse()*y);
+        if (NIS < 5.99) {
             state = state + K*y;
-            cov = (MatrixXd::Identity(NX, NX) - K*H) * cov;
+            cov = (StateMatrix::Identity() - K*H) * cov;
         } else {
-            std::cout << "GPS NIS Failed! " << NIS(0) << std::endl;
+            std::cout << "GPS NIS Failed! " << NIS << std::endl;
         }
 
-        setState(state);
-        setCovariance(cov);
-
     } else {
 
         // TODO: Determine initial states from measurements.
-        MatrixXd cov = MatrixXd::Zero(NX, NX);
+        StateVector initialState = StateVector::Zero();
+        CovarianceMatrix cov = CovarianceMatrix::Zero();
 
-        sInitialState(0) = meas.x;
-        sInitialState(1) = meas.y;
-        sInitialState(2) = -M_PI / 2.0;
-        sInitialState(3) = -2.0;
-        sInitialState(4) = 0.0;
+        initialState(0) = meas.x;
+        initialState(1) = meas.y;
+        initialState(2) = -M_PI / 2.0;
+        initialState(3) = -2.0;
+        initialState(4) = 0.0;
 
         cov(0, 0) = GPS_POS_STD*GPS_POS_STD;
         cov(1, 1) = GPS_POS_STD*GPS_POS_STD;
@@ -250,18 +216,22 @@ void KalmanFilter::handleGPSMeasurement(GPSMeasurement meas)
         cov(3, 3) = INIT_VEL_STD*INIT_VEL_STD;
         cov(4, 4) = BIAS_STD*BIAS_STD;
 
-        std::cout << "Initial posX (m): " << sInitialState(0) << std::endl;
-        std::cout << "Initial posY (m): " << sInitialState(1) << std::endl;
-        std::cout << "Initial angle (deg): " << sInitialState(2) * 180.0 / M_PI << std::endl;
-        std::cout << "Initial velocity (m/s): " << sInitialState(3) << std::endl;
-        std::cout << "Initial Bias (m/s): " << sInitialState(4) << std::endl;
+        std::cout << "Initial posX (m): " << initialState(0) << std::endl;
+        std::cout << "Initial posY (m): " << initialState(1) << std::endl;
+        std::cout << "Initial angle (deg): " << initialState(2) * 180.0 / M_PI << std::endl;
+        std::cout << "Initial velocity (m/s): " << initialState(3) << std::endl;
+        std::cout << "Initial Bias (m/s): " << initialState(4) << std::endl;
 
-        setState(sInitialState);
+        setState(initialState);
         setCovariance(cov);
     }             
 }
 
-void KalmanFilter::handleLidarMeasurements(const std::vector<LidarMeasurement> &dataset, const BeaconMap &map) {
+void KalmanFilter::handleLidarMeasurements(const std::vector<LidarMeasurement> &measurements, const BeaconMap &map) {
+    // Match returns without a beacon id to the map.
+    const std::vector<LidarMeasurement> &dataset = 
+        associateLidarMeasurements(measurements, map, LIDAR_RANGE_STD, LIDAR_THETA_STD);
+
     // Assume No Correlation between the Measurements and Update Sequentially
     for (const auto &meas : dataset) {
         handleLidarMeasurement(meas, map);
@@ -270,7 +240,7 @@ void KalmanFilter::handleLidarMeasurements(const std::vector<LidarMeasurement> &
 
 Matrix2d KalmanFilter::getVehicleStatePositionCovariance() {
     Matrix2d pos_cov = Matrix2d::Zero();
-    MatrixXd cov = getCovariance();
+    const CovarianceMatrix& cov = getCovariance();
     if (isInitialised() && cov.size() != 0) {
         pos_cov << cov(0, 0), cov(0, 1), cov(1, 0), cov(1, 1);
     }
@@ -280,7 +250,7 @@ Matrix2d KalmanFilter::getVehicleStatePositionCovariance() {
 
 VehicleState KalmanFilter::getVehicleState() {
     if (isInitialised()) {
-        VectorXd state = getState(); // STATE VECTOR [X,Y,PSI,V,BIAS]
+        const StateVector& state = getState(); // STATE VECTOR [X,Y,PSI,V,BIAS]
         return VehicleState(state[0], state[1], state[2], state[3]);
     }
     return VehicleState();
@@ -3,9 +3,11 @@
 
 #include <queue>
 #include <cmath>
-#include "display.h"
+#include <vector>
 #include "utils.h"
 
+class Display;
+
 struct VehicleState
 {
     double x,y,psi,V;
@@ -201,22 +203,7 @@ class Car
             return true;
         }
 
-        void render(Display& disp)
-        {
-            double steeringPsi = m_vehicle_model.getVehicleState().steering;
-            double carPsiOffset = m_vehicle_model.getVehicleState().psi;
-            Vector2 carPosOffset = Vector2(m_vehicle_model.getVehicleState().x, m_vehicle_model.getVehicleState().y);
-            
-            disp.setDrawColour(0,255,0);
-            disp.drawLines(transformPoints(m_car_lines_body, carPosOffset, carPsiOffset));
-            disp.drawLines(transformPoints(m_marker_lines, carPosOffset, carPsiOffset));
-
-            disp.setDrawColour(0,201,0);
-            disp.drawLines(transformPoints(transformPoints(m_wheel_lines, m_wheel_fl_offset, steeringPsi), carPosOffset, carPsiOffset));
-            disp.drawLines(transformPoints(transformPoints(m_wheel_lines, m_wheel_fr_offset, steeringPsi), carPosOffset, carPsiOffset));
-            disp.drawLines(transformPoints(offsetPoints(m_wheel_lines, m_wheel_rl_offset), carPosOffset, carPsiOffset));
-            disp.drawLines(transformPoints(offsetPoints(m_wheel_lines, m_wheel_rr_offset), carPosOffset, carPsiOffset));
-        }
+        void render(Display& disp);
 
     private:
 
@@ -0,0 +1,251 @@
+#include "data_association.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+
+#include "utils.h"
+
+// Cost of a return-beacon pair that failed the gate. Finite so the assignment arithmetic stays well defined; any
+// return can always fall back to being unassigned at the (much lower) gate cost.
+static constexpr double BLOCKED_COST = 1e9;
+
+void LidarDataAssociation::associate(std::vector<LidarMeasurement>& returns, const BeaconMap& map, 
+                                     const Eigen::Vector3d& pose, const Eigen::Matrix3d& pose_cov, 
+                                     double range_std, double theta_std)
+{
+    for (LidarMeasurement& meas : returns){meas.id = -1;}
+    if (returns.empty()){return;}
+
+    const int num_returns = returns.size();
+    const std::vector<BeaconData>& beacons = map.getBeacons();
+    m_beacon_index.resize(beacons.size(), -1);
+    m_beacon_ids.clear();
+    m_edges.clear();
+
+    Eigen::Matrix2d R = Eigen::Matrix2d::Zero();
+    R(0,0) = range_std * range_std;
+    R(1,1) = theta_std * theta_std;
+
+    // Spread of a projected return in the map frame, used to find the beacons worth testing against the gate.
+    const double gate_sigma = std::sqrt(m_gate);
+    const double position_std = std::sqrt(pose_cov(0,0) + pose_cov(1,1));
+    const double heading_std = std::sqrt(pose_cov(2,2));
+
+    for (int i = 0; i < num_returns; ++i)
+    {
+        const LidarMeasurement& meas = returns[i];
+        const double bearing = pose(2) + meas.theta;
+        const double point_x = pose(0) + meas.range * std::cos(bearing);
+        const double point_y = pose(1) + meas.range * std::sin(bearing);
+        const double radius = gate_sigma * (position_std + meas.range * (heading_std + theta_std) + range_std);
+        map.getBeaconsWithinRange(point_x, point_y, radius, m_candidates);
+
+        for (const BeaconData& beacon : m_candidates)
+        {
+            // Range-bearing innovation and its covariance for this pairing (same model as the EKF update).
+            const double delta_x = beacon.x - pose(0);
+            const double delta_y = beacon.y - pose(1);
+            const double range_sq = delta_x*delta_x + delta_y*delta_y;
+            const double range = std::sqrt(range_sq);
+            if (range <= 0.0){continue;}
+
+            Eigen::Matrix<double, 2, 3> H;
+            H << -delta_x/range, -delta_y/range, 0,
+                  delta_y/range_sq, -delta_x/range_sq, -1;
+            const Eigen::Matrix2d S = H * pose_cov * H.transpose() + R;
+            Eigen::Vector2d y;
+            y << meas.range - range, wrapAngle(meas.theta - (std::atan2(delta_y, delta_x) - pose(2)));
+            const double nis = y.dot(S.inverse() * y);
+            if (nis > m_gate){continue;}
+
+            int& index = m_beacon_index[beacon.id];
+            if (index == -1)
+            {
+                index = m_beacon_ids.size();
+                m_beacon_ids.push_back(beacon.id);
+            }
+            m_edges.push_back(Edge{i, index, nis});
+        }
+    }
+    if (m_edges.empty()){return;}
+
+    // Cluster the returns that compete for beacons, then solve each cluster on its own.
+    const int num_nodes = num_returns + m_beacon_ids.size();
+    m_parent.resize(num_nodes);
+    for (int node = 0; node < num_nodes; ++node){m_parent[node] = node;}
+    for (const Edge& edge : m_edges)
+    {
+        const int a = findRoot(edge.meas);
+        const int b = findRoot(num_returns + edge.beacon);
+        if (a != b){m_parent[a] = b;}
+    }
+
+    for (int node = 0; node < num_nodes; ++node){m_parent[node] = findRoot(node);}
+    m_cluster_edges.resize(m_edges.size());
+    for (size_t e = 0; e < m_edges.size(); ++e){m_cluster_edges[e] = e;}
+    std::sort(m_cluster_edges.begin(), m_cluster_edges.end(), [this](int a, int b)
+    {
+        return m_parent[m_edges[a].meas] < m_parent[m_edges[b].meas];
+    });
+
+    m_row_index.assign(num_returns, -1);
+    m_col_index.assign(m_beacon_ids.size(), -1);
+    size_t begin = 0;
+    while (begin < m_cluster_edges.size())
+    {
+        const int root = m_parent[m_edges[m_cluster_edges[begin]].meas];
+        size_t end = begin + 1;
+        while (end < m_cluster_edges.size() && m_parent[m_edges[m_cluster_edges[end]].meas] == root){++end;}
+        solveCluster(returns, m_cluster_edges.data() + begin, end - begin);
+        begin = end;
+    }
+
+    // Only the candidate entries were set, so clearing them keeps the next scan independent of the map size.
+    for (int id : m_beacon_ids){m_beacon_index[id] = -1;}
+}
+
+bool LidarDataAssociation::estimateHeading(const std::vector<LidarMeasurement>& returns, const BeaconMap& map, 
+                                           double x, double y, double position_std, double range_std, 
+                                           double& heading, double& heading_std)
+{
+    constexpr int NUM_BINS = 180;
+    constexpr double BIN_WIDTH = 2.0 * M_PI / NUM_BINS;
+    constexpr int MIN_VOTES = 3;
+
+    // Histogram of the candidate headings, remembering the votes themselves for the refinement.
+    std::array<int, NUM_BINS> histogram{};
+    m_votes.clear();
+    const double range_tolerance = 3.0 * std::sqrt(position_std * position_std + range_std * range_std);
+    for (const LidarMeasurement& meas : returns)
+    {
+        map.getBeaconsWithinRange(x, y, meas.range + range_tolerance, m_candidates);
+        for (const BeaconData& beacon : m_candidates)
+        {
+            const double delta_x = beacon.x - x;
+            const double delta_y = beacon.y - y;
+            if (std::abs(std::sqrt(delta_x*delta_x + delta_y*delta_y) - meas.range) > range_tolerance){continue;}
+            const double vote = wrapAngle(std::atan2(delta_y, delta_x) - meas.theta);
+            m_votes.push_back(vote);
+            histogram[static_cast<int>((vote + M_PI) / BIN_WIDTH) % NUM_BINS]++;
+        }
+    }
+
+    // Densest window of three neighbouring bins.
+    int best_bin = 0;
+    int best_votes = 0;
+    for (int bin = 0; bin < NUM_BINS; ++bin)
+    {
+        const int votes = histogram[(bin + NUM_BINS - 1) % NUM_BINS] + histogram[bin] + histogram[(bin + 1) % NUM_BINS];
+        if (votes > best_votes){best_votes = votes; best_bin = bin;}
+    }
+    if (best_votes < MIN_VOTES){return false;}
+
+    // Refine with the circular mean and spread of the votes in the window.
+    const double centre = -M_PI + (best_bin + 0.5) * BIN_WIDTH;
+    double sum = 0.0, sum_sq = 0.0;
+    int count = 0;
+    for (double vote : m_votes)
+    {
+        const double offset = wrapAngle(vote - centre);
+        if (std::abs(offset) > 1.5 * BIN_WIDTH){continue;}
+        sum += offset;
+        sum_sq += offset * offset;
+        ++count;
+    }
+    const double mean = sum / count;
+    heading = wrapAngle(centre + mean);
+    heading_std = std::sqrt(std::max(sum_sq / count - mean * mean, 0.0));
+    return true;
+}
+
+int LidarDataAssociation::findRoot(int node)
+{
+    while (m_parent[node] != node)
+    {
+        m_parent[node] = m_parent[m_parent[node]];
+        node = m_parent[node];
+    }
+    return node;
+}
+
+void LidarDataAssociation::solveCluster(std::vector<LidarMeasurement>& returns, const int* edges, int num_edges)
+{
+    m_rows.clear();
+    m_cols.clear();
+    for (int e = 0; e < num_edges; ++e)
+    {
+        const Edge& edge = m_edges[edges[e]];
+        if (m_row_index[edge.meas] == -1){m_row_index[edge.meas] = m_rows.size(); m_rows.push_back(edge.meas);}
+        if (m_col_index[edge.beacon] == -1){m_col_index[edge.beacon] = m_cols.size(); m_cols.push_back(edge.beacon);}
+    }
+
+    // Cost matrix of n returns against m beacons plus n "unassigned" columns that each cost the gate.
+    const int n = m_rows.size();
+    const int m = m_cols.size() + n;
+    m_cost.assign(n * m, BLOCKED_COST);
+    for (int row = 0; row < n; ++row)
+    {
+        std::fill(m_cost.begin() + row * m + m_cols.size(), m_cost.begin() + (row + 1) * m, m_gate);
+    }
+    for (int e = 0; e < num_edges; ++e)
+    {
+        const Edge& edge = m_edges[edges[e]];
+        m_cost[m_row_index[edge.meas] * m + m_col_index[edge.beacon]] = edge.cost;
+    }
+
+    // Hungarian algorithm (shortest augmenting paths with potentials), rows and columns 1-based with column 0 as the 
+    // virtual start. m_match[col] is the row assigned to col.
+    const double inf = std::numeric_limits<double>::infinity();
+    m_u.assign(n + 1, 0.0);
+    m_v.assign(m + 1, 0.0);
+    m_match.assign(m + 1, 0);
+    m_way.assign(m + 1, 0);
+    for (int row = 1; row <= n; ++row)
+    {
+        m_match[0] = row;
+        int col0 = 0;
+        m_minv.assign(m + 1, inf);
+        m_used.assign(m + 1, false);
+        do
+        {
+            m_used[col0] = true;
+            const int row0 = m_match[col0];
+            double delta = inf;
+            int col1 = 0;
+            for (int col = 1; col <= m; ++col)
+            {
+                if (m_used[col]){continue;}
+                const double cur = m_cost[(row0 - 1) * m + (col - 1)] - m_u[row0] - m_v[col];
+                if (cur < m_minv[col]){m_minv[col] = cur; m_way[col] = col0;}
+                if (m_minv[col] < delta){delta = m_minv[col]; col1 = col;}
+            }
+            for (int col = 0; col <= m; ++col)
+            {
+                if (m_used[col]){m_u[m_match[col]] += delta; m_v[col] -= delta;}
+                else {m_minv[col] -= delta;}
+            }
+            col0 = col1;
+        } while (m_match[col0] != 0);
+        do
+        {
+            const int col1 = m_way[col0];
+            m_match[col0] = m_match[col1];
+            col0 = col1;
+        } while (col0 != 0);
+    }
+
+    for (int col = 1; col <= static_cast<int>(m_cols.size()); ++col)
+    {
+        const int row = m_match[col];
+        if (row != 0 && m_cost[(row - 1) * m + (col - 1)] < BLOCKED_COST)
+        {
+            returns[m_rows[row - 1]].id = m_beacon_ids[m_cols[col - 1]];
+        }
+    }
+
+    // Leave the index maps clean for the next cluster.
+    for (int meas : m_rows){m_row_index[meas] = -1;}
+    for (int beacon : m_cols){m_col_index[beacon] = -1;}
+}
@@ -0,0 +1,75 @@
+#ifndef INCLUDE_AKFSFSIM_DATA_ASSOCIATION_H
+#define INCLUDE_AKFSFSIM_DATA_ASSOCIATION_H
+
+#include <vector>
+#include <Eigen/Dense>
+
+#include "beacons.h"
+#include "sensors.h"
+
+// Global nearest neighbour (GNN) association of unlabelled lidar returns to map beacons.
+//
+// Each return is projected into the map with the estimated pose and only the beacons near that point are considered
+// (a grid query on the BeaconMap). Those candidates are gated on the normalised innovation squared (NIS) of the
+// range-bearing measurement, using the pose covariance and the lidar noise. The gated pairs are split into
+// independent clusters (returns that compete for the same beacons), and each cluster is solved jointly as a
+// minimum-NIS assignment with the Hungarian algorithm, where leaving a return unassigned costs the gate threshold.
+// Clusters are usually a handful of returns, so the cost stays close to linear in the number of returns per scan.
+//
+// All working buffers are members and reused between scans, so only a scan larger than any before it allocates.
+class LidarDataAssociation
+{
+    public:
+
+        // Chi-square 99% threshold for 2 degrees of freedom.
+        static constexpr double DEFAULT_GATE = 9.21;
+
+        LidarDataAssociation():m_gate(DEFAULT_GATE){}
+
+        void setGate(double gate){m_gate = gate;}
+        double getGate() const {return m_gate;}
+
+        // Sets the id of every return to its associated beacon, or -1 if it could not be associated. pose is the
+        // estimated [X, Y, PSI] of the vehicle and pose_cov its covariance.
+        void associate(std::vector<LidarMeasurement>& returns, const BeaconMap& map, const Eigen::Vector3d& pose,
+                       const Eigen::Matrix3d& pose_cov, double range_std, double theta_std);
+
+        // Estimates the vehicle heading from unlabelled returns when only the position is known (e.g. while the 
+        // filter initialises from GPS). Every beacon at a distance consistent with the range of a return votes for the
+        // heading that would put it at the measured bearing, and the densest cluster of votes wins. Returns false if 
+        // fewer than three votes agree; otherwise sets heading and heading_std (the spread of the agreeing votes).
+        bool estimateHeading(const std::vector<LidarMeasurement>& returns, const BeaconMap& map, double x, double y,
+                             double position_std, double range_std, double& heading, double& heading_std);
+
+    private:
+
+        struct Edge
+        {
+            int meas;
+            int beacon;     // Index into m_beacon_ids
+            double cost;    // NIS of the pair
+        };
+
+        int findRoot(int node);
+        void solveCluster(std::vector<LidarMeasurement>& returns, const int* edges, int num_edges);
+
+        double m_gate;
+
+        std::vector<BeaconData> m_candidates;
+        std::vector<double> m_votes;
+        std::vector<Edge> m_edges;
+        std::vector<int> m_beacon_index;    // Map beacon id -> index into m_beacon_ids, -1 if not a candidate
+        std::vector<int> m_beacon_ids;
+        std::vector<int> m_parent;          // Union-find over returns [0, n) and beacons [n, n + m)
+        std::vector<int> m_cluster_edges;   // Edge indices sorted by cluster
+
+        // Cluster scratch space for the assignment.
+        std::vector<int> m_row_index, m_col_index;
+        std::vector<int> m_rows, m_cols;
+        std::vector<double> m_cost;
+        std::vector<double> m_u, m_v, m_minv;
+        std::vector<int> m_match, m_way;
+        std::vector<char> m_used;
+};
+
+#endif  // INCLUDE_AKFSFSIM_DATA_ASSOCIATION_H
@@ -0,0 +1,216 @@
+#include "filter_bank.h"
+
+#include <cmath>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "utils.h"
+
+// Same constants as the EKF answer.
+constexpr double ACCEL_STD = 1.0;
+constexpr double GYRO_STD = 0.01/180.0 * M_PI;
+constexpr double INIT_VEL_STD = 10.0;
+constexpr double INIT_PSI_STD = 45.0/180.0 * M_PI;
+constexpr double GPS_POS_STD = 3.0;
+constexpr double LIDAR_RANGE_STD = 3.0;
+constexpr double LIDAR_THETA_STD = 0.02;
+
+// Below this many vehicles the prediction loop isn't worth splitting across threads.
+constexpr std::size_t PARALLEL_MIN_VEHICLES = 4096;
+
+void FilterBank::resize(std::size_t num_vehicles)
+{
+    for (auto& component : m_state){component.assign(num_vehicles, 0.0);}
+    for (auto& entry : m_cov){entry.assign(num_vehicles, 0.0);}
+    m_initialised.assign(num_vehicles, 0);
+}
+
+void FilterBank::reset(){resize(size());}
+
+void FilterBank::predictionStep(const std::vector<GyroMeasurement>& gyro, double dt)
+{
+    const std::size_t num_vehicles = size();
+#ifdef _OPENMP
+    if (num_vehicles >= PARALLEL_MIN_VEHICLES)
+    {
+        // Contiguous blocks per thread, so each thread streams through its own part of every array.
+        #pragma omp parallel
+        {
+            const std::size_t num_threads = omp_get_num_threads();
+            const std::size_t thread = omp_get_thread_num();
+            const std::size_t begin = num_vehicles * thread / num_threads;
+            predictRange(begin, num_vehicles * (thread + 1) / num_threads, gyro.data() + begin, dt);
+        }
+        return;
+    }
+#endif
+    predictRange(0, num_vehicles, gyro.data(), dt);
+}
+
+void FilterBank::predictionStep(std::size_t index, GyroMeasurement gyro, double dt)
+{
+    predictRange(index, index + 1, &gyro, dt);
+}
+
+void FilterBank::predictRange(std::size_t begin, std::size_t end, const GyroMeasurement* gyro, double dt)
+{
+    double* __restrict x = m_state[0].data();
+    double* __restrict y = m_state[1].data();
+    double* __restrict psi = m_state[2].data();
+    double* __restrict V = m_state[3].data();
+    double* __restrict p00 = m_cov[P00].data();
+    double* __restrict p01 = m_cov[P01].data();
+    double* __restrict p02 = m_cov[P02].data();
+    double* __restrict p03 = m_cov[P03].data();
+    double* __restrict p11 = m_cov[P11].data();
+    double* __restrict p12 = m_cov[P12].data();
+    double* __restrict p13 = m_cov[P13].data();
+    double* __restrict p22 = m_cov[P22].data();
+    double* __restrict p23 = m_cov[P23].data();
+    double* __restrict p33 = m_cov[P33].data();
+    const double q22 = dt*dt*GYRO_STD*GYRO_STD;
+    const double q33 = dt*dt*ACCEL_STD*ACCEL_STD;
+
+    // Uninitialised slots are predicted too (their state and covariance are overwritten when they initialise), so
+    // the loop has no branches.
+    #pragma omp simd
+    for (std::size_t i = begin; i < end; ++i)
+    {
+        const double sin_psi = std::sin(psi[i]);
+        const double cos_psi = std::cos(psi[i]);
+
+        // F = [1 0 a b; 0 1 c d; 0 0 1 0; 0 0 0 1]
+        const double a = -dt * V[i] * sin_psi;
+        const double b = dt * cos_psi;
+        const double c = dt * V[i] * cos_psi;
+        const double d = dt * sin_psi;
+
+        x[i] += dt * V[i] * cos_psi;
+        y[i] += dt * V[i] * sin_psi;
+        const double psi_new = psi[i] + dt * gyro[i - begin].psi_dot;
+        psi[i] = psi_new - 2.0 * M_PI * std::floor((psi_new + M_PI) / (2.0 * M_PI));
+
+        // Rows 0 and 1 of F P, then F P F^T + Q expanded for this sparsity pattern.
+        const double u00 = p00[i] + a*p02[i] + b*p03[i];
+        const double u01 = p01[i] + a*p12[i] + b*p13[i];
+        const double u02 = p02[i] + a*p22[i] + b*p23[i];
+        const double u03 = p03[i] + a*p23[i] + b*p33[i];
+        const double u11 = p11[i] + c*p12[i] + d*p13[i];
+        const double u12 = p12[i] + c*p22[i] + d*p23[i];
+        const double u13 = p13[i] + c*p23[i] + d*p33[i];
+
+        p00[i] = u00 + a*u02 + b*u03;
+        p01[i] = u01 + c*u02 + d*u03;
+        p02[i] = u02;
+        p03[i] = u03;
+        p11[i] = u11 + c*u12 + d*u13;
+        p12[i] = u12;
+        p13[i] = u13;
+        p22[i] += q22;
+        p33[i] += q33;
+    }
+}
+
+void FilterBank::handleGPSMeasurement(std::size_t index, GPSMeasurement meas)
+{
+    if (!isInitialised(index))
+    {
+        StateVector state = StateVector::Zero();
+        StateMatrix cov = StateMatrix::Zero();
+        state << meas.x, meas.y, 0.0, 0.0;
+        cov.diagonal() << GPS_POS_STD*GPS_POS_STD, GPS_POS_STD*GPS_POS_STD, INIT_PSI_STD*INIT_PSI_STD,
+                          INIT_VEL_STD*INIT_VEL_STD;
+        store(index, state, cov);
+        m_initialised[index] = 1;
+        return;
+    }
+
+    StateVector state = getState(index);
+    StateMatrix cov = getCovariance(index);
+
+    // Linear measurement of the position: H = [I 0], so S and K only involve the top-left and left blocks of P.
+    const Eigen::Vector2d innovation(meas.x - state(0), meas.y - state(1));
+    Eigen::Matrix2d S = cov.topLeftCorner<2, 2>();
+    S.diagonal().array() += GPS_POS_STD*GPS_POS_STD;
+    const Eigen::Matrix<double, StateSize, 2> K = cov.leftCols<2>() * S.inverse();
+
+    state += K * innovation;
+    cov -= K * cov.topRows<2>();
+    store(index, state, cov);
+}
+
+void FilterBank::handleLidarMeasurements(std::size_t index, const std::vector<LidarMeasurement>& dataset,
+                                         const BeaconMap& map)
+{
+    if (!isInitialised(index)){return;}
+
+    StateVector state = getState(index);
+    StateMatrix cov = getCovariance(index);
+
+    // Uncorrelated returns, updated sequentially as in the EKF answer.
+    for (const LidarMeasurement& meas : dataset)
+    {
+        BeaconData map_beacon = map.getBeaconWithId(meas.id);
+        if (meas.id == -1 || map_beacon.id == -1){continue;}
+
+        const double delta_x = map_beacon.x - state(0);
+        const double delta_y = map_beacon.y - state(1);
+        const double zhat_range = std::sqrt(delta_x*delta_x + delta_y*delta_y);
+        const double zhat_theta = std::atan2(delta_y, delta_x) - state(2);
+
+        Eigen::Matrix<double, 2, StateSize> H;
+        H << -delta_x/zhat_range, -delta_y/zhat_range, 0, 0,
+             delta_y/zhat_range/zhat_range, -delta_x/zhat_range/zhat_range, -1, 0;
+
+        const Eigen::Vector2d innovation(meas.range - zhat_range, wrapAngle(meas.theta - zhat_theta));
+        const Eigen::Matrix<double, 2, StateSize> HP = H * cov;
+        Eigen::Matrix2d S = HP * H.transpose();
+        S(0,0) += LIDAR_RANGE_STD*LIDAR_RANGE_STD;
+        S(1,1) += LIDAR_THETA_STD*LIDAR_THETA_STD;
+        const Eigen::Matrix<double, StateSize, 2> K = HP.transpose() * S.inverse();
+
+        state += K * innovation;
+        cov -= K * HP;
+    }
+    store(index, state, cov);
+}
+
+VehicleState FilterBank::getVehicleState(std::size_t index) const
+{
+    if (!isInitialised(index)){return VehicleState();}
+    return VehicleState(m_state[0][index], m_state[1][index], m_state[2][index], m_state[3][index]);
+}
+
+FilterBank::StateVector FilterBank::getState(std::size_t index) const
+{
+    return StateVector(m_state[0][index], m_state[1][index], m_state[2][index], m_state[3][index]);
+}
+
+FilterBank::StateMatrix FilterBank::getCovariance(std::size_t index) const
+{
+    StateMatrix cov;
+    cov << m_cov[P00][index], m_cov[P01][index], m_cov[P02][index], m_cov[P03][index],
+           m_cov[P01][index], m_cov[P11][index], m_cov[P12][index], m_cov[P13][index],
+           m_cov[P02][index], m_cov[P12][index], m_cov[P22][index], m_cov[P23][index],
+           m_cov[P03][index], m_cov[P13][index], m_cov[P23][index], m_cov[P33][index];
+    return cov;
+}
+
+void FilterBank::store(std::size_t index, const StateVector& state, const StateMatrix& cov)
+{
+    for (int i = 0; i < StateSize; ++i){m_state[i][index] = state(i);}
+
+    // Stores the upper triangle, averaged with the lower one so rounding doesn't skew the symmetry.
+    m_cov[P00][index] = cov(0,0);
+    m_cov[P01][index] = 0.5 * (cov(0,1) + cov(1,0));
+    m_cov[P02][index] = 0.5 * (cov(0,2) + cov(2,0));
+    m_cov[P03][index] = 0.5 * (cov(0,3) + cov(3,0));
+    m_cov[P11][index] = cov(1,1);
+    m_cov[P12][index] = 0.5 * (cov(1,2) + cov(2,1));
+    m_cov[P13][index] = 0.5 * (cov(1,3) + cov(3,1));
+    m_cov[P22][index] = cov(2,2);
+    m_cov[P23][index] = 0.5 * (cov(2,3) + cov(3,2));
+    m_cov[P33][index] = cov(3,3);
+}
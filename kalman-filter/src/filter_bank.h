@@ -0,0 +1,91 @@
+#ifndef INCLUDE_AKFSFSIM_FILTER_BANK_H
+#define INCLUDE_AKFSFSIM_FILTER_BANK_H
+
+#include <cstddef>
+#include <vector>
+#include <Eigen/Dense>
+
+#include "car.h"
+#include "sensors.h"
+#include "beacons.h"
+
+// Bank of extended Kalman filters tracking many vehicles against one BeaconMap, with the [X, Y, PSI, V] model and
+// noise constants of the EKF answer.
+//
+// The states are stored as a structure of arrays: one contiguous array per state component and per unique covariance
+// entry (10 of the 16, as the covariance is symmetric). The prediction step of every vehicle is then one loop over
+// plain arrays, which the compiler vectorises and OpenMP (when enabled) splits across cores. GPS and lidar
+// measurements are routed to the slot of their vehicle, loaded into fixed-size Eigen types, applied and stored back.
+class FilterBank
+{
+    public:
+
+        // View of one slot with the single-vehicle KalmanFilter interface. It only holds the bank and an index, so it
+        // is cheap to create on demand and stays valid until the bank is resized.
+        class Vehicle
+        {
+            public:
+
+                Vehicle(FilterBank& bank, std::size_t index):m_bank(&bank),m_index(index){}
+
+                bool isInitialised() const {return m_bank->isInitialised(m_index);}
+                VehicleState getVehicleState() const {return m_bank->getVehicleState(m_index);}
+                Eigen::Matrix2d getVehicleStatePositionCovariance() const
+                {
+                    return m_bank->getCovariance(m_index).topLeftCorner<2, 2>();
+                }
+
+                void predictionStep(GyroMeasurement gyro, double dt){m_bank->predictionStep(m_index, gyro, dt);}
+                void handleGPSMeasurement(GPSMeasurement meas){m_bank->handleGPSMeasurement(m_index, meas);}
+                void handleLidarMeasurements(const std::vector<LidarMeasurement>& meas, const BeaconMap& map)
+                {
+                    m_bank->handleLidarMeasurements(m_index, meas, map);
+                }
+
+            private:
+
+                FilterBank* m_bank;
+                std::size_t m_index;
+        };
+
+        static constexpr int StateSize = 4;
+        using StateVector = Eigen::Matrix<double, StateSize, 1>;
+        using StateMatrix = Eigen::Matrix<double, StateSize, StateSize>;
+
+        explicit FilterBank(std::size_t num_vehicles = 0){resize(num_vehicles);}
+
+        // Resizing resets every vehicle to uninitialised.
+        void resize(std::size_t num_vehicles);
+        void reset();
+        std::size_t size() const {return m_initialised.size();}
+
+        Vehicle vehicle(std::size_t index){return Vehicle(*this, index);}
+
+        // Prediction step of every vehicle, with gyro[i] the measurement of vehicle i.
+        void predictionStep(const std::vector<GyroMeasurement>& gyro, double dt);
+
+        // Steps of a single vehicle.
+        void predictionStep(std::size_t index, GyroMeasurement gyro, double dt);
+        void handleGPSMeasurement(std::size_t index, GPSMeasurement meas);
+        void handleLidarMeasurements(std::size_t index, const std::vector<LidarMeasurement>& meas, const BeaconMap& map);
+
+        bool isInitialised(std::size_t index) const {return m_initialised[index] != 0;}
+        VehicleState getVehicleState(std::size_t index) const;
+        StateVector getState(std::size_t index) const;
+        StateMatrix getCovariance(std::size_t index) const;
+
+    private:
+
+        // Unique covariance entries, in the order of m_cov.
+        enum CovarianceEntry {P00, P01, P02, P03, P11, P12, P13, P22, P23, P33, NumCovarianceEntries};
+
+        // Predicts slots [begin, end), with gyro[0] the measurement of slot begin.
+        void predictRange(std::size_t begin, std::size_t end, const GyroMeasurement* gyro, double dt);
+        void store(std::size_t index, const StateVector& state, const StateMatrix& cov);
+
+        std::vector<double> m_state[StateSize];
+        std::vector<double> m_cov[NumCovarianceEntries];
+        std::vector<char> m_initialised;
+};
+
+#endif  // INCLUDE_AKFSFSIM_FILTER_BANK_H
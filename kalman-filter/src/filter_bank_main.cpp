@@ -0,0 +1,133 @@
+// Filter bank benchmark. Simulates many vehicles driving over the same beacon map and tracks them both with one
+// FilterBank and with one KalmanFilter (the linked EKF) per vehicle, on identical measurements. Prints the time spent
+// in the prediction and update steps of each and the largest difference between their estimates.
+//
+// Usage: FilterBankBenchmark [vehicles] [seconds]
+//   vehicles  Number of vehicles (default 1000).
+//   seconds   Simulated time, with gyro and lidar at 10 Hz and GPS at 1 Hz (default 60).
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "filter_bank.h"
+#include "kalmanfilter.h"
+#include "noise_generator.h"
+#include "null_buffer.h"
+#include "utils.h"
+
+// Ground truth of one vehicle: constant speed with a slowly varying turn rate.
+struct TruthState
+{
+    double x, y, psi, V, turn_amplitude, turn_phase;
+};
+
+int main(int argc, char* argv[])
+{
+    const std::size_t num_vehicles = argc > 1 ? std::stoul(argv[1]) : 1000;
+    const double duration = argc > 2 ? std::stod(argv[2]) : 60.0;
+    const double dt = 0.1;
+    const int gps_period = 10;
+
+    NullBuffer null_buffer;
+    std::streambuf* cout_buffer = std::cout.rdbuf(&null_buffer);
+
+    BeaconMap map;
+    NoiseGenerator start_gen(1, 0);
+    std::vector<TruthState> truth(num_vehicles);
+    std::vector<GyroSensor> gyro_sensors(num_vehicles);
+    std::vector<GPSSensor> gps_sensors(num_vehicles);
+    std::vector<LidarSensor> lidar_sensors(num_vehicles);
+    for (std::size_t i = 0; i < num_vehicles; ++i)
+    {
+        truth[i] = TruthState{400.0 * (2.0 * start_gen.uniform() - 1.0), 400.0 * (2.0 * start_gen.uniform() - 1.0),
+                              wrapAngle(2.0 * M_PI * start_gen.uniform()), 2.0 + 8.0 * start_gen.uniform(),
+                              0.1 * start_gen.uniform(), 2.0 * M_PI * start_gen.uniform()};
+        gyro_sensors[i].reset(static_cast<unsigned int>(i + 1));
+        gyro_sensors[i].setGyroNoiseStd(0.001);
+        gps_sensors[i].reset(static_cast<unsigned int>(i + 1));
+        gps_sensors[i].setGPSNoiseStd(3.0);
+        lidar_sensors[i].reset(static_cast<unsigned int>(i + 1));
+        lidar_sensors[i].setLidarNoiseStd(3.0, 0.02);
+    }
+
+    FilterBank bank(num_vehicles);
+    std::vector<KalmanFilter> filters(num_vehicles);
+
+    std::vector<GyroMeasurement> gyro(num_vehicles);
+    std::vector<GPSMeasurement> gps(num_vehicles);
+    std::vector<std::vector<LidarMeasurement>> lidar(num_vehicles);
+    std::chrono::duration<double> bank_predict{0}, bank_update{0}, filters_predict{0}, filters_update{0};
+    using Clock = std::chrono::steady_clock;
+
+    const int num_steps = static_cast<int>(duration / dt);
+    for (int step = 0; step < num_steps; ++step)
+    {
+        // Simulate the vehicles and their sensors (not timed).
+        const double time = step * dt;
+        const bool gps_step = step % gps_period == 0;
+        for (std::size_t i = 0; i < num_vehicles; ++i)
+        {
+            TruthState& car = truth[i];
+            const double yaw_rate = car.turn_amplitude * std::sin(0.05 * time + car.turn_phase);
+            car.x += dt * car.V * std::cos(car.psi);
+            car.y += dt * car.V * std::sin(car.psi);
+            car.psi = wrapAngle(car.psi + dt * yaw_rate);
+            gyro[i] = gyro_sensors[i].generateGyroMeasurement(yaw_rate);
+            if (gps_step){gps[i] = gps_sensors[i].generateGPSMeasurement(car.x, car.y);}
+            lidar[i] = lidar_sensors[i].generateLidarMeasurements(car.x, car.y, car.psi, map);
+        }
+
+        auto start = Clock::now();
+        bank.predictionStep(gyro, dt);
+        auto predicted = Clock::now();
+        for (std::size_t i = 0; i < num_vehicles; ++i)
+        {
+            if (gps_step){bank.handleGPSMeasurement(i, gps[i]);}
+            bank.handleLidarMeasurements(i, lidar[i], map);
+        }
+        auto updated = Clock::now();
+        bank_predict += predicted - start;
+        bank_update += updated - predicted;
+
+        start = Clock::now();
+        for (std::size_t i = 0; i < num_vehicles; ++i){filters[i].predictionStep(gyro[i], dt);}
+        predicted = Clock::now();
+        for (std::size_t i = 0; i < num_vehicles; ++i)
+        {
+            if (gps_step){filters[i].handleGPSMeasurement(gps[i]);}
+            filters[i].handleLidarMeasurements(lidar[i], map);
+        }
+        updated = Clock::now();
+        filters_predict += predicted - start;
+        filters_update += updated - predicted;
+    }
+
+    // Compare the estimates, through the single-vehicle view of each bank slot.
+    double max_position_difference = 0.0;
+    double sum_sq_error = 0.0;
+    for (std::size_t i = 0; i < num_vehicles; ++i)
+    {
+        const VehicleState bank_state = bank.vehicle(i).getVehicleState();
+        const VehicleState filter_state = filters[i].getVehicleState();
+        max_position_difference = std::max(max_position_difference,
+            std::hypot(bank_state.x - filter_state.x, bank_state.y - filter_state.y));
+        sum_sq_error += std::pow(bank_state.x - truth[i].x, 2) + std::pow(bank_state.y - truth[i].y, 2);
+    }
+
+    std::cout.rdbuf(cout_buffer);
+    std::printf("%zu vehicles, %d steps\n", num_vehicles, num_steps);
+    std::printf("  FilterBank      predict %8.2f ms  update %8.2f ms\n", bank_predict.count() * 1e3,
+        bank_update.count() * 1e3);
+    std::printf("  KalmanFilter[]  predict %8.2f ms  update %8.2f ms\n", filters_predict.count() * 1e3,
+        filters_update.count() * 1e3);
+    std::printf("  predict speed-up %.2fx\n", filters_predict.count() / bank_predict.count());
+    std::printf("  final position RMSE %.3f m, max bank/filter difference %.2e m\n",
+        std::sqrt(sum_sq_error / num_vehicles), max_position_difference);
+    return 0;
+}
@@ -0,0 +1,93 @@
+#include "history.h"
+
+#include <algorithm>
+
+// Smallest capacity that still has room for a bucket after compacting.
+constexpr std::size_t MIN_PATH_CAPACITY = 16;
+
+DecimatedPath::DecimatedPath(std::size_t capacity):m_capacity(std::max(capacity, MIN_PATH_CAPACITY))
+{
+    m_points.reserve(m_capacity + 1);
+    clear();
+}
+
+void DecimatedPath::clear()
+{
+    m_bucket_size = 4;
+    m_num_samples = 0;
+    m_num_committed = 0;
+    m_bucket = Bucket();
+    m_points.clear();
+}
+
+void DecimatedPath::add(const Vector2& point)
+{
+    // Drop the previous newest sample; it is either part of the open bucket or was just committed with it.
+    if (m_num_samples > 0){m_points.pop_back();}
+    m_bucket.add(point, m_num_samples++);
+
+    if (m_bucket.count == m_bucket_size)
+    {
+        if (m_num_committed + 4 > m_capacity){compact();}
+        m_points.resize(m_num_committed + 4);
+        m_num_committed += m_bucket.emit(&m_points[m_num_committed]);
+        m_points.resize(m_num_committed);
+        m_bucket = Bucket();
+    }
+    m_points.push_back(point);
+}
+
+void DecimatedPath::compact()
+{
+    // Every eight points become at most four, written in place behind the read position.
+    std::size_t num_written = 0;
+    for (std::size_t i = 0; i < m_num_committed; i += 8)
+    {
+        Bucket bucket;
+        for (std::size_t j = i; j < std::min(i + 8, m_num_committed); ++j){bucket.add(m_points[j], j);}
+        num_written += bucket.emit(&m_points[num_written]);
+    }
+    m_num_committed = num_written;
+    m_points.resize(m_num_committed);
+    m_bucket_size *= 2;
+}
+
+void DecimatedPath::Bucket::add(const Vector2& point, std::size_t order)
+{
+    if (count == 0)
+    {
+        min_x = max_x = min_y = max_y = point;
+        min_x_order = max_x_order = min_y_order = max_y_order = order;
+    }
+    else
+    {
+        if (point.x < min_x.x){min_x = point; min_x_order = order;}
+        if (point.x > max_x.x){max_x = point; max_x_order = order;}
+        if (point.y < min_y.y){min_y = point; min_y_order = order;}
+        if (point.y > max_y.y){max_y = point; max_y_order = order;}
+    }
+    ++count;
+}
+
+std::size_t DecimatedPath::Bucket::emit(Vector2* out) const
+{
+    const Vector2* points[4] = {&min_x, &max_x, &min_y, &max_y};
+    std::size_t orders[4] = {min_x_order, max_x_order, min_y_order, max_y_order};
+
+    // Insertion sort by order, dropping samples that are the extreme of more than one direction.
+    std::size_t num_points = 0;
+    for (std::size_t i = 0; i < 4; ++i)
+    {
+        const Vector2* point = points[i];
+        const std::size_t order = orders[i];
+        std::size_t j = 0;
+        while (j < num_points && orders[j] < order){++j;}
+        if (j < num_points && orders[j] == order){continue;}
+        for (std::size_t k = num_points; k > j; --k){points[k] = points[k - 1]; orders[k] = orders[k - 1];}
+        points[j] = point;
+        orders[j] = order;
+        ++num_points;
+    }
+    for (std::size_t i = 0; i < num_points; ++i){out[i] = *points[i];}
+    return num_points;
+}
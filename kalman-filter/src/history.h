@@ -0,0 +1,102 @@
+#ifndef INCLUDE_AKFSFSIM_HISTORY_H
+#define INCLUDE_AKFSFSIM_HISTORY_H
+
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+#include "utils.h"
+
+// Path through the plane with a fixed number of points, however many samples are added. Samples are reduced in
+// buckets: each bucket keeps its samples with the minimum and maximum x and y (at most four, in the order they were
+// added), so the extent of the path, its corners and spikes survive the decimation. When the buffer fills, every eight
+// points are reduced the same way to at most four and the bucket size doubles. The newest sample is always the last
+// point, so a drawn path ends at the present.
+//
+// The points are stored in one vector reserved on construction, so adding never allocates and drawing the path costs
+// at most capacity + 1 points.
+class DecimatedPath
+{
+    public:
+
+        explicit DecimatedPath(std::size_t capacity = 4096);
+
+        void clear();
+        void add(const Vector2& point);
+
+        const std::vector<Vector2>& getPoints() const {return m_points;}
+        std::size_t getNumSamples() const {return m_num_samples;}
+        std::size_t getSamplesPerBucket() const {return m_bucket_size;}
+
+    private:
+
+        // Extremes of the samples of one bucket along both axes.
+        struct Bucket
+        {
+            Vector2 min_x, max_x, min_y, max_y;
+            std::size_t min_x_order, max_x_order, min_y_order, max_y_order;
+            std::size_t count = 0;
+
+            void add(const Vector2& point, std::size_t order);
+
+            // Writes the distinct extremes to out, in order, and returns the number written (1 to 4).
+            std::size_t emit(Vector2* out) const;
+        };
+
+        void compact();
+
+        std::size_t m_capacity;
+        std::size_t m_bucket_size;      // Samples reduced into each bucket
+        std::size_t m_num_samples;
+        std::size_t m_num_committed;    // Points of completed buckets, at the front of m_points
+        Bucket m_bucket;
+        std::vector<Vector2> m_points;  // Completed buckets, then the open bucket's newest sample
+};
+
+// Fixed-capacity ring buffer that overwrites its oldest element once full. Iteration is in storage order, not in the
+// order the elements were added.
+template <typename T>
+class RingBuffer
+{
+    public:
+
+        explicit RingBuffer(std::size_t capacity):m_capacity(capacity),m_next(0){m_data.reserve(capacity);}
+
+        void clear(){m_data.clear(); m_next = 0;}
+        void push(const T& value)
+        {
+            if (m_data.size() < m_capacity){m_data.push_back(value);}
+            else {m_data[m_next] = value;}
+            m_next = (m_next + 1) % m_capacity;
+        }
+
+        std::size_t size() const {return m_data.size();}
+        typename std::vector<T>::const_iterator begin() const {return m_data.begin();}
+        typename std::vector<T>::const_iterator end() const {return m_data.end();}
+
+    private:
+
+        std::size_t m_capacity;
+        std::size_t m_next;
+        std::vector<T> m_data;
+};
+
+// Root mean square of a series, accumulated one sample at a time.
+class RunningRMSE
+{
+    public:
+
+        RunningRMSE():m_sum_sq(0.0),m_count(0){}
+
+        void clear(){m_sum_sq = 0.0; m_count = 0;}
+        void add(double value){m_sum_sq += value * value; ++m_count;}
+        double getRMSE() const {return m_count > 0 ? std::sqrt(m_sum_sq / m_count) : 0.0;}
+        std::size_t getCount() const {return m_count;}
+
+    private:
+
+        double m_sum_sq;
+        std::size_t m_count;
+};
+
+#endif  // INCLUDE_AKFSFSIM_HISTORY_H
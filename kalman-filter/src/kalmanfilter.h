@@ -1,12 +1,14 @@
 #ifndef INCLUDE_AKFSFSIM_KALMANFILTER_H
 #define INCLUDE_AKFSFSIM_KALMANFILTER_H
 
+#include <algorithm>
 #include <vector>
 #include <Eigen/Dense>
 
 #include "car.h"
 #include "sensors.h"
 #include "beacons.h"
+#include "data_association.h"
 
 using Eigen::VectorXd;
 using Eigen::Vector2d;
@@ -16,32 +18,170 @@ using Eigen::MatrixXd;
 using Eigen::Matrix2d;
 using Eigen::Matrix4d;
 
+// Number of states the linked filter tracks. The linear, extended and unscented filters use 4 ([X,Y,VX,VY] or 
+// [X,Y,PSI,V]); the capstone filters add the gyro bias. Targets that link a capstone filter define it as 5.
+#ifndef KALMAN_FILTER_NX
+#define KALMAN_FILTER_NX 4
+#endif
+
+// How a scan of lidar returns is fused. Sequential runs one 2D update per return; Batched stacks the associated 
+// returns of a scan into one measurement vector with a block-diagonal R and runs a single update (batched_lidar.h).
+// Only the (full covariance) EKF filters implement the batched update; the other filters always update sequentially.
+enum class LidarUpdateMode {Sequential, Batched};
+
+// Whether the linked filter implements LidarUpdateMode::Batched. Targets that link an EKF filter define 
+// KALMAN_FILTER_BATCHED_LIDAR.
+#if defined(KALMAN_FILTER_BATCHED_LIDAR)
+constexpr bool BATCHED_LIDAR_SUPPORTED = true;
+#else
+constexpr bool BATCHED_LIDAR_SUPPORTED = false;
+#endif
+
+// Holds the state and covariance in fixed-size Eigen types, so they live inline in the filter and the predict and 
+// update steps never allocate.
+template <int NX>
 class KalmanFilterBase
 {
     public:
 
-        KalmanFilterBase():m_initialised(false){}
+        static constexpr int StateSize = NX;
+
+        using StateVector = Eigen::Matrix<double, NX, 1>;
+        using StateMatrix = Eigen::Matrix<double, NX, NX>;
+        using CovarianceMatrix = StateMatrix;
+
+        // Measurement Jacobian and Kalman gain for a measurement with NZ components.
+        template <int NZ> using MeasurementMatrix = Eigen::Matrix<double, NZ, NX>;
+        template <int NZ> using GainMatrix = Eigen::Matrix<double, NX, NZ>;
+
+        KalmanFilterBase():m_initialised(false),m_state(StateVector::Zero()),m_covariance(CovarianceMatrix::Zero()){}
         virtual ~KalmanFilterBase(){}
         void reset(){m_initialised = false;}
         bool isInitialised() const {return m_initialised;}
 
     protected:
     
-        VectorXd getState() const {return m_state;}
-        MatrixXd getCovariance()const {return m_covariance;}
-        void setState(const VectorXd& state ) {m_state = state; m_initialised = true;}
-        void setCovariance(const MatrixXd& cov ){m_covariance = cov;}
+        const StateVector& getState() const {return m_state;}
+        const CovarianceMatrix& getCovariance() const {return m_covariance;}
+        void setState(const StateVector& state ) {m_state = state; m_initialised = true;}
+        void setCovariance(const CovarianceMatrix& cov ){m_covariance = cov;}
+
+        // In-place access for the predict and update steps of an initialised filter.
+        StateVector& mutableState() {return m_state;}
+        CovarianceMatrix& mutableCovariance() {return m_covariance;}
+
+        // Prediction step with a linear (or linearised) model: sets the state to predicted_state and the covariance to
+        // F P F^T + Q. angle_state is the index of a heading state, or -1.
+        void linearisedPrediction(const StateVector& predicted_state, const StateMatrix& F, const StateMatrix& Q, 
+                                  int angle_state = -1)
+        {
+            StateMatrix predicted_covariance = F * m_covariance * F.transpose() + Q;
+            onLinearisedPrediction(m_state, m_covariance, F, predicted_state, predicted_covariance, angle_state);
+            m_state = predicted_state;
+            m_covariance = predicted_covariance;
+        }
+
+        // Called by linearisedPrediction() with the estimate it starts from (x, P), the transition matrix F and the 
+        // predicted estimate, before the filter takes the prediction. Does nothing here; a derived filter can record 
+        // the steps, e.g. to smooth the estimate (see SmoothingKalmanFilter in trace.h).
+        virtual void onLinearisedPrediction(const StateVector& /*x*/, const CovarianceMatrix& /*P*/, 
+                                            const StateMatrix& /*F*/, const StateVector& /*x_predicted*/, 
+                                            const CovarianceMatrix& /*P_predicted*/, int /*angle_state*/){}
 
     private:
         bool m_initialised;
-        VectorXd m_state;
-        MatrixXd m_covariance;
+        StateVector m_state;
+        CovarianceMatrix m_covariance;
 };
 
-class KalmanFilter : public KalmanFilterBase
+// Base of the square-root filters, which propagate the lower-triangular covariance factor S (P = S S^T) instead of P.
+// P is only formed from S when getCovariance() is called after S changed, e.g. for display or data association. The
+// base methods that write P directly are private here, as they would not update S. Targets that link a square-root 
+// filter define KALMAN_FILTER_SQRT.
+template <int NX>
+class SquareRootKalmanFilterBase : public KalmanFilterBase<NX>
 {
     public:
 
+        using StateMatrix = typename KalmanFilterBase<NX>::StateMatrix;
+        using CovarianceMatrix = typename KalmanFilterBase<NX>::CovarianceMatrix;
+
+    protected:
+
+        const StateMatrix& getSqrtCovariance() const {return m_sqrt_covariance;}
+        void setSqrtCovariance(const StateMatrix& sqrt_cov){m_sqrt_covariance = sqrt_cov; m_covariance_valid = false;}
+
+        const CovarianceMatrix& getCovariance() const
+        {
+            if (!m_covariance_valid)
+            {
+                m_covariance.noalias() = m_sqrt_covariance * m_sqrt_covariance.transpose();
+                m_covariance_valid = true;
+            }
+            return m_covariance;
+        }
+
+    private:
+
+        using KalmanFilterBase<NX>::setCovariance;
+        using KalmanFilterBase<NX>::mutableCovariance;
+        using KalmanFilterBase<NX>::linearisedPrediction;
+
+        StateMatrix m_sqrt_covariance = StateMatrix::Zero();
+        mutable CovarianceMatrix m_covariance = CovarianceMatrix::Zero();
+        mutable bool m_covariance_valid = true;
+};
+
+// Base of the capstone filters, with the data association of lidar returns that come without a beacon id. Targets 
+// that link a capstone filter define KALMAN_FILTER_CAPSTONE.
+template <int NX>
+class CapstoneKalmanFilterBase : public KalmanFilterBase<NX>
+{
+    protected:
+
+        // Returns the dataset with its unlabelled returns (id -1) associated to map beacons using the current estimate.
+        // The dataset itself is returned when the filter isn't initialised yet or every return is already labelled.
+        const std::vector<LidarMeasurement>& associateLidarMeasurements(const std::vector<LidarMeasurement>& dataset, 
+            const BeaconMap& map, double range_std, double theta_std)
+        {
+            auto unlabelled = [](const LidarMeasurement& meas){return meas.id == -1;};
+            if (!this->isInitialised() || std::none_of(dataset.begin(), dataset.end(), unlabelled)){return dataset;}
+
+            m_associated_returns = dataset;
+            m_lidar_association.associate(m_associated_returns, map, this->getState().template head<3>(), 
+                this->getCovariance().template topLeftCorner<3, 3>(), range_std, theta_std);
+            return m_associated_returns;
+        }
+
+        LidarDataAssociation m_lidar_association;
+        double m_init_heading_std = 0.0;
+
+    private:
+        std::vector<LidarMeasurement> m_associated_returns;
+};
+
+#if defined(KALMAN_FILTER_SQRT)
+using KalmanFilterBaseClass = SquareRootKalmanFilterBase<KALMAN_FILTER_NX>;
+#elif defined(KALMAN_FILTER_CAPSTONE)
+using KalmanFilterBaseClass = CapstoneKalmanFilterBase<KALMAN_FILTER_NX>;
+#else
+using KalmanFilterBaseClass = KalmanFilterBase<KALMAN_FILTER_NX>;
+#endif
+
+class KalmanFilter : public KalmanFilterBaseClass
+{
+    public:
+
+        // Also clears the initial condition estimates of the capstone filters, so a reset filter starts from scratch.
+        void reset()
+        {
+            KalmanFilterBase::reset();
+            m_init_position_valid = false;
+            m_init_heading_valid = false;
+            m_init_velocity_valid = false;
+            m_init_bias_valid = false;
+        }
+
         VehicleState getVehicleState();
         Matrix2d getVehicleStatePositionCovariance();
 
@@ -51,17 +191,22 @@ class KalmanFilter : public KalmanFilterBase
         void handleLidarMeasurement(LidarMeasurement meas, const BeaconMap& map);
         void handleGPSMeasurement(GPSMeasurement meas);
 
+        void setLidarUpdateMode(LidarUpdateMode mode) {m_lidar_update_mode = mode;}
+        LidarUpdateMode getLidarUpdateMode() const {return m_lidar_update_mode;}
+
     private:
 
+        LidarUpdateMode m_lidar_update_mode = LidarUpdateMode::Sequential;
+
         double m_init_position_x;
         double m_init_position_y;
         double m_init_heading;
         double m_init_velocity;
         double m_init_bias;
-        bool m_init_position_valid;
-        bool m_init_heading_valid;
-        bool m_init_velocity_valid;
-        bool m_init_bias_valid;
+        bool m_init_position_valid = false;
+        bool m_init_heading_valid = false;
+        bool m_init_velocity_valid = false;
+        bool m_init_bias_valid = false;
 
 };
 
@@ -7,6 +7,7 @@
 // -Rename this file to "kalmanfilter.cpp" if you want to use this code.
 
 #include "kalmanfilter.h"
+#include "batched_lidar.h"
 #include "utils.h"
 
 // -------------------------------------------------- //
@@ -22,16 +23,24 @@ constexpr double LIDAR_THETA_STD = 0.02;
 
 void KalmanFilter::handleLidarMeasurements(const std::vector<LidarMeasurement>& dataset, const BeaconMap& map)
 {
-    // Assume No Correlation between the Measurements and Update Sequentially
-    for(const auto& meas : dataset) {handleLidarMeasurement(meas, map);}
+    if (getLidarUpdateMode() == LidarUpdateMode::Sequential || !isInitialised())
+    {
+        // Assume No Correlation between the Measurements and Update Sequentially
+        for(const auto& meas : dataset) {handleLidarMeasurement(meas, map);}
+        return;
+    }
+
+    // Batched Update: Stack the Map-Matched Returns and Update Once per Batch
+    batchedLidarUpdate(mutableState(), mutableCovariance(), dataset, map, LIDAR_RANGE_STD, 
+                       LIDAR_THETA_STD);
 }
 
 void KalmanFilter::handleLidarMeasurement(LidarMeasurement meas, const BeaconMap& map)
 {
     if (isInitialised())
     {
-        VectorXd state = getState();
-        MatrixXd cov = getCovariance();
+        StateVector& state = mutableState();
+        CovarianceMatrix& cov = mutableCovariance();
 
         // Implement The Kalman Filter Update Step for the Lidar Measurements in the 
         // section below.
@@ -47,11 +56,11 @@ void KalmanFilter::handleLidarMeasurement(LidarMeasurement meas, const BeaconMap
         if (meas.id != -1 && map_beacon.id != -1)
         {           
             // Measurement Vector
-            VectorXd z = Vector2d::Zero();
+            Vector2d z = Vector2d::Zero();
             z << meas.range, meas.theta;
 
             // Predicted Measurement Vector (Measurement Model)
-            VectorXd z_hat = Vector2d::Zero();
+            Vector2d z_hat = Vector2d::Zero();
             double delta_x = map_beacon.x - state[0];
             double delta_y = map_beacon.y - state[1];
             double zhat_range = sqrt(delta_x*delta_x + delta_y*delta_y);
@@ -59,27 +68,25 @@ void KalmanFilter::handleLidarMeasurement(LidarMeasurement meas, const BeaconMap
             z_hat << zhat_range, zhat_theta;
 
             // Measurement Model Sensitivity Matrix
-            MatrixXd H = MatrixXd(2,4);
+            MeasurementMatrix<2> H;
             H << -delta_x/zhat_range,-delta_y/zhat_range,0,0,delta_y/zhat_range/zhat_range,-delta_x/zhat_range/zhat_range,-1,0;
 
             // Generate Measurement Model Noise Covariance Matrix
-            MatrixXd R = Matrix2d::Zero();
+            Matrix2d R = Matrix2d::Zero();
             R(0,0) = LIDAR_RANGE_STD*LIDAR_RANGE_STD;
             R(1,1) = LIDAR_THETA_STD*LIDAR_THETA_STD;
 
-            VectorXd y = z - z_hat;
-            MatrixXd S = H * cov * H.transpose() + R;
-            MatrixXd K = cov*H.transpose()*S.inverse();
+            Vector2d y = z - z_hat;
+            Matrix2d S = H * cov * H.transpose() + R;
+            GainMatrix<2> K = cov*H.transpose()*S.inverse();
 
             y(1) = wrapAngle(y(1)); // Wrap the Heading Innovation
 
             state = state + K*y;
-            cov = (Matrix4d::Identity() - K*H) * cov;            
+            cov = (StateMatrix::Identity() - K*H) * cov;            
         }
         // ----------------------------------------------------------------------- //
 
-        setState(state);
-        setCovariance(cov);
     }
 }
 
@@ -87,8 +94,7 @@ void KalmanFilter::predictionStep(GyroMeasurement gyro, double dt)
 {
     if (isInitialised())
     {
-        VectorXd state = getState();
-        MatrixXd cov = getCovariance();
+        const StateVector& state = getState();
 
         // Implement The Kalman Filter Prediction Step for the system in the  
         // section below.
@@ -110,23 +116,23 @@ void KalmanFilter::predictionStep(GyroMeasurement gyro, double dt)
         double y_new = y + dt * V * sin(psi);
         double psi_new = wrapAngle(psi + dt * gyro.psi_dot);
         double V_new = V;
-        state << x_new,y_new,psi_new,V_new;
+        StateVector state_new;
+        state_new << x_new,y_new,psi_new,V_new;
 
         // Generate F Matrix
-        MatrixXd F = Matrix4d::Zero();
+        StateMatrix F = StateMatrix::Zero();
         F << 1,0,-dt*V*sin(psi),dt*cos(psi),0,1,dt*V*cos(psi),dt*sin(psi),0,0,1,0,0,0,0,1;
 
         // Generate Q Matrix
-        MatrixXd Q = Matrix4d::Zero();
+        StateMatrix Q = StateMatrix::Zero();
         Q(2,2) = dt*dt*GYRO_STD*GYRO_STD;
         Q(3,3) = dt*dt*ACCEL_STD*ACCEL_STD;
 
-        cov = F * cov * F.transpose() + Q;
+        // Predicts the Covariance
+        linearisedPrediction(state_new, F, Q, 2);
 
         // ----------------------------------------------------------------------- //
 
-        setState(state);
-        setCovariance(cov);
     } 
 }
 
@@ -136,33 +142,31 @@ void KalmanFilter::handleGPSMeasurement(GPSMeasurement meas)
     // so the UKF update state would just produce the same result.
     if(isInitialised())
     {
-        VectorXd state = getState();
-        MatrixXd cov = getCovariance();
+        StateVector& state = mutableState();
+        CovarianceMatrix& cov = mutableCovariance();
 
-        VectorXd z = Vector2d::Zero();
-        MatrixXd H = MatrixXd(2,4);
-        MatrixXd R = Matrix2d::Zero();
+        Vector2d z = Vector2d::Zero();
+        MeasurementMatrix<2> H;
+        Matrix2d R = Matrix2d::Zero();
 
         z << meas.x,meas.y;
         H << 1,0,0,0,0,1,0,0;
         R(0,0) = GPS_POS_STD*GPS_POS_STD;
         R(1,1) = GPS_POS_STD*GPS_POS_STD;
 
-        VectorXd z_hat = H * state;
-        VectorXd y = z - z_hat;
-        MatrixXd S = H * cov * H.transpose() + R;
-        MatrixXd K = cov*H.transpose()*S.inverse();
+        Vector2d z_hat = H * state;
+        Vector2d y = z - z_hat;
+        Matrix2d S = H * cov * H.transpose() + R;
+        GainMatrix<2> K = cov*H.transpose()*S.inverse();
 
         state = state + K*y;
-        cov = (Matrix4d::Identity() - K*H) * cov;
+        cov = (StateMatrix::Identity() - K*H) * cov;
 
-        setState(state);
-        setCovariance(cov);
     }
     else
     {
-        VectorXd state = Vector4d::Zero();
-        MatrixXd cov = Matrix4d::Zero();
+        StateVector state = StateVector::Zero();
+        CovarianceMatrix cov = CovarianceMatrix::Zero();
 
         state(0) = meas.x;
         state(1) = meas.y;
@@ -179,7 +183,7 @@ void KalmanFilter::handleGPSMeasurement(GPSMeasurement meas)
 Matrix2d KalmanFilter::getVehicleStatePositionCovariance()
 {
     Matrix2d pos_cov = Matrix2d::Zero();
-    MatrixXd cov = getCovariance();
+    const CovarianceMatrix& cov = getCovariance();
     if (isInitialised() && cov.size() != 0){pos_cov << cov(0,0), cov(0,1), cov(1,0), cov(1,1);}
     return pos_cov;
 }
@@ -188,7 +192,7 @@ VehicleState KalmanFilter::getVehicleState()
 {
     if (isInitialised())
     {
-        VectorXd state = getState(); // STATE VECTOR [X,Y,PSI,V,...]
+        const StateVector& state = getState(); // STATE VECTOR [X,Y,PSI,V,...]
         return VehicleState(state[0],state[1],state[2],state[3]);
     }
     return VehicleState();
@@ -6,7 +6,10 @@
 // Usage:
 // -Rename this file to "kalmanfilter.cpp" if you want to use this code.
 
+#include <iostream>
+
 #include "kalmanfilter.h"
+#include "batched_lidar.h"
 #include "utils.h"
 
 // -------------------------------------------------- //
@@ -21,18 +24,45 @@ constexpr double LIDAR_RANGE_STD = 3.0;
 constexpr double LIDAR_THETA_STD = 0.02;
 // -------------------------------------------------- //
 
-void KalmanFilter::handleLidarMeasurements(const std::vector<LidarMeasurement>& dataset, const BeaconMap& map)
+void KalmanFilter::handleLidarMeasurements(const std::vector<LidarMeasurement>& measurements, const BeaconMap& map)
 {
-    // Assume No Correlation between the Measurements and Update Sequentially
-    for(const auto& meas : dataset) {handleLidarMeasurement(meas, map);}
+    // Without Beacon Ids the Heading can't come from a Single Return, so Vote for it with the Whole Scan (CAPSTONE)
+    if (!isInitialised() && m_init_position_valid && !measurements.empty() && measurements.front().id == -1)
+    {
+        double heading, heading_std;
+        if (m_lidar_association.estimateHeading(measurements, map, m_init_position_x, m_init_position_y,
+                                                GPS_POS_STD, LIDAR_RANGE_STD, heading, heading_std))
+        {
+            m_init_heading = heading;
+            m_init_heading_std = std::max(heading_std, LIDAR_THETA_STD);
+            m_init_heading_valid = true;
+            std::cout << "INIT<HEADING> @ " << m_init_heading << std::endl;
+        }
+        return;
+    }
+
+    // Associate Returns without Beacon Ids to the Map (CAPSTONE)
+    const std::vector<LidarMeasurement>& dataset = 
+        associateLidarMeasurements(measurements, map, LIDAR_RANGE_STD, LIDAR_THETA_STD);
+
+    if (getLidarUpdateMode() == LidarUpdateMode::Sequential || !isInitialised())
+    {
+        // Assume No Correlation between the Measurements and Update Sequentially
+        for(const auto& meas : dataset) {handleLidarMeasurement(meas, map);}
+        return;
+    }
+
+    // Batched Update: Stack the Map-Matched Returns and Update Once per Batch
+    batchedLidarUpdate(mutableState(), mutableCovariance(), dataset, map, LIDAR_RANGE_STD, 
+                       LIDAR_THETA_STD);
 }
 
 void KalmanFilter::handleLidarMeasurement(LidarMeasurement meas, const BeaconMap& map)
 {
     if (isInitialised())
     {
-        VectorXd state = getState();
-        MatrixXd cov = getCovariance();
+        StateVector& state = mutableState();
+        CovarianceMatrix& cov = mutableCovariance();
 
         // Implement The Kalman Filter Update Step for the Lidar Measurements in the 
         // section below.
@@ -48,11 +78,11 @@ void KalmanFilter::handleLidarMeasurement(LidarMeasurement meas, const BeaconMap
         if (meas.id != -1 && map_beacon.id != -1)
         {           
             // Measurement Vector
-            VectorXd z = Vector2d::Zero();
+            Vector2d z = Vector2d::Zero();
             z << meas.range, meas.theta;
 
             // Predicted Measurement Vector (Measurement Model)
-            VectorXd z_hat = Vector2d::Zero();
+            Vector2d z_hat = Vector2d::Zero();
             double delta_x = map_beacon.x - state[0];
             double delta_y = map_beacon.y - state[1];
             double zhat_range = sqrt(delta_x*delta_x + delta_y*delta_y);
@@ -60,28 +90,26 @@ void KalmanFilter::handleLidarMeasurement(LidarMeasurement meas, const BeaconMap
             z_hat << zhat_range, zhat_theta;
 
             // Measurement Model Sensitivity Matrix
-            MatrixXd H = MatrixXd(2,5);
+            MeasurementMatrix<2> H;
             H << -delta_x/zhat_range,-delta_y/zhat_range,0,0,0,
                   delta_y/zhat_range/zhat_range,-delta_x/zhat_range/zhat_range,-1,0,0; // Updated for Gyro Bias State (CAPSTONE)
 
             // Generate Measurement Model Noise Covariance Matrix
-            MatrixXd R = Matrix2d::Zero();
+            Matrix2d R = Matrix2d::Zero();
             R(0,0) = LIDAR_RANGE_STD*LIDAR_RANGE_STD;
             R(1,1) = LIDAR_THETA_STD*LIDAR_THETA_STD;
 
-            VectorXd y = z - z_hat;
-            MatrixXd S = H * cov * H.transpose() + R;
-            MatrixXd K = cov*H.transpose()*S.inverse();
+            Vector2d y = z - z_hat;
+            Matrix2d S = H * cov * H.transpose() + R;
+            GainMatrix<2> K = cov*H.transpose()*S.inverse();
 
             y(1) = wrapAngle(y(1)); // Wrap the Heading Innovation
 
             state = state + K*y;
-            cov = (MatrixXd::Identity(5,5) - K*H) * cov;
+            cov = (StateMatrix::Identity() - K*H) * cov;
         }
         // ----------------------------------------------------------------------- //
 
-        setState(state);
-        setCovariance(cov);
     }
     else
     {
@@ -94,6 +122,7 @@ void KalmanFilter::handleLidarMeasurement(LidarMeasurement meas, const BeaconMap
                 double delta_x = map_beacon.x - m_init_position_x;
                 double delta_y = map_beacon.y - m_init_position_y;
                 m_init_heading = wrapAngle(atan2(delta_y,delta_x) - meas.theta);
+                m_init_heading_std = LIDAR_THETA_STD;
                 m_init_heading_valid = true;
                 std::cout << "INIT<HEADING> @ " << m_init_heading << std::endl;
             }
@@ -105,8 +134,7 @@ void KalmanFilter::predictionStep(GyroMeasurement gyro, double dt)
 {
     if (isInitialised())
     {
-        VectorXd state = getState();
-        MatrixXd cov = getCovariance();
+        const StateVector& state = getState();
 
         // Implement The Kalman Filter Prediction Step for the system in the  
         // section below.
@@ -130,10 +158,11 @@ void KalmanFilter::predictionStep(GyroMeasurement gyro, double dt)
         double psi_new = wrapAngle(psi + dt * (gyro.psi_dot - bias)); // Added Gyroscope Bias (CAPSTONE)
         double V_new = V;
         double bias_new = bias;
-        state << x_new,y_new,psi_new,V_new,bias_new; // Adding Gyro Bias State (CAPSTONE)
+        StateVector state_new;
+        state_new << x_new,y_new,psi_new,V_new,bias_new; // Adding Gyro Bias State (CAPSTONE)
 
         // Generate F Matrix
-        MatrixXd F = MatrixXd::Zero(5,5);
+        StateMatrix F = StateMatrix::Zero();
         F << 1,0,-dt*V*sin(psi),dt*cos(psi),0, 
              0,1,dt*V*cos(psi),dt*sin(psi),0,
              0,0,1,0,-dt,
@@ -141,17 +170,16 @@ void KalmanFilter::predictionStep(GyroMeasurement gyro, double dt)
              0,0,0,0,1; // Updated for Gyro Bias State
 
         // Generate Q Matrix
-        MatrixXd Q = MatrixXd::Zero(5,5);
+        StateMatrix Q = StateMatrix::Zero();
         Q(2,2) = dt*dt*GYRO_STD*GYRO_STD;
         Q(3,3) = dt*dt*ACCEL_STD*ACCEL_STD;
         Q(4,4) = dt*dt*GYRO_BIAS_STD*GYRO_BIAS_STD; // Adding Gyro Bias Process Model Noise (CAPSTONE)
 
-        cov = F * cov * F.transpose() + Q;
+        // Predicts the Covariance
+        linearisedPrediction(state_new, F, Q, 2);
 
         // ----------------------------------------------------------------------- //
 
-        setState(state);
-        setCovariance(cov);
     }
     else
     {
@@ -168,12 +196,12 @@ void KalmanFilter::handleGPSMeasurement(GPSMeasurement meas)
     // so the UKF update state would just produce the same result.
     if(isInitialised())
     {
-        VectorXd state = getState();
-        MatrixXd cov = getCovariance();
+        StateVector& state = mutableState();
+        CovarianceMatrix& cov = mutableCovariance();
 
-        VectorXd z = Vector2d::Zero();
-        MatrixXd H = MatrixXd(2,5);
-        MatrixXd R = Matrix2d::Zero();
+        Vector2d z = Vector2d::Zero();
+        MeasurementMatrix<2> H;
+        Matrix2d R = Matrix2d::Zero();
 
         z << meas.x,meas.y;
         H << 1,0,0,0,0,
@@ -181,25 +209,23 @@ void KalmanFilter::handleGPSMeasurement(GPSMeasurement meas)
         R(0,0) = GPS_POS_STD*GPS_POS_STD;
         R(1,1) = GPS_POS_STD*GPS_POS_STD;
 
-        VectorXd z_hat = H * state;
-        VectorXd y = z - z_hat;
-        MatrixXd S = H * cov * H.transpose() + R;
-        MatrixXd K = cov*H.transpose()*S.inverse();
+        Vector2d z_hat = H * state;
+        Vector2d y = z - z_hat;
+        Matrix2d S = H * cov * H.transpose() + R;
+        GainMatrix<2> K = cov*H.transpose()*S.inverse();
 
         // GPS Innovation Check (CAPSTONE)
-        VectorXd NIS = y.transpose()*S.inverse()*y;
-        if (NIS(0) < 5.99)
+        double NIS = y.dot(S.inverse()*y);
+        if (NIS < 5.99)
         {
             state = state + K*y;
-            cov = (MatrixXd::Identity(5,5) - K*H) * cov;
+            cov = (StateMatrix::Identity() - K*H) * cov;
         }
         else
         {
-            std::cout << "GPS NIS Failed! " << NIS(0) << std::endl;
+            std::cout << "GPS NIS Failed! " << NIS << std::endl;
         }
 
-        setState(state);
-        setCovariance(cov);
     }
     else
     {
@@ -228,6 +254,7 @@ void KalmanFilter::handleGPSMeasurement(GPSMeasurement meas)
             {
                 // Estimate Heading from Delta Position (Assuming Vehicle is Facing in the Direction it is moving)
                 m_init_heading = wrapAngle(atan2(delta_y,delta_x));
+                m_init_heading_std = INIT_PSI_STD; // Much Less Certain than a Lidar Bearing
                 m_init_heading_valid = true;
                 std::cout << "INIT<HEADING> @ " << m_init_heading << std::endl;
             }
@@ -238,8 +265,8 @@ void KalmanFilter::handleGPSMeasurement(GPSMeasurement meas)
             m_init_velocity_valid &&
             m_init_bias_valid)
         {
-            VectorXd state = VectorXd::Zero(5);
-            MatrixXd cov = MatrixXd::Zero(5,5);
+            StateVector state = StateVector::Zero();
+            CovarianceMatrix cov = CovarianceMatrix::Zero();
 
             state(0) = m_init_position_x;
             state(1) = m_init_position_y;
@@ -249,7 +276,7 @@ void KalmanFilter::handleGPSMeasurement(GPSMeasurement meas)
 
             cov(0,0) = GPS_POS_STD*GPS_POS_STD;
             cov(1,1) = GPS_POS_STD*GPS_POS_STD;
-            cov(2,2) = LIDAR_THETA_STD*LIDAR_THETA_STD;
+            cov(2,2) = m_init_heading_std*m_init_heading_std;
             cov(3,3) = INIT_VEL_STD*INIT_VEL_STD;
             cov(4,4) = GYRO_STD*GYRO_STD;
             
@@ -262,7 +289,7 @@ void KalmanFilter::handleGPSMeasurement(GPSMeasurement meas)
 Matrix2d KalmanFilter::getVehicleStatePositionCovariance()
 {
     Matrix2d pos_cov = Matrix2d::Zero();
-    MatrixXd cov = getCovariance();
+    const CovarianceMatrix& cov = getCovariance();
     if (isInitialised() && cov.size() != 0){pos_cov << cov(0,0), cov(0,1), cov(1,0), cov(1,1);}
     return pos_cov;
 }
@@ -271,7 +298,7 @@ VehicleState KalmanFilter::getVehicleState()
 {
     if (isInitialised())
     {
-        VectorXd state = getState(); // STATE VECTOR [X,Y,PSI,V,...]
+        const StateVector& state = getState(); // STATE VECTOR [X,Y,PSI,V,...]
         return VehicleState(state[0],state[1],state[2],state[3]);
     }
     return VehicleState();
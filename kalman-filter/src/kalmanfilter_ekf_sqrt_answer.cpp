@@ -0,0 +1,162 @@
+// ------------------------------------------------------------------------------- //
+// Advanced Kalman Filtering and Sensor Fusion Course - Square-Root Extended Kalman Filter
+//
+// ####### ANSWER FILE #######
+//
+// Same models as the EKF answer, but the filter propagates the Cholesky factor S of
+// the covariance (P = S S^T) instead of P. The prediction triangularises [(F S)^T; Q^(1/2)]
+// and the updates triangularise the pre-array [R^(1/2), H S; 0, S] (see square_root.h),
+// so P can't lose positive-definiteness however long the filter runs.
+//
+// Usage:
+// -Rename this file to "kalmanfilter.cpp" if you want to use this code.
+
+#include "kalmanfilter.h"
+#include "square_root.h"
+#include "utils.h"
+
+// -------------------------------------------------- //
+// YOU CAN USE AND MODIFY THESE CONSTANTS HERE
+constexpr double ACCEL_STD = 1.0;
+constexpr double GYRO_STD = 0.01/180.0 * M_PI;
+constexpr double INIT_VEL_STD = 10.0;
+constexpr double INIT_PSI_STD = 45.0/180.0 * M_PI;
+constexpr double GPS_POS_STD = 3.0;
+constexpr double LIDAR_RANGE_STD = 3.0;
+constexpr double LIDAR_THETA_STD = 0.02;
+// -------------------------------------------------- //
+
+void KalmanFilter::handleLidarMeasurements(const std::vector<LidarMeasurement>& dataset, const BeaconMap& map)
+{
+    // Assume No Correlation between the Measurements and Update Sequentially
+    for(const auto& meas : dataset) {handleLidarMeasurement(meas, map);}
+}
+
+void KalmanFilter::handleLidarMeasurement(LidarMeasurement meas, const BeaconMap& map)
+{
+    if (isInitialised())
+    {
+        StateVector& state = mutableState();
+        StateMatrix sqrt_cov = getSqrtCovariance();
+
+        BeaconData map_beacon = map.getBeaconWithId(meas.id); // Match Beacon with built in Data Association Id
+        if (meas.id != -1 && map_beacon.id != -1)
+        {
+            // Measurement Vector
+            Vector2d z = Vector2d::Zero();
+            z << meas.range, meas.theta;
+
+            // Predicted Measurement Vector (Measurement Model)
+            Vector2d z_hat = Vector2d::Zero();
+            double delta_x = map_beacon.x - state[0];
+            double delta_y = map_beacon.y - state[1];
+            double zhat_range = sqrt(delta_x*delta_x + delta_y*delta_y);
+            double zhat_theta = wrapAngle(atan2(delta_y,delta_x) - state[2]);
+            z_hat << zhat_range, zhat_theta;
+
+            // Measurement Model Sensitivity Matrix
+            MeasurementMatrix<2> H;
+            H << -delta_x/zhat_range,-delta_y/zhat_range,0,0,delta_y/zhat_range/zhat_range,-delta_x/zhat_range/zhat_range,-1,0;
+
+            // Measurement Model Noise Factor (R is Diagonal, so its Factor is the Standard Deviations)
+            Matrix2d R_sqrt = Matrix2d::Zero();
+            R_sqrt(0,0) = LIDAR_RANGE_STD;
+            R_sqrt(1,1) = LIDAR_THETA_STD;
+
+            Vector2d y = z - z_hat;
+            y(1) = wrapAngle(y(1)); // Wrap the Heading Innovation
+
+            squareRootUpdate(state, sqrt_cov, y, H, R_sqrt);
+            setSqrtCovariance(sqrt_cov);
+        }
+    }
+}
+
+void KalmanFilter::predictionStep(GyroMeasurement gyro, double dt)
+{
+    if (isInitialised())
+    {
+        StateVector& state = mutableState();
+
+        double x = state(0);
+        double y = state(1);
+        double psi = state(2);
+        double V = state(3);
+
+        // Update State
+        double x_new = x + dt * V * cos(psi);
+        double y_new = y + dt * V * sin(psi);
+        double psi_new = wrapAngle(psi + dt * gyro.psi_dot);
+        double V_new = V;
+        state << x_new,y_new,psi_new,V_new;
+
+        // Generate F Matrix
+        StateMatrix F = StateMatrix::Zero();
+        F << 1,0,-dt*V*sin(psi),dt*cos(psi),0,1,dt*V*cos(psi),dt*sin(psi),0,0,1,0,0,0,0,1;
+
+        // Factor of F P F^T + Q from the Stacked Factors [(F S)^T; Q^(1/2)]
+        Eigen::Matrix<double, 2*StateSize, StateSize> stacked = Eigen::Matrix<double, 2*StateSize, StateSize>::Zero();
+        stacked.topRows<StateSize>() = (F * getSqrtCovariance()).transpose();
+        stacked(StateSize+2,2) = dt*GYRO_STD;
+        stacked(StateSize+3,3) = dt*ACCEL_STD;
+
+        setSqrtCovariance(triangularFactor(stacked));
+    }
+}
+
+void KalmanFilter::handleGPSMeasurement(GPSMeasurement meas)
+{
+    if(isInitialised())
+    {
+        StateVector& state = mutableState();
+        StateMatrix sqrt_cov = getSqrtCovariance();
+
+        Vector2d z = Vector2d::Zero();
+        MeasurementMatrix<2> H;
+        Matrix2d R_sqrt = Matrix2d::Zero();
+
+        z << meas.x,meas.y;
+        H << 1,0,0,0,0,1,0,0;
+        R_sqrt(0,0) = GPS_POS_STD;
+        R_sqrt(1,1) = GPS_POS_STD;
+
+        Vector2d y = z - H * state;
+        squareRootUpdate(state, sqrt_cov, y, H, R_sqrt);
+        setSqrtCovariance(sqrt_cov);
+    }
+    else
+    {
+        StateVector state = StateVector::Zero();
+        StateMatrix sqrt_cov = StateMatrix::Zero();
+
+        state(0) = meas.x;
+        state(1) = meas.y;
+        sqrt_cov(0,0) = GPS_POS_STD;
+        sqrt_cov(1,1) = GPS_POS_STD;
+        sqrt_cov(2,2) = INIT_PSI_STD;
+        sqrt_cov(3,3) = INIT_VEL_STD;
+
+        setState(state);
+        setSqrtCovariance(sqrt_cov);
+    }
+}
+
+Matrix2d KalmanFilter::getVehicleStatePositionCovariance()
+{
+    Matrix2d pos_cov = Matrix2d::Zero();
+    const CovarianceMatrix& cov = getCovariance();
+    if (isInitialised() && cov.size() != 0){pos_cov << cov(0,0), cov(0,1), cov(1,0), cov(1,1);}
+    return pos_cov;
+}
+
+VehicleState KalmanFilter::getVehicleState()
+{
+    if (isInitialised())
+    {
+        const StateVector& state = getState(); // STATE VECTOR [X,Y,PSI,V,...]
+        return VehicleState(state[0],state[1],state[2],state[3]);
+    }
+    return VehicleState();
+}
+
+void KalmanFilter::predictionStep(double dt){}
@@ -2,6 +2,7 @@
 // Advanced Kalman Filtering and Sensor Fusion Course - Extended Kalman Filter
 
 #include "kalmanfilter.h"
+#include "batched_lidar.h"
 #include "utils.h"
 
 // -------------------------------------------------- //
@@ -17,16 +18,24 @@ constexpr double LIDAR_THETA_STD = 0.02;
 
 void KalmanFilter::handleLidarMeasurements(const std::vector<LidarMeasurement>& dataset, const BeaconMap& map)
 {
-    // Assume No Correlation between the Measurements and Update Sequentially
-    for(const auto& meas : dataset) {handleLidarMeasurement(meas, map);}
+    if (getLidarUpdateMode() == LidarUpdateMode::Sequential || !isInitialised())
+    {
+        // Assume No Correlation between the Measurements and Update Sequentially
+        for(const auto& meas : dataset) {handleLidarMeasurement(meas, map);}
+        return;
+    }
+
+    // Batched Update: Stack the Map-Matched Returns and Update Once per Batch
+    batchedLidarUpdate(mutableState(), mutableCovariance(), dataset, map, LIDAR_RANGE_STD, 
+                       LIDAR_THETA_STD);
 }
 
 void KalmanFilter::handleLidarMeasurement(LidarMeasurement meas, const BeaconMap& map)
 {
     if (isInitialised())
     {
-        VectorXd state = getState();
-        MatrixXd cov = getCovariance();
+        StateVector& state = mutableState();
+        CovarianceMatrix& cov = mutableCovariance();
 
         // Implement The Kalman Filter Update Step for the Lidar Measurements in the 
         // section below.
@@ -61,24 +70,22 @@ void KalmanFilter::handleLidarMeasurement(LidarMeasurement meas, const BeaconMap
             R(0, 0) = LIDAR_RANGE_STD * LIDAR_RANGE_STD;
             R(1, 1) = LIDAR_THETA_STD * LIDAR_THETA_STD;
 
-            MatrixXd H = MatrixXd::Zero(2, 4);
+            MeasurementMatrix<2> H = MeasurementMatrix<2>::Zero();
             H(0, 0) = -1.0 / radius * xdiff;
             H(0, 1) = -1.0 / radius * ydiff;
             H(1, 0) = 1.0 / (radius * radius) * ydiff;
             H(1, 1) = -1.0 / (radius * radius) * xdiff;
             H(1, 2) = -1.0;
 
-            MatrixXd S = H * cov * H.transpose() + R;
-            MatrixXd kalmanGain = cov * H.transpose() * S.inverse();
+            Matrix2d S = H * cov * H.transpose() + R;
+            GainMatrix<2> kalmanGain = cov * H.transpose() * S.inverse();
 
             state = state + kalmanGain * innovation;
-            cov = (Matrix4d::Identity() - kalmanGain * H) * cov;
+            cov = (StateMatrix::Identity() - kalmanGain * H) * cov;
         }
 
         // ----------------------------------------------------------------------- //
 
-        setState(state);
-        setCovariance(cov);
     }
 }
 
@@ -86,8 +93,7 @@ void KalmanFilter::predictionStep(GyroMeasurement gyro, double dt)
 {
     if (isInitialised())
     {
-        VectorXd state = getState();
-        MatrixXd cov = getCovariance();
+        StateVector state = getState();
 
         // Implement The Kalman Filter Prediction Step for the system in the  
         // section below.
@@ -102,7 +108,7 @@ void KalmanFilter::predictionStep(GyroMeasurement gyro, double dt)
         state[2] = wrapAngle(state[2] + dt * gyro.psi_dot);
         state[3] = state[3];
 
-        Matrix4d jacobian = Matrix4d::Zero();
+        StateMatrix jacobian = StateMatrix::Zero();
         jacobian(0, 0) = 1.0;
         jacobian(0, 2) = -dt * state[3] * std::sin(state[2]);
         jacobian(0, 3) = dt * std::cos(state[2]);
@@ -112,14 +118,12 @@ void KalmanFilter::predictionStep(GyroMeasurement gyro, double dt)
         jacobian(2, 2) = 1.0;
         jacobian(3, 3) = 1.0;
 
-        Matrix4d Q = Matrix4d::Zero();
+        StateMatrix Q = StateMatrix::Zero();
         Q(2, 2) = dt * dt * GYRO_STD * GYRO_STD;
         Q(3, 3) = dt * dt * ACCEL_STD * ACCEL_STD;
         
-        cov = jacobian * cov * jacobian.transpose() + Q;
+        linearisedPrediction(state, jacobian, Q, 2);
         
-        setState(state);
-        setCovariance(cov);
     } 
 }
 
@@ -129,33 +133,31 @@ void KalmanFilter::handleGPSMeasurement(GPSMeasurement meas)
     // so the EKF update state would just produce the same result.
     if(isInitialised())
     {
-        VectorXd state = getState();
-        MatrixXd cov = getCovariance();
+        StateVector& state = mutableState();
+        CovarianceMatrix& cov = mutableCovariance();
 
-        VectorXd z = Vector2d::Zero();
-        MatrixXd H = MatrixXd(2,4);
-        MatrixXd R = Matrix2d::Zero();
+        Vector2d z = Vector2d::Zero();
+        MeasurementMatrix<2> H;
+        Matrix2d R = Matrix2d::Zero();
 
         z << meas.x,meas.y;
         H << 1,0,0,0,0,1,0,0;
         R(0,0) = GPS_POS_STD*GPS_POS_STD;
         R(1,1) = GPS_POS_STD*GPS_POS_STD;
 
-        VectorXd z_hat = H * state;
-        VectorXd y = z - z_hat;
-        MatrixXd S = H * cov * H.transpose() + R;
-        MatrixXd K = cov*H.transpose()*S.inverse();
+        Vector2d z_hat = H * state;
+        Vector2d y = z - z_hat;
+        Matrix2d S = H * cov * H.transpose() + R;
+        GainMatrix<2> K = cov*H.transpose()*S.inverse();
 
         state = state + K*y;
-        cov = (Matrix4d::Identity() - K*H) * cov;
+        cov = (StateMatrix::Identity() - K*H) * cov;
 
-        setState(state);
-        setCovariance(cov);
     }
     else
     {
-        VectorXd state = Vector4d::Zero();
-        MatrixXd cov = Matrix4d::Zero();
+        StateVector state = StateVector::Zero();
+        CovarianceMatrix cov = CovarianceMatrix::Zero();
 
         state(0) = meas.x;
         state(1) = meas.y;
@@ -173,7 +175,7 @@ void KalmanFilter::handleGPSMeasurement(GPSMeasurement meas)
 Matrix2d KalmanFilter::getVehicleStatePositionCovariance()
 {
     Matrix2d pos_cov = Matrix2d::Zero();
-    MatrixXd cov = getCovariance();
+    const CovarianceMatrix& cov = getCovariance();
     if (isInitialised() && cov.size() != 0){pos_cov << cov(0,0), cov(0,1), cov(1,0), cov(1,1);}
     return pos_cov;
 }
@@ -182,7 +184,7 @@ VehicleState KalmanFilter::getVehicleState()
 {
     if (isInitialised())
     {
-        VectorXd state = getState(); // STATE VECTOR [X,Y,PSI,V,...]
+        const StateVector& state = getState(); // STATE VECTOR [X,Y,PSI,V,...]
         return VehicleState(state[0],state[1],state[2],state[3]);
     }
     return VehicleState();
@@ -30,8 +30,8 @@ void KalmanFilter::predictionStep(double dt)
         // Hint: You can use the constants: INIT_POS_STD, INIT_VEL_STD
         // ----------------------------------------------------------------------- //
         // ENTER YOUR CODE HERE
-            VectorXd state = Vector4d::Zero();
-            MatrixXd cov = Matrix4d::Zero();
+            StateVector state = StateVector::Zero();
+            CovarianceMatrix cov = CovarianceMatrix::Zero();
 
             // Assume the initial position is (X,Y) = (0,0) m
             // Assume the initial velocity is 5 m/s at 45 degrees (VX,VY) = (5*cos(45deg),5*sin(45deg)) m/s
@@ -51,32 +51,27 @@ void KalmanFilter::predictionStep(double dt)
 
     if (isInitialised())
     {
-        VectorXd state = getState();
-        MatrixXd cov = getCovariance();
-
         // Implement The Kalman Filter Prediction Step for the system in the  
         // section below.
         // Hint: You can use the constants: ACCEL_STD
         // ----------------------------------------------------------------------- //
         // ENTER YOUR CODE HERE
         
-        MatrixXd F = Matrix4d();
+        StateMatrix F;
         F << 1,0,dt,0,0,1,0,dt,0,0,1,0,0,0,0,1;
 
-        MatrixXd Q = Matrix2d::Zero();
+        Matrix2d Q = Matrix2d::Zero();
         Q(0,0) = (ACCEL_STD*ACCEL_STD);
         Q(1,1) = (ACCEL_STD*ACCEL_STD);
 
-        MatrixXd L = MatrixXd(4,2);
+        GainMatrix<2> L;
         L << (0.5*dt*dt),0,0,(0.5*dt*dt),dt,0,0,dt;
 
-        state = F * state;
-        cov = F * cov * F.transpose() + L * Q * L.transpose();
+        // Predicts the State and Covariance
+        linearisedPrediction(F * getState(), F, L * Q * L.transpose());
 
         // ----------------------------------------------------------------------- //
 
-        setState(state);
-        setCovariance(cov);
     }
 }
 
@@ -84,8 +79,8 @@ void KalmanFilter::handleGPSMeasurement(GPSMeasurement meas)
 {
     if(isInitialised())
     {
-        VectorXd state = getState();
-        MatrixXd cov = getCovariance();
+        StateVector& state = mutableState();
+        CovarianceMatrix& cov = mutableCovariance();
 
         // Implement The Kalman Filter Update Step for the GPS Measurements in the 
         // section below.
@@ -94,27 +89,25 @@ void KalmanFilter::handleGPSMeasurement(GPSMeasurement meas)
         // ----------------------------------------------------------------------- //
         // ENTER YOUR CODE HERE 
 
-        VectorXd z = Vector2d();
-        MatrixXd H = MatrixXd(2,4);
-        MatrixXd R = Matrix2d::Zero();
+        Vector2d z;
+        MeasurementMatrix<2> H;
+        Matrix2d R = Matrix2d::Zero();
 
         z << meas.x,meas.y;
         H << 1,0,0,0,0,1,0,0;
         R(0,0) = GPS_POS_STD*GPS_POS_STD;
         R(1,1) = GPS_POS_STD*GPS_POS_STD;
 
-        VectorXd z_hat = H * state;
-        VectorXd y = z - z_hat;
-        MatrixXd S = H * cov * H.transpose() + R;
-        MatrixXd K = cov*H.transpose()*S.inverse();
+        Vector2d z_hat = H * state;
+        Vector2d y = z - z_hat;
+        Matrix2d S = H * cov * H.transpose() + R;
+        GainMatrix<2> K = cov*H.transpose()*S.inverse();
 
         state = state + K*y;
-        cov = (MatrixXd::Identity(4,4) - K*H) * cov;
+        cov = (StateMatrix::Identity() - K*H) * cov;
 
         // ----------------------------------------------------------------------- //
 
-        setState(state);
-        setCovariance(cov);
     }
     else
     {
@@ -125,8 +118,8 @@ void KalmanFilter::handleGPSMeasurement(GPSMeasurement meas)
         // Hint: You can use the constants: GPS_POS_STD, INIT_VEL_STD
         // ----------------------------------------------------------------------- //
         // ENTER YOUR CODE HERE
-            VectorXd state = Vector4d::Zero();
-            MatrixXd cov = Matrix4d::Zero();
+            StateVector state = StateVector::Zero();
+            CovarianceMatrix cov = CovarianceMatrix::Zero();
 
             state(0) = meas.x;
             state(1) = meas.y;
@@ -144,7 +137,7 @@ void KalmanFilter::handleGPSMeasurement(GPSMeasurement meas)
 Matrix2d KalmanFilter::getVehicleStatePositionCovariance()
 {
     Matrix2d pos_cov = Matrix2d::Zero();
-    MatrixXd cov = getCovariance();
+    const CovarianceMatrix& cov = getCovariance();
     if (isInitialised() && cov.size() != 0){pos_cov << cov(0,0), cov(0,1), cov(1,0), cov(1,1);}
     return pos_cov;
 }
@@ -153,7 +146,7 @@ VehicleState KalmanFilter::getVehicleState()
 {
     if (isInitialised())
     {
-        VectorXd state = getState(); // STATE VECTOR [X,Y,VX,VY]
+        const StateVector& state = getState(); // STATE VECTOR [X,Y,VX,VY]
         double psi = std::atan2(state[3],state[2]);
         double V = std::sqrt(state[2]*state[2] + state[3]*state[3]);
         return VehicleState(state[0],state[1],psi,V);
@@ -25,8 +25,8 @@ void KalmanFilter::predictionStep(double dt)
         // Hint: You can use the constants: INIT_POS_STD, INIT_VEL_STD
         // ----------------------------------------------------------------------- //
         // ENTER YOUR CODE HERE
-        VectorXd state = Vector4d::Zero();
-        MatrixXd cov = Matrix4d::Zero();
+        StateVector state = StateVector::Zero();
+        CovarianceMatrix cov = CovarianceMatrix::Zero();
 
         // Assume the initial position is (X,Y) = (0,0) m
         // Assume the initial velocity is 5 m/s at 45 degrees (VX,VY) = (5*cos(45deg),5*sin(45deg)) m/s
@@ -43,26 +43,20 @@ void KalmanFilter::predictionStep(double dt)
 
     if (isInitialised())
     {
-        VectorXd state = getState();
-        MatrixXd cov = getCovariance();
-
         // Implement The Kalman Filter Prediction Step for the system in the  
         // section below.
         // Hint: You can use the constants: ACCEL_STD
         // ----------------------------------------------------------------------- //
         // ENTER YOUR CODE HERE
         
-        const MatrixXd F = (Matrix4d() << 1, 0, dt, 0, 0, 1 ,0, dt, 0, 0, 1, 0, 0, 0, 0, 1).finished();
-        const MatrixXd L = (Eigen::MatrixXd(4, 2) << 0.5*dt*dt, 0, 0, 0.5*dt*dt, dt, 0, 0, dt).finished();
+        const StateMatrix F = (StateMatrix() << 1, 0, dt, 0, 0, 1 ,0, dt, 0, 0, 1, 0, 0, 0, 0, 1).finished();
+        const GainMatrix<2> L = (GainMatrix<2>() << 0.5*dt*dt, 0, 0, 0.5*dt*dt, dt, 0, 0, dt).finished();
         const Eigen::DiagonalMatrix<double, 2> Q(ACCEL_STD * ACCEL_STD, ACCEL_STD * ACCEL_STD);
 
-        state = F * state;
-        cov = F*cov*F.transpose() + L*Q*L.transpose();
+        linearisedPrediction(F * getState(), F, L*Q*L.transpose());
 
         // ----------------------------------------------------------------------- //
 
-        setState(state);
-        setCovariance(cov);
     }
 }
 
@@ -70,8 +64,8 @@ void KalmanFilter::handleGPSMeasurement(GPSMeasurement meas)
 {
     if(isInitialised())
     {
-        VectorXd state = getState();
-        MatrixXd cov = getCovariance();
+        StateVector& state = mutableState();
+        CovarianceMatrix& cov = mutableCovariance();
 
         // Implement The Kalman Filter Update Step for the GPS Measurements in the 
         // section below.
@@ -79,21 +73,19 @@ void KalmanFilter::handleGPSMeasurement(GPSMeasurement meas)
         // Hint: You can use the constants: GPS_POS_STD
         // ----------------------------------------------------------------------- //
         // ENTER YOUR CODE HERE 
-        const MatrixXd H = (MatrixXd(2, 4) << 1, 0, 0, 0, 0, 1, 0, 0).finished();
-        const MatrixXd R = (MatrixXd(2, 2) << GPS_POS_STD * GPS_POS_STD, 0, 0, GPS_POS_STD * GPS_POS_STD).finished();
+        const MeasurementMatrix<2> H = (MeasurementMatrix<2>() << 1, 0, 0, 0, 0, 1, 0, 0).finished();
+        const Matrix2d R = (Matrix2d() << GPS_POS_STD * GPS_POS_STD, 0, 0, GPS_POS_STD * GPS_POS_STD).finished();
 
         const Vector2d z = (Vector2d() << meas.x, meas.y).finished();
-        const VectorXd y = z - H * state;
-        const MatrixXd S = H * cov * H.transpose() + R;
-        const MatrixXd K = cov * H.transpose() * S.inverse();
+        const Vector2d y = z - H * state;
+        const Matrix2d S = H * cov * H.transpose() + R;
+        const GainMatrix<2> K = cov*H.transpose()*S.inverse();
 
         state = state + K * y;
-        cov = (MatrixXd::Identity(4, 4) - K * H) * cov;
+        cov = (StateMatrix::Identity() - K * H) * cov;
 
         // ----------------------------------------------------------------------- //
 
-        setState(state);
-        setCovariance(cov);
     }
     else
     {
@@ -104,8 +96,8 @@ void KalmanFilter::handleGPSMeasurement(GPSMeasurement meas)
         // Hint: You can use the constants: GPS_POS_STD, INIT_VEL_STD
         // ----------------------------------------------------------------------- //
         // ENTER YOUR CODE HERE
-            VectorXd state = Vector4d::Zero();
-            MatrixXd cov = Matrix4d::Zero();
+            StateVector state = StateVector::Zero();
+            CovarianceMatrix cov = CovarianceMatrix::Zero();
 
             state << meas.x, meas.y, 0, 0;
             cov(0, 0) = GPS_POS_STD * GPS_POS_STD;
@@ -122,7 +114,7 @@ void KalmanFilter::handleGPSMeasurement(GPSMeasurement meas)
 Matrix2d KalmanFilter::getVehicleStatePositionCovariance()
 {
     Matrix2d pos_cov = Matrix2d::Zero();
-    MatrixXd cov = getCovariance();
+    const CovarianceMatrix& cov = getCovariance();
     if (isInitialised() && cov.size() != 0){pos_cov << cov(0,0), cov(0,1), cov(1,0), cov(1,1);}
     return pos_cov;
 }
@@ -131,7 +123,7 @@ VehicleState KalmanFilter::getVehicleState()
 {
     if (isInitialised())
     {
-        VectorXd state = getState(); // STATE VECTOR [X,Y,VX,VY]
+        const StateVector& state = getState(); // STATE VECTOR [X,Y,VX,VY]
         double psi = std::atan2(state[3],state[2]);
         double V = std::sqrt(state[2]*state[2] + state[3]*state[3]);
         return VehicleState(state[0],state[1],psi,V);
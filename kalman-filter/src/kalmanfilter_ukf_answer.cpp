@@ -7,6 +7,7 @@
 // -Rename this file to "kalmanfilter.cpp" if you want to use this code.
 
 #include "kalmanfilter.h"
+#include "sigma_points.h"
 #include "utils.h"
 
 // ----------------------------------------------------------------------- //
@@ -22,103 +23,73 @@ constexpr double LIDAR_THETA_STD = 0.02;
 
 // ----------------------------------------------------------------------- //
 // USEFUL HELPER FUNCTIONS
-VectorXd normaliseState(VectorXd state)
+// The state is augmented with two noise states for both the prediction step
+// (gyro and acceleration noise) and the lidar update (range and theta noise).
+using AugSigmaPoints = SigmaPoints<6>;
+using StatePoints = AugSigmaPoints::TransformedPoints<4>;
+using LidarPoints = AugSigmaPoints::TransformedPoints<2>;
+
+// Wraps the heading of a state, or of every column of a set of states.
+template <typename Derived>
+typename Derived::PlainObject normaliseState(const Eigen::MatrixBase<Derived>& state)
 {
-    state(2) = wrapAngle(state(2));
-    return state;
+    typename Derived::PlainObject normalised = state;
+    normalised.row(2) = normalised.row(2).unaryExpr([](double psi){return wrapAngle(psi);});
+    return normalised;
 }
-VectorXd normaliseLidarMeasurement(VectorXd meas)
+template <typename Derived>
+typename Derived::PlainObject normaliseLidarMeasurement(const Eigen::MatrixBase<Derived>& meas)
 {
-    meas(1) = wrapAngle(meas(1));
-    return meas;
+    typename Derived::PlainObject normalised = meas;
+    normalised.row(1) = normalised.row(1).unaryExpr([](double theta){return wrapAngle(theta);});
+    return normalised;
 }
-std::vector<VectorXd> generateSigmaPoints(VectorXd state, MatrixXd cov)
-{
-    std::vector<VectorXd> sigmaPoints;
-
-    // ----------------------------------------------------------------------- //
-    // ENTER YOUR CODE HERE
-
-    int numStates = state.size();
-    double lambda = 3.0 - numStates;
-    MatrixXd sqrtCov = cov.llt().matrixL();
-    sigmaPoints.push_back(state);
-    for(int iState = 0; iState < numStates; iState++)
-    {
-        sigmaPoints.push_back(state + sqrt(lambda + numStates) * sqrtCov.col(iState));
-        sigmaPoints.push_back(state - sqrt(lambda + numStates) * sqrtCov.col(iState));
-    }
-
-    // ----------------------------------------------------------------------- //
-
-    return sigmaPoints;
-}
-
-std::vector<double> generateSigmaWeights(unsigned int numStates)
-{
-    std::vector<double> weights;
-
-    // ----------------------------------------------------------------------- //
-    // ENTER YOUR CODE HERE
-    
-    double lambda = 3.0 - numStates;
-    double w0 = lambda / (lambda+numStates);
-    double wi = 0.5/(numStates+lambda);
-    weights.push_back(w0);
-    for(int i = 0; i < 2*numStates; ++i){weights.push_back(wi);}
-
-    // ----------------------------------------------------------------------- //
 
-    return weights;
-}
-
-VectorXd lidarMeasurementModel(VectorXd aug_state, double beaconX, double beaconY)
+LidarPoints lidarMeasurementModel(const AugSigmaPoints::PointMatrix& aug_points, double beaconX, double beaconY)
 {
-    VectorXd z_hat = VectorXd::Zero(2);
+    LidarPoints z_hat;
 
     // ----------------------------------------------------------------------- //
     // ENTER YOUR CODE HERE
 
-    double x = aug_state(0);
-    double y = aug_state(1);
-    double psi = aug_state(2);
-    double range_noise = aug_state(4);
-    double theta_noise = aug_state(5);
+    const auto x = aug_points.row(0).array();
+    const auto y = aug_points.row(1).array();
+    const auto psi = aug_points.row(2).array();
+    const auto range_noise = aug_points.row(4).array();
+    const auto theta_noise = aug_points.row(5).array();
 
-    double delta_x = beaconX - x;
-    double delta_y = beaconY - y;
-    double zhat_range = sqrt(delta_x*delta_x + delta_y*delta_y) + range_noise;
-    double zhat_theta = atan2(delta_y,delta_x) - aug_state[2] + theta_noise;
-    z_hat << zhat_range, zhat_theta;
+    const auto delta_x = beaconX - x;
+    const auto delta_y = beaconY - y;
+    z_hat.row(0).array() = (delta_x*delta_x + delta_y*delta_y).sqrt() + range_noise;
+    z_hat.row(1).array() = delta_y.binaryExpr(delta_x, [](double dy, double dx){return atan2(dy,dx);}) - psi + theta_noise;
 
     // ----------------------------------------------------------------------- //
 
     return z_hat;
 }
 
-VectorXd vehicleProcessModel(VectorXd aug_state, double psi_dot, double dt)
+StatePoints vehicleProcessModel(const AugSigmaPoints::PointMatrix& aug_points, double psi_dot, double dt)
 {
-    VectorXd new_state = VectorXd::Zero(4);
+    StatePoints new_points;
 
     // ----------------------------------------------------------------------- //
     // ENTER YOUR CODE HERE
 
-    double x = aug_state(0);
-    double y = aug_state(1);
-    double psi = aug_state(2);
-    double V = aug_state(3);
-    double psi_dot_noise = aug_state(4);
-    double accel_noise = aug_state(5);
+    const auto x = aug_points.row(0).array();
+    const auto y = aug_points.row(1).array();
+    const auto psi = aug_points.row(2).array();
+    const auto V = aug_points.row(3).array();
+    const auto psi_dot_noise = aug_points.row(4).array();
+    const auto accel_noise = aug_points.row(5).array();
 
-    double x_new = x + dt * V * cos(psi);
-    double y_new = y + dt * V * sin(psi);
-    double psi_new = psi + dt * (psi_dot+psi_dot_noise);
-    double V_new = V + dt * accel_noise;
-    new_state << x_new,y_new,psi_new,V_new;
+    new_points.row(0).array() = x + dt * V * psi.cos();
+    new_points.row(1).array() = y + dt * V * psi.sin();
+    new_points.row(2).array() = psi + dt * (psi_dot + psi_dot_noise);
+    new_points.row(3).array() = V + dt * accel_noise;
 
     // ----------------------------------------------------------------------- //
 
-    return new_state;
+    return new_points;
 }
 
 void KalmanFilter::handleLidarMeasurements(const std::vector<LidarMeasurement>& dataset, const BeaconMap& map)
@@ -131,8 +102,8 @@ void KalmanFilter::handleLidarMeasurement(LidarMeasurement meas, const BeaconMap
 {
     if (isInitialised())
     {
-        VectorXd state = getState();
-        MatrixXd cov = getCovariance();
+        StateVector& state = mutableState();
+        CovarianceMatrix& cov = mutableCovariance();
 
         // Implement The Kalman Filter Update Step for the Lidar Measurements in the 
         // section below.
@@ -149,63 +120,47 @@ void KalmanFilter::handleLidarMeasurement(LidarMeasurement meas, const BeaconMap
         if (meas.id != -1 && map_beacon.id != -1)
         {
             // Generate Measurement Vector
-            VectorXd z = Vector2d::Zero();
+            Vector2d z = Vector2d::Zero();
             z << meas.range, meas.theta;
 
             // Generate Measurement Model Noise Covariance Matrix
-            MatrixXd R = Matrix2d::Zero();
+            Matrix2d R = Matrix2d::Zero();
             R(0,0) = LIDAR_RANGE_STD*LIDAR_RANGE_STD;
             R(1,1) = LIDAR_THETA_STD*LIDAR_THETA_STD;
 
             // Augment the State Vector with Noise States
-            int n_x = state.size();
-            int n_v = 2;
-            int n_z = 2;
-            int n_aug = n_x + n_v;
-            VectorXd x_aug = VectorXd::Zero(n_aug);
-            MatrixXd P_aug = MatrixXd::Zero(n_aug, n_aug);
-            x_aug.head(n_x) = state;
-            P_aug.topLeftCorner(n_x,n_x) = cov;
-            P_aug.bottomRightCorner(n_v,n_v) = R;
+            AugSigmaPoints::Vector x_aug = AugSigmaPoints::Vector::Zero();
+            AugSigmaPoints::Matrix P_aug = AugSigmaPoints::Matrix::Zero();
+            x_aug.head<4>() = state;
+            P_aug.topLeftCorner<4,4>() = cov;
+            P_aug.bottomRightCorner<2,2>() = R;
 
             // Generate Augmented Sigma Points
-            std::vector<VectorXd> sigma_points = generateSigmaPoints(x_aug, P_aug);
-            std::vector<double> sigma_weights = generateSigmaWeights(n_aug);
+            AugSigmaPoints sigma_points;
+            sigma_points.generate(x_aug, P_aug);
 
             // Measurement Model Augmented Sigma Points
-            std::vector<VectorXd> z_sig;
-            for (const auto& sigma_point : sigma_points){z_sig.push_back(lidarMeasurementModel(sigma_point, map_beacon.x, map_beacon.y));}
+            LidarPoints z_sig = lidarMeasurementModel(sigma_points.points(), map_beacon.x, map_beacon.y);
 
             // Calculate Measurement Mean
-            VectorXd z_mean = VectorXd::Zero(n_z);
-            for(unsigned int i = 0; i < z_sig.size(); ++i){z_mean += sigma_weights[i] * z_sig[i];}
+            Vector2d z_mean = AugSigmaPoints::mean(z_sig);
 
             // Calculate Innovation Covariance
-            MatrixXd Py = MatrixXd::Zero(n_z,n_z);
-            for(unsigned int i = 0; i < z_sig.size(); ++i)
-            {
-                VectorXd diff = normaliseLidarMeasurement(z_sig[i] - z_mean);
-                Py += sigma_weights[i] * diff * diff.transpose();
-            }
+            LidarPoints z_diff = normaliseLidarMeasurement(z_sig.colwise() - z_mean);
+            Matrix2d Py = AugSigmaPoints::covariance(z_diff, z_diff);
 
             // Calculate Cross Covariance
-            MatrixXd Pxy = MatrixXd::Zero(n_x, n_z);
-            for(unsigned int i = 0; i < 2*n_x + 1; ++i)
-            {
-                VectorXd x_diff = normaliseState(sigma_points[i].head(n_x) - state);
-                VectorXd z_diff = normaliseLidarMeasurement(z_sig[i] - z_mean);
-                Pxy += sigma_weights[i] * x_diff * z_diff.transpose();
-            }
-
-            MatrixXd K = Pxy*Py.inverse();
-            VectorXd y = normaliseLidarMeasurement(z - z_mean);
+            // Sums all 13 points; the noise-perturbing points have zero x_diff columns.
+            StatePoints x_diff = normaliseState(sigma_points.points().topRows<4>().colwise() - state);
+            GainMatrix<2> Pxy = AugSigmaPoints::covariance(x_diff, z_diff);
+
+            GainMatrix<2> K = Pxy*Py.inverse();
+            Vector2d y = normaliseLidarMeasurement(z - z_mean);
             state = state + K*y;
             cov = cov - K * Py * K.transpose();   
         }
         // ----------------------------------------------------------------------- //
 
-        setState(state);
-        setCovariance(cov);
     }
 }
 
@@ -213,8 +168,8 @@ void KalmanFilter::predictionStep(GyroMeasurement gyro, double dt)
 {
     if (isInitialised())
     {
-        VectorXd state = getState();
-        MatrixXd cov = getCovariance();
+        StateVector& state = mutableState();
+        CovarianceMatrix& cov = mutableCovariance();
 
         // Implement The Kalman Filter Prediction Step for the system in the  
         // section below.
@@ -227,89 +182,66 @@ void KalmanFilter::predictionStep(GyroMeasurement gyro, double dt)
         // ENTER YOUR CODE HERE
 
         // Generate Q Matrix
-        MatrixXd Q = Matrix2d::Zero();
+        Matrix2d Q = Matrix2d::Zero();
         Q(0,0) = GYRO_STD*GYRO_STD;
         Q(1,1) = ACCEL_STD*ACCEL_STD;
 
         // Augment the State Vector with Noise States
-        int n_x = state.size();
-        int n_w = 2;
-        int n_aug = n_x + n_w;
-        VectorXd x_aug = VectorXd::Zero(n_aug);
-        MatrixXd P_aug = MatrixXd::Zero(n_aug, n_aug);
-        x_aug.head(n_x) = state;
-        P_aug.topLeftCorner(n_x,n_x) = cov;
-        P_aug.bottomRightCorner(n_w,n_w) = Q;
+        AugSigmaPoints::Vector x_aug = AugSigmaPoints::Vector::Zero();
+        AugSigmaPoints::Matrix P_aug = AugSigmaPoints::Matrix::Zero();
+        x_aug.head<4>() = state;
+        P_aug.topLeftCorner<4,4>() = cov;
+        P_aug.bottomRightCorner<2,2>() = Q;
 
         // Generate Augmented Sigma Points
-        std::vector<VectorXd> sigma_points = generateSigmaPoints(x_aug, P_aug);
-        std::vector<double> sigma_weights = generateSigmaWeights(n_aug);
+        AugSigmaPoints sigma_points;
+        sigma_points.generate(x_aug, P_aug);
 
         // Predict Augmented Sigma Points
-        std::vector<VectorXd> sigma_points_predict;
-        for (const auto& sigma_point : sigma_points)
-        {
-            sigma_points_predict.push_back(vehicleProcessModel(sigma_point, gyro.psi_dot, dt));
-        }
+        StatePoints sigma_points_predict = vehicleProcessModel(sigma_points.points(), gyro.psi_dot, dt);
 
         // Calculate Mean
-        state = VectorXd::Zero(n_x);
-        for(unsigned int i = 0; i < sigma_points_predict.size(); ++i)
-        {
-            state += sigma_weights[i] * sigma_points_predict[i];
-        }
-        state = normaliseState(state);
+        state = normaliseState(AugSigmaPoints::mean(sigma_points_predict));
 
         // Calculate Covariance
-        cov = MatrixXd::Zero(n_x,n_x);
-        for(unsigned int i = 0; i < sigma_points_predict.size(); ++i)
-        {
-            VectorXd diff = normaliseState(sigma_points_predict[i] - state);
-            cov += sigma_weights[i] * diff * diff.transpose();
-        }
+        StatePoints diff = normaliseState(sigma_points_predict.colwise() - state);
+        cov = AugSigmaPoints::covariance(diff, diff);
       
         // ----------------------------------------------------------------------- //
 
-        setState(state);
-        setCovariance(cov);
     } 
 }
-
-
-
 void KalmanFilter::handleGPSMeasurement(GPSMeasurement meas)
 {
     // All this code is the same as the LKF as the measurement model is linear
     // so the UKF update state would just produce the same result.
     if(isInitialised())
     {
-        VectorXd state = getState();
-        MatrixXd cov = getCovariance();
+        StateVector& state = mutableState();
+        CovarianceMatrix& cov = mutableCovariance();
 
-        VectorXd z = Vector2d::Zero();
-        MatrixXd H = MatrixXd(2,4);
-        MatrixXd R = Matrix2d::Zero();
+        Vector2d z = Vector2d::Zero();
+        MeasurementMatrix<2> H;
+        Matrix2d R = Matrix2d::Zero();
 
         z << meas.x,meas.y;
         H << 1,0,0,0,0,1,0,0;
         R(0,0) = GPS_POS_STD*GPS_POS_STD;
         R(1,1) = GPS_POS_STD*GPS_POS_STD;
 
-        VectorXd z_hat = H * state;
-        VectorXd y = z - z_hat;
-        MatrixXd S = H * cov * H.transpose() + R;
-        MatrixXd K = cov*H.transpose()*S.inverse();
+        Vector2d z_hat = H * state;
+        Vector2d y = z - z_hat;
+        Matrix2d S = H * cov * H.transpose() + R;
+        GainMatrix<2> K = cov*H.transpose()*S.inverse();
 
         state = state + K*y;
-        cov = (Matrix4d::Identity() - K*H) * cov;
+        cov = (StateMatrix::Identity() - K*H) * cov;
 
-        setState(state);
-        setCovariance(cov);
     }
     else
     {
-        VectorXd state = Vector4d::Zero();
-        MatrixXd cov = Matrix4d::Zero();
+        StateVector state = StateVector::Zero();
+        CovarianceMatrix cov = CovarianceMatrix::Zero();
 
         state(0) = meas.x;
         state(1) = meas.y;
@@ -326,7 +258,7 @@ void KalmanFilter::handleGPSMeasurement(GPSMeasurement meas)
 Matrix2d KalmanFilter::getVehicleStatePositionCovariance()
 {
     Matrix2d pos_cov = Matrix2d::Zero();
-    MatrixXd cov = getCovariance();
+    const CovarianceMatrix& cov = getCovariance();
     if (isInitialised() && cov.size() != 0){pos_cov << cov(0,0), cov(0,1), cov(1,0), cov(1,1);}
     return pos_cov;
 }
@@ -335,7 +267,7 @@ VehicleState KalmanFilter::getVehicleState()
 {
     if (isInitialised())
     {
-        VectorXd state = getState(); // STATE VECTOR [X,Y,PSI,V,...]
+        const StateVector& state = getState(); // STATE VECTOR [X,Y,PSI,V,...]
         return VehicleState(state[0],state[1],state[2],state[3]);
     }
     return VehicleState();
@@ -0,0 +1,254 @@
+// ------------------------------------------------------------------------------- //
+// Advanced Kalman Filtering and Sensor Fusion Course - Square-Root Unscented Kalman Filter
+//
+// ####### ANSWER FILE #######
+//
+// Same models as the UKF answer, but the filter propagates the Cholesky factor S of
+// the covariance (P = S S^T). The sigma points come straight from S, so there is no
+// factorisation per step, and the predicted and innovation factors are rebuilt from
+// the sigma point deviations with a QR and a rank-one update (see square_root.h).
+//
+// Usage:
+// -Rename this file to "kalmanfilter.cpp" if you want to use this code.
+
+#include "kalmanfilter.h"
+#include "sigma_points.h"
+#include "square_root.h"
+#include "utils.h"
+
+// ----------------------------------------------------------------------- //
+// YOU CAN USE AND MODIFY THESE CONSTANTS HERE
+constexpr double ACCEL_STD = 1.0;
+constexpr double GYRO_STD = 0.01/180.0 * M_PI;
+constexpr double INIT_VEL_STD = 10.0;
+constexpr double INIT_PSI_STD = 45.0/180.0 * M_PI;
+constexpr double GPS_POS_STD = 3.0;
+constexpr double LIDAR_RANGE_STD = 3.0;
+constexpr double LIDAR_THETA_STD = 0.02;
+// ----------------------------------------------------------------------- //
+
+// ----------------------------------------------------------------------- //
+// USEFUL HELPER FUNCTIONS
+// The state is augmented with two noise states for both the prediction step
+// (gyro and acceleration noise) and the lidar update (range and theta noise).
+using AugSigmaPoints = SigmaPoints<6>;
+using StatePoints = AugSigmaPoints::TransformedPoints<4>;
+using LidarPoints = AugSigmaPoints::TransformedPoints<2>;
+
+// Wraps the heading of a state, or of every column of a set of states.
+template <typename Derived>
+typename Derived::PlainObject normaliseState(const Eigen::MatrixBase<Derived>& state)
+{
+    typename Derived::PlainObject normalised = state;
+    normalised.row(2) = normalised.row(2).unaryExpr([](double psi){return wrapAngle(psi);});
+    return normalised;
+}
+template <typename Derived>
+typename Derived::PlainObject normaliseLidarMeasurement(const Eigen::MatrixBase<Derived>& meas)
+{
+    typename Derived::PlainObject normalised = meas;
+    normalised.row(1) = normalised.row(1).unaryExpr([](double theta){return wrapAngle(theta);});
+    return normalised;
+}
+
+LidarPoints lidarMeasurementModel(const AugSigmaPoints::PointMatrix& aug_points, double beaconX, double beaconY)
+{
+    LidarPoints z_hat;
+
+    const auto x = aug_points.row(0).array();
+    const auto y = aug_points.row(1).array();
+    const auto psi = aug_points.row(2).array();
+    const auto range_noise = aug_points.row(4).array();
+    const auto theta_noise = aug_points.row(5).array();
+
+    const auto delta_x = beaconX - x;
+    const auto delta_y = beaconY - y;
+    z_hat.row(0).array() = (delta_x*delta_x + delta_y*delta_y).sqrt() + range_noise;
+    z_hat.row(1).array() = delta_y.binaryExpr(delta_x, [](double dy, double dx){return atan2(dy,dx);}) - psi + theta_noise;
+
+    return z_hat;
+}
+
+StatePoints vehicleProcessModel(const AugSigmaPoints::PointMatrix& aug_points, double psi_dot, double dt)
+{
+    StatePoints new_points;
+
+    const auto x = aug_points.row(0).array();
+    const auto y = aug_points.row(1).array();
+    const auto psi = aug_points.row(2).array();
+    const auto V = aug_points.row(3).array();
+    const auto psi_dot_noise = aug_points.row(4).array();
+    const auto accel_noise = aug_points.row(5).array();
+
+    new_points.row(0).array() = x + dt * V * psi.cos();
+    new_points.row(1).array() = y + dt * V * psi.sin();
+    new_points.row(2).array() = psi + dt * (psi_dot + psi_dot_noise);
+    new_points.row(3).array() = V + dt * accel_noise;
+
+    return new_points;
+}
+
+// Augmented covariance factor: S and the noise standard deviations on the diagonal (the noise is uncorrelated).
+AugSigmaPoints::Matrix augmentSqrtCovariance(const Matrix4d& sqrt_cov, double noise_std_a, double noise_std_b)
+{
+    AugSigmaPoints::Matrix S_aug = AugSigmaPoints::Matrix::Zero();
+    S_aug.topLeftCorner<4,4>() = sqrt_cov;
+    S_aug(4,4) = noise_std_a;
+    S_aug(5,5) = noise_std_b;
+    return S_aug;
+}
+// ----------------------------------------------------------------------- //
+
+void KalmanFilter::handleLidarMeasurements(const std::vector<LidarMeasurement>& dataset, const BeaconMap& map)
+{
+    // Assume No Correlation between the Measurements and Update Sequentially
+    for(const auto& meas : dataset) {handleLidarMeasurement(meas, map);}
+}
+
+void KalmanFilter::handleLidarMeasurement(LidarMeasurement meas, const BeaconMap& map)
+{
+    if (isInitialised())
+    {
+        StateVector& state = mutableState();
+
+        BeaconData map_beacon = map.getBeaconWithId(meas.id); // Match Beacon with built in Data Association Id
+        if (meas.id != -1 && map_beacon.id != -1)
+        {
+            // Generate Measurement Vector
+            Vector2d z = Vector2d::Zero();
+            z << meas.range, meas.theta;
+
+            // Augment the State Vector with Noise States
+            AugSigmaPoints::Vector x_aug = AugSigmaPoints::Vector::Zero();
+            x_aug.head<4>() = state;
+
+            // Generate Augmented Sigma Points Directly from the Factor
+            AugSigmaPoints sigma_points;
+            sigma_points.generateFromFactor(x_aug, augmentSqrtCovariance(getSqrtCovariance(), LIDAR_RANGE_STD, LIDAR_THETA_STD));
+
+            // Measurement Model Augmented Sigma Points
+            LidarPoints z_sig = lidarMeasurementModel(sigma_points.points(), map_beacon.x, map_beacon.y);
+
+            // Calculate Measurement Mean
+            Vector2d z_mean = AugSigmaPoints::mean(z_sig);
+
+            // Calculate Innovation Covariance Factor
+            LidarPoints z_diff = normaliseLidarMeasurement(z_sig.colwise() - z_mean);
+            Matrix2d Sy;
+            if (!AugSigmaPoints::covarianceFactor(z_diff, Sy)){Sy = AugSigmaPoints::covariance(z_diff, z_diff).llt().matrixL();}
+
+            // Calculate Cross Covariance
+            StatePoints x_diff = normaliseState(sigma_points.points().topRows<4>().colwise() - state);
+            GainMatrix<2> Pxy = AugSigmaPoints::covariance(x_diff, z_diff);
+
+            // K = Pxy (Sy Sy^T)^-1, with Two Triangular Solves
+            Eigen::Matrix<double, 2, 4> Kt = Sy.triangularView<Eigen::Lower>().solve(Pxy.transpose());
+            Sy.transpose().triangularView<Eigen::Upper>().solveInPlace(Kt);
+            GainMatrix<2> K = Kt.transpose();
+            Vector2d y = normaliseLidarMeasurement(z - z_mean);
+            state = state + K*y;
+
+            // P+ = P - (K Sy)(K Sy)^T: One Rank-One Downdate per Measurement Component
+            StateMatrix sqrt_cov = getSqrtCovariance();
+            GainMatrix<2> U = K * Sy;
+            bool downdated = true;
+            for (int i = 0; i < 2 && downdated; ++i){downdated = choleskyRankOneUpdate<4>(sqrt_cov, U.col(i), -1.0);}
+            if (!downdated)
+            {
+                // Only Reached when Rounding makes P+ Indefinite: Factorise the Full Update Instead
+                sqrt_cov = (getCovariance() - U * U.transpose()).llt().matrixL();
+            }
+            setSqrtCovariance(sqrt_cov);
+        }
+    }
+}
+
+void KalmanFilter::predictionStep(GyroMeasurement gyro, double dt)
+{
+    if (isInitialised())
+    {
+        StateVector& state = mutableState();
+
+        // Augment the State Vector with Noise States
+        AugSigmaPoints::Vector x_aug = AugSigmaPoints::Vector::Zero();
+        x_aug.head<4>() = state;
+
+        // Generate Augmented Sigma Points Directly from the Factor
+        AugSigmaPoints sigma_points;
+        sigma_points.generateFromFactor(x_aug, augmentSqrtCovariance(getSqrtCovariance(), GYRO_STD, ACCEL_STD));
+
+        // Predict Augmented Sigma Points
+        StatePoints sigma_points_predict = vehicleProcessModel(sigma_points.points(), gyro.psi_dot, dt);
+
+        // Calculate Mean
+        state = normaliseState(AugSigmaPoints::mean(sigma_points_predict));
+
+        // Calculate Covariance Factor
+        StatePoints diff = normaliseState(sigma_points_predict.colwise() - state);
+        StateMatrix sqrt_cov;
+        if (!AugSigmaPoints::covarianceFactor(diff, sqrt_cov))
+        {
+            // Only Reached when Rounding makes the Predicted Covariance Indefinite
+            sqrt_cov = AugSigmaPoints::covariance(diff, diff).llt().matrixL();
+        }
+        setSqrtCovariance(sqrt_cov);
+    }
+}
+
+void KalmanFilter::handleGPSMeasurement(GPSMeasurement meas)
+{
+    // The measurement model is linear, so this is the same update as the square-root EKF.
+    if(isInitialised())
+    {
+        StateVector& state = mutableState();
+        StateMatrix sqrt_cov = getSqrtCovariance();
+
+        Vector2d z = Vector2d::Zero();
+        MeasurementMatrix<2> H;
+        Matrix2d R_sqrt = Matrix2d::Zero();
+
+        z << meas.x,meas.y;
+        H << 1,0,0,0,0,1,0,0;
+        R_sqrt(0,0) = GPS_POS_STD;
+        R_sqrt(1,1) = GPS_POS_STD;
+
+        Vector2d y = z - H * state;
+        squareRootUpdate(state, sqrt_cov, y, H, R_sqrt);
+        setSqrtCovariance(sqrt_cov);
+    }
+    else
+    {
+        StateVector state = StateVector::Zero();
+        StateMatrix sqrt_cov = StateMatrix::Zero();
+
+        state(0) = meas.x;
+        state(1) = meas.y;
+        sqrt_cov(0,0) = GPS_POS_STD;
+        sqrt_cov(1,1) = GPS_POS_STD;
+        sqrt_cov(2,2) = INIT_PSI_STD;
+        sqrt_cov(3,3) = INIT_VEL_STD;
+
+        setState(state);
+        setSqrtCovariance(sqrt_cov);
+    }
+}
+
+Matrix2d KalmanFilter::getVehicleStatePositionCovariance()
+{
+    Matrix2d pos_cov = Matrix2d::Zero();
+    const CovarianceMatrix& cov = getCovariance();
+    if (isInitialised() && cov.size() != 0){pos_cov << cov(0,0), cov(0,1), cov(1,0), cov(1,1);}
+    return pos_cov;
+}
+
+VehicleState KalmanFilter::getVehicleState()
+{
+    if (isInitialised())
+    {
+        const StateVector& state = getState(); // STATE VECTOR [X,Y,PSI,V,...]
+        return VehicleState(state[0],state[1],state[2],state[3]);
+    }
+    return VehicleState();
+}
+
+void KalmanFilter::predictionStep(double dt){}
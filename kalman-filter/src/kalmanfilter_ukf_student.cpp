@@ -7,6 +7,7 @@
 // -Rename this file to "kalmanfilter.cpp" if you want to use this code.
 
 #include "kalmanfilter.h"
+#include "sigma_points.h"
 #include "utils.h"
 
 // -------------------------------------------------- //
@@ -22,74 +23,51 @@ constexpr double LIDAR_THETA_STD = 0.02;
 
 // ----------------------------------------------------------------------- //
 // USEFUL HELPER FUNCTIONS
-VectorXd normaliseState(VectorXd state)
-{
-    state(2) = wrapAngle(state(2));
-    return state;
-}
-
-VectorXd normaliseLidarMeasurement(VectorXd meas)
-{
-    meas(1) = wrapAngle(meas(1));
-    return meas;
-}
+using AugSigmaPoints = SigmaPoints<6>; // [PX, PY, PSI, V] and two noise states
+using StatePoints = AugSigmaPoints::TransformedPoints<4>;
+using LidarPoints = AugSigmaPoints::TransformedPoints<2>;
 
-std::vector<VectorXd> generateSigmaPoints(VectorXd state, MatrixXd cov)
+template <typename Derived>
+typename Derived::PlainObject normaliseState(const Eigen::MatrixBase<Derived>& state)
 {
-    std::vector<VectorXd> sigmaPoints;
-
-    sigmaPoints.push_back(state);
-
-    int n = state.size();
-    double k = 3.0 - n;
-    MatrixXd covSqrt = cov.llt().matrixL();
-    MatrixXd delta = std::sqrt(n + k) * covSqrt;
-    
-    for (int i = 0; i < n; i++) {
-        sigmaPoints.push_back(state + delta.col(i));
-        sigmaPoints.push_back(state - delta.col(i));
-    }
-
-    return sigmaPoints;
+    typename Derived::PlainObject normalised = state;
+    normalised.row(2) = normalised.row(2).unaryExpr([](double psi) { return wrapAngle(psi); });
+    return normalised;
 }
 
-std::vector<double> generateSigmaWeights(unsigned int numStates)
+template <typename Derived>
+typename Derived::PlainObject normaliseLidarMeasurement(const Eigen::MatrixBase<Derived>& meas)
 {
-    std::vector<double> weights;
-
-    double k = 3.0 - numStates;
-
-    weights.push_back(k / (numStates + k));
-
-    for (size_t i = 1; i <= 2*numStates; i++) {
-        weights.push_back(1 / (2*(numStates + k)));
-    }
-
-    return weights;
+    typename Derived::PlainObject normalised = meas;
+    normalised.row(1) = normalised.row(1).unaryExpr([](double theta) { return wrapAngle(theta); });
+    return normalised;
 }
 
-VectorXd lidarMeasurementModel(VectorXd aug_state, double beaconX, double beaconY)
+LidarPoints lidarMeasurementModel(const AugSigmaPoints::PointMatrix& aug_points, double beaconX, double beaconY)
 {
-    Vector2d z_hat = Vector2d::Zero();
+    LidarPoints z_hat;
 
-    const double xdiff = beaconX - aug_state(0);
-    const double ydiff = beaconY - aug_state(1);
-    z_hat(0) = std::sqrt(xdiff*xdiff + ydiff*ydiff) + aug_state(4);
-    z_hat(1) = std::atan2(ydiff, xdiff) - aug_state(2) + aug_state(5);
+    const auto xdiff = beaconX - aug_points.row(0).array();
+    const auto ydiff = beaconY - aug_points.row(1).array();
+    z_hat.row(0).array() = (xdiff*xdiff + ydiff*ydiff).sqrt() + aug_points.row(4).array();
+    z_hat.row(1).array() = ydiff.binaryExpr(xdiff, [](double y, double x) { return std::atan2(y, x); })
+        - aug_points.row(2).array() + aug_points.row(5).array();
 
     return z_hat;
 }
 
-VectorXd vehicleProcessModel(VectorXd aug_state, double psi_dot, double dt)
+StatePoints vehicleProcessModel(const AugSigmaPoints::PointMatrix& aug_points, double psi_dot, double dt)
 {
-    VectorXd new_state = VectorXd::Zero(4);
+    StatePoints new_points;
 
-    new_state[0] = aug_state[0] + dt * aug_state[3] * std::cos(aug_state[2]);
-    new_state[1] = aug_state[1] + dt * aug_state[3] * std::sin(aug_state[2]);
-    new_state[2] = aug_state[2] + dt * (psi_dot + aug_state[4]);
-    new_state[3] = aug_state[3] + dt * aug_state[5];
+    const auto psi = aug_points.row(2).array();
+    const auto v = aug_points.row(3).array();
+    new_points.row(0).array() = aug_points.row(0).array() + dt * v * psi.cos();
+    new_points.row(1).array() = aug_points.row(1).array() + dt * v * psi.sin();
+    new_points.row(2).array() = psi + dt * (psi_dot + aug_points.row(4).array());
+    new_points.row(3).array() = v + dt * aug_points.row(5).array();
 
-    return new_state;
+    return new_points;
 }
 // ----------------------------------------------------------------------- //
 
@@ -97,8 +75,8 @@ void KalmanFilter::handleLidarMeasurement(LidarMeasurement meas, const BeaconMap
 {
     if (isInitialised())
     {
-        VectorXd state = getState();
-        MatrixXd cov = getCovariance();
+        StateVector& state = mutableState();
+        CovarianceMatrix& cov = mutableCovariance();
 
         // Implement The Kalman Filter Update Step for the Lidar Measurements in the 
         // section below.
@@ -112,36 +90,24 @@ void KalmanFilter::handleLidarMeasurement(LidarMeasurement meas, const BeaconMap
         BeaconData map_beacon = map.getBeaconWithId(meas.id); // Match Beacon with built in Data Association Id
         if (meas.id != -1 && map_beacon.id != -1) // Check that we have a valid beacon match
         {
-            const size_t nz = 2;
-            const size_t nx = state.size();
-            const size_t na = nx + 2;
-
             // Augmentation of state and covariance.
-            VectorXd augState = VectorXd::Zero(na);
-            augState.head(nx) = state;
+            AugSigmaPoints::Vector augState = AugSigmaPoints::Vector::Zero();
+            augState.head<4>() = state;
 
-            MatrixXd augCov = MatrixXd::Zero(na, na);
-            augCov.topLeftCorner(nx, nx) = cov;
-            augCov(nx, nx) = LIDAR_RANGE_STD * LIDAR_RANGE_STD;
-            augCov(nx + 1, nx + 1) = LIDAR_THETA_STD * LIDAR_THETA_STD;
+            AugSigmaPoints::Matrix augCov = AugSigmaPoints::Matrix::Zero();
+            augCov.topLeftCorner<4, 4>() = cov;
+            augCov(4, 4) = LIDAR_RANGE_STD * LIDAR_RANGE_STD;
+            augCov(5, 5) = LIDAR_THETA_STD * LIDAR_THETA_STD;
 
-            // Generate sigma points and weights.
-            auto sigmaPoints = generateSigmaPoints(augState, augCov);
-            auto weights = generateSigmaWeights(na);
+            // Generate sigma points.
+            AugSigmaPoints sigmaPoints;
+            sigmaPoints.generate(augState, augCov);
 
             // Transform sigma points using lidar model.
-            std::vector<Vector2d> transformedPoints;
-            std::transform(sigmaPoints.begin(), sigmaPoints.end(), std::back_inserter(transformedPoints), 
-                [=](const auto &p) {
-                    return lidarMeasurementModel(p, map_beacon.x, map_beacon.y);
-                }
-            );
+            LidarPoints transformedPoints = lidarMeasurementModel(sigmaPoints.points(), map_beacon.x, map_beacon.y);
 
             // Calculate the mean of the transformed sigma points
-            Vector2d zhat = Vector2d::Zero();
-            for (size_t i = 0; i < transformedPoints.size(); i++) {
-                zhat += weights[i] * transformedPoints[i];
-            }
+            Vector2d zhat = AugSigmaPoints::mean(transformedPoints);
             
             // Calculate the innovation.
             Vector2d z = Vector2d::Zero();
@@ -149,28 +115,19 @@ void KalmanFilter::handleLidarMeasurement(LidarMeasurement meas, const BeaconMap
             Vector2d innovation = normaliseLidarMeasurement(z - zhat);
 
             // Calculate the covariance of the transformed signal.
-            Matrix2d innovationcov = Matrix2d::Zero();
-            for (size_t i = 0; i < transformedPoints.size(); i++) {
-                Vector2d err = normaliseLidarMeasurement(transformedPoints[i] - zhat);
-                innovationcov += weights[i] * err * err.transpose();
-            }
+            LidarPoints errz = normaliseLidarMeasurement(transformedPoints.colwise() - zhat);
+            Matrix2d innovationcov = AugSigmaPoints::covariance(errz, errz);
 
             // Calculate the cross covariance
-            MatrixXd crosscov = MatrixXd::Zero(nx, nz);
-            for (size_t i = 0; i < transformedPoints.size(); i++) {
-                VectorXd errz = normaliseLidarMeasurement(transformedPoints[i] - zhat);
-                VectorXd errx = normaliseState(sigmaPoints[i].head(nx) - state);
-                crosscov += weights[i] * errx * errz.transpose();
-            }
+            StatePoints errx = normaliseState(sigmaPoints.points().topRows<4>().colwise() - state);
+            GainMatrix<2> crosscov = AugSigmaPoints::covariance(errx, errz);
 
             // UKF update step equations.
-            MatrixXd kalmanGain = crosscov * innovationcov.inverse();
+            GainMatrix<2> kalmanGain = crosscov * innovationcov.inverse();
             state += kalmanGain * innovation;
             cov -= kalmanGain * innovationcov * kalmanGain.transpose();
         }
 
-        setState(state);
-        setCovariance(cov);
     }
 }
 
@@ -178,8 +135,8 @@ void KalmanFilter::predictionStep(GyroMeasurement gyro, double dt)
 {
     if (isInitialised())
     {
-        VectorXd state = getState();
-        MatrixXd cov = getCovariance();
+        StateVector& state = mutableState();
+        CovarianceMatrix& cov = mutableCovariance();
 
         // Implement The Kalman Filter Prediction Step for the system in the  
         // section below.
@@ -189,40 +146,23 @@ void KalmanFilter::predictionStep(GyroMeasurement gyro, double dt)
         // HINT: Use the normaliseState() function to always keep angle values within correct range.
         // HINT: Do NOT normalise during sigma point calculation!
 
-        int nx = state.size();
-        int nw = 2;
-        int na = nx + nw;
-
-        VectorXd augState = VectorXd::Zero(na);
-        augState.head(nx) = state;
-
-        MatrixXd covAug = MatrixXd::Zero(na, na);
-        covAug.topLeftCorner(nx, nx) = cov;
-        covAug(nx, nx) =  GYRO_STD * GYRO_STD;
-        covAug(nx + 1, nx + 1) =  ACCEL_STD * ACCEL_STD;
-
-        auto sigmaPoints = generateSigmaPoints(augState, covAug);
-        auto weights = generateSigmaWeights(na);
-        std::vector<VectorXd> transformedPoints;
-        std::transform(sigmaPoints.begin(), sigmaPoints.end(), std::back_inserter(transformedPoints), 
-            [=](const auto &p) {
-                return vehicleProcessModel(p, gyro.psi_dot, dt);
-            }
-        );
-
-        state = VectorXd::Zero(nx);
-        for (size_t i = 0; i < transformedPoints.size(); i++) {
-            state = state + weights[i] * transformedPoints[i];
-        }
+        AugSigmaPoints::Vector augState = AugSigmaPoints::Vector::Zero();
+        augState.head<4>() = state;
 
-        cov = MatrixXd::Zero(nx, nx);
-        for (size_t i = 0; i < transformedPoints.size(); i++) {
-            VectorXd err = normaliseState(transformedPoints[i] - state);
-            cov = cov + weights[i] * err * err.transpose();
-        }
+        AugSigmaPoints::Matrix covAug = AugSigmaPoints::Matrix::Zero();
+        covAug.topLeftCorner<4, 4>() = cov;
+        covAug(4, 4) =  GYRO_STD * GYRO_STD;
+        covAug(5, 5) =  ACCEL_STD * ACCEL_STD;
+
+        AugSigmaPoints sigmaPoints;
+        sigmaPoints.generate(augState, covAug);
+        StatePoints transformedPoints = vehicleProcessModel(sigmaPoints.points(), gyro.psi_dot, dt);
+
+        state = AugSigmaPoints::mean(transformedPoints);
+
+        StatePoints err = normaliseState(transformedPoints.colwise() - state);
+        cov = AugSigmaPoints::covariance(err, err);
 
-        setState(state);
-        setCovariance(cov);
     } 
 }
 
@@ -232,28 +172,26 @@ void KalmanFilter::handleGPSMeasurement(GPSMeasurement meas)
     // so the UKF update state would just produce the same result.
     if(isInitialised())
     {
-        VectorXd state = getState();
-        MatrixXd cov = getCovariance();
+        StateVector& state = mutableState();
+        CovarianceMatrix& cov = mutableCovariance();
 
-        VectorXd z = Vector2d::Zero();
-        MatrixXd H = MatrixXd(2,4);
-        MatrixXd R = Matrix2d::Zero();
+        Vector2d z = Vector2d::Zero();
+        MeasurementMatrix<2> H;
+        Matrix2d R = Matrix2d::Zero();
 
         z << meas.x,meas.y;
         H << 1,0,0,0,0,1,0,0;
         R(0,0) = GPS_POS_STD*GPS_POS_STD;
         R(1,1) = GPS_POS_STD*GPS_POS_STD;
 
-        VectorXd z_hat = H * state;
-        VectorXd y = z - z_hat;
-        MatrixXd S = H * cov * H.transpose() + R;
-        MatrixXd K = cov*H.transpose()*S.inverse();
+        Vector2d z_hat = H * state;
+        Vector2d y = z - z_hat;
+        Matrix2d S = H * cov * H.transpose() + R;
+        GainMatrix<2> K = cov*H.transpose()*S.inverse();
 
         state = state + K*y;
-        cov = (MatrixXd::Identity(4,4) - K*H) * cov;
+        cov = (StateMatrix::Identity() - K*H) * cov;
 
-        setState(state);
-        setCovariance(cov);
     }
     else
     {
@@ -262,8 +200,8 @@ void KalmanFilter::handleGPSMeasurement(GPSMeasurement meas)
         // ----------------------------------------------------------------------- //
         // YOU ARE FREE TO MODIFY THE FOLLOWING CODE HERE
 
-        VectorXd state = Vector4d::Zero();
-        MatrixXd cov = Matrix4d::Zero();
+        StateVector state = StateVector::Zero();
+        CovarianceMatrix cov = CovarianceMatrix::Zero();
 
         state(0) = meas.x;
         state(1) = meas.y;
@@ -288,7 +226,7 @@ void KalmanFilter::handleLidarMeasurements(const std::vector<LidarMeasurement>&
 Matrix2d KalmanFilter::getVehicleStatePositionCovariance()
 {
     Matrix2d pos_cov = Matrix2d::Zero();
-    MatrixXd cov = getCovariance();
+    const CovarianceMatrix& cov = getCovariance();
     if (isInitialised() && cov.size() != 0){pos_cov << cov(0,0), cov(0,1), cov(1,0), cov(1,1);}
     return pos_cov;
 }
@@ -297,7 +235,7 @@ VehicleState KalmanFilter::getVehicleState()
 {
     if (isInitialised())
     {
-        VectorXd state = getState(); // STATE VECTOR [X,Y,PSI,V,...]
+        const StateVector& state = getState(); // STATE VECTOR [X,Y,PSI,V,...]
         return VehicleState(state[0],state[1],state[2],state[3]);
     }
     return VehicleState();
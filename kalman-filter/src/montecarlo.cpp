@@ -0,0 +1,75 @@
+#include "montecarlo.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <memory>
+#include <thread>
+#include <vector>
+
+static RMSESummary summarise(const std::vector<double>& values)
+{
+    RMSESummary summary;
+    if (values.empty()){return summary;}
+    double sum = 0.0;
+    double sum_sq = 0.0;
+    for (double value : values){sum += value; sum_sq += value*value;}
+    const double n = static_cast<double>(values.size());
+    summary.mean = sum / n;
+    summary.std_dev = std::sqrt(std::max(sum_sq / n - summary.mean*summary.mean, 0.0));
+    auto [min_it, max_it] = std::minmax_element(values.begin(), values.end());
+    summary.min = *min_it;
+    summary.max = *max_it;
+    return summary;
+}
+
+MonteCarloResult runMonteCarlo(const std::function<SimulationParams()>& make_params, unsigned int runs, 
+    unsigned int num_threads, unsigned int first_seed)
+{
+    std::vector<FilterErrorStats> run_stats(runs);
+    std::atomic<unsigned int> next_run = 0;
+    num_threads = std::max(1U, std::min(num_threads, runs));
+
+    // Each worker pulls the next run index until all runs are done, so long and short runs balance out. A Simulation
+    // is large, so it lives on the heap rather than the worker's stack.
+    auto start = std::chrono::steady_clock::now();
+    {
+        std::vector<std::jthread> workers;
+        for (unsigned int t = 0; t < num_threads; ++t)
+        {
+            workers.emplace_back([&]()
+            {
+                for (unsigned int run = next_run++; run < runs; run = next_run++)
+                {
+                    SimulationParams params = make_params();
+                    params.random_seed = first_seed + run;
+                    auto sim = std::make_unique<Simulation>();
+                    sim->reset(params);
+                    sim->runToEnd();
+                    run_stats[run] = sim->getFilterErrorStats();
+                }
+            });
+        }
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    std::vector<double> x_position, y_position, heading, velocity;
+    for (const auto& stats : run_stats)
+    {
+        x_position.push_back(stats.x_position_rmse);
+        y_position.push_back(stats.y_position_rmse);
+        heading.push_back(stats.heading_rmse);
+        velocity.push_back(stats.velocity_rmse);
+    }
+
+    MonteCarloResult result;
+    result.profile_name = make_params().profile_name;
+    result.runs = runs;
+    result.x_position = summarise(x_position);
+    result.y_position = summarise(y_position);
+    result.heading = summarise(heading);
+    result.velocity = summarise(velocity);
+    result.wall_time = elapsed.count();
+    return result;
+}
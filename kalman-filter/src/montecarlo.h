@@ -0,0 +1,31 @@
+#ifndef INCLUDE_AKFSFSIM_MONTECARLO_H
+#define INCLUDE_AKFSFSIM_MONTECARLO_H
+
+#include <functional>
+#include <string>
+
+#include "simulation.h"
+
+// Spread of one error metric over the runs of a Monte-Carlo batch.
+struct RMSESummary
+{
+    double mean, std_dev, min, max;
+    RMSESummary():mean(0.0),std_dev(0.0),min(0.0),max(0.0){}
+};
+
+struct MonteCarloResult
+{
+    std::string profile_name;
+    unsigned int runs;
+    RMSESummary x_position, y_position, heading, velocity;
+    double wall_time;
+    MonteCarloResult():profile_name(""),runs(0),wall_time(0.0){}
+};
+
+// Runs independent simulations of one profile in parallel, each with its own seed (first_seed, first_seed + 1, ...),
+// as fast as the CPU allows, and summarises the filter RMSE of each run. make_params is called once per run because 
+// the motion commands in SimulationParams keep state and can't be shared between simulations.
+MonteCarloResult runMonteCarlo(const std::function<SimulationParams()>& make_params, unsigned int runs, 
+    unsigned int num_threads, unsigned int first_seed = 1);
+
+#endif  // INCLUDE_AKFSFSIM_MONTECARLO_H
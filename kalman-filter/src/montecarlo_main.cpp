@@ -0,0 +1,94 @@
+// Headless Monte-Carlo runner. Runs each selected profile many times with different sensor noise seeds, on every
+// core and without SDL, and prints the spread of the filter RMSE.
+//
+// Usage: MonteCarlo<Filter> [runs] [threads] [profiles] [lidar]
+//   runs      Number of seeds per profile (default 100).
+//   threads   Worker threads (default: all cores).
+//   profiles  Profile keys to run, e.g. "159" (default "1234567890").
+//   lidar     Lidar update mode: "sequential" (default), "batched", or "compare" to run every profile with both modes
+//             on the same seeds and report the accuracy and run time of each. "batched" and "compare" need a filter
+//             with a batched lidar update (the EKF filters).
+
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include "montecarlo.h"
+#include "null_buffer.h"
+#include "profiles.h"
+
+static void printSummary(const char* name, const RMSESummary& summary, double scale)
+{
+    std::printf("    %-10s mean %9.3f  std %9.3f  min %9.3f  max %9.3f\n", name, summary.mean * scale, 
+        summary.std_dev * scale, summary.min * scale, summary.max * scale);
+}
+
+static void printResult(const MonteCarloResult& result, unsigned int num_threads, const char* label)
+{
+    std::printf("%s%s\n  %u runs on %u threads in %.2f s (%.1f runs/s)\n", result.profile_name.c_str(), label, 
+        result.runs, num_threads, result.wall_time, result.runs / result.wall_time);
+    printSummary("X (m)", result.x_position, 1.0);
+    printSummary("Y (m)", result.y_position, 1.0);
+    printSummary("Psi (deg)", result.heading, 180.0 / M_PI);
+    printSummary("V (m/s)", result.velocity, 1.0);
+    std::fflush(stdout);
+}
+
+static MonteCarloResult runWithLidarMode(ProfileLoader profile, LidarUpdateMode mode, unsigned int runs, 
+    unsigned int num_threads)
+{
+    auto make_params = [profile, mode]()
+    {
+        SimulationParams params = profile();
+        params.lidar_update_mode = mode;
+        return params;
+    };
+    return runMonteCarlo(make_params, runs, num_threads);
+}
+
+int main(int argc, char* argv[])
+{
+    unsigned int runs = argc > 1 ? std::stoul(argv[1]) : 100;
+    unsigned int num_threads = argc > 2 ? std::stoul(argv[2]) : std::max(1U, std::thread::hardware_concurrency());
+    std::string profiles = argc > 3 ? argv[3] : "1234567890";
+    std::string lidar_mode = argc > 4 ? argv[4] : "sequential";
+    if (lidar_mode != "sequential" && lidar_mode != "batched" && lidar_mode != "compare")
+    {
+        std::fprintf(stderr, "Unknown lidar update mode '%s'\n", lidar_mode.c_str());
+        return 1;
+    }
+    if (lidar_mode != "sequential" && !BATCHED_LIDAR_SUPPORTED)
+    {
+        std::fprintf(stderr, "Lidar update mode '%s' needs a filter with a batched lidar update\n", lidar_mode.c_str());
+        return 1;
+    }
+
+    NullBuffer null_buffer;
+    std::streambuf* cout_buffer = std::cout.rdbuf(&null_buffer);
+
+    for (char key : profiles)
+    {
+        ProfileLoader profile = getProfileLoader(key);
+        if (profile == nullptr){continue;}
+
+        if (lidar_mode == "compare")
+        {
+            MonteCarloResult sequential = runWithLidarMode(profile, LidarUpdateMode::Sequential, runs, num_threads);
+            MonteCarloResult batched = runWithLidarMode(profile, LidarUpdateMode::Batched, runs, num_threads);
+            printResult(sequential, num_threads, " [sequential lidar]");
+            printResult(batched, num_threads, " [batched lidar]");
+            std::printf("  batched/sequential time %.3f\n", batched.wall_time / sequential.wall_time);
+            std::fflush(stdout);
+        }
+        else
+        {
+            LidarUpdateMode mode = lidar_mode == "batched" ? LidarUpdateMode::Batched : LidarUpdateMode::Sequential;
+            printResult(runWithLidarMode(profile, mode, runs, num_threads), num_threads, "");
+        }
+    }
+
+    std::cout.rdbuf(cout_buffer);
+    return 0;
+}
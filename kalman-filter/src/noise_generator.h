@@ -0,0 +1,94 @@
+#ifndef INCLUDE_AKFSFSIM_NOISE_GENERATOR_H
+#define INCLUDE_AKFSFSIM_NOISE_GENERATOR_H
+
+#include <cmath>
+#include <cstdint>
+#include <Eigen/Dense>
+
+// Seedable source of sensor noise, based on the xoshiro256++ generator. Each generator is seeded with a (seed, stream)
+// pair, so the sensors of one simulation draw from independent streams of the same seed and every simulation can
+// be reproduced from its seed alone. Generators hold no shared state, so parallel simulations never contend.
+//
+// Gaussian samples are produced a block at a time with the Box-Muller transform written as Eigen array expressions,
+// so the log, sqrt and trigonometric functions run over whole blocks instead of one sample per call.
+class NoiseGenerator
+{
+    public:
+
+        static constexpr int BlockSize = 256;
+        static constexpr unsigned int DefaultSeed = 5489u;
+
+        explicit NoiseGenerator(unsigned int seed = DefaultSeed, unsigned int stream = 0){reset(seed, stream);}
+
+        void reset(unsigned int seed, unsigned int stream)
+        {
+            // Seed and stream are packed without loss, then expanded with splitmix64 as recommended for xoshiro.
+            uint64_t splitmix_state = (static_cast<uint64_t>(seed) << 32) | stream;
+            for (uint64_t& word : m_state){word = splitmix64(splitmix_state);}
+            m_index = BlockSize;
+        }
+
+        // Uniform sample in [0, 1).
+        double uniform(){return static_cast<double>(next() >> 11) * 0x1.0p-53;}
+
+        // Standard normal sample.
+        double gaussian()
+        {
+            if (m_index == BlockSize){fillBlock();}
+            return m_block[m_index++];
+        }
+
+        double gaussian(double mean, double std){return mean + std * gaussian();}
+
+    private:
+
+        using HalfBlock = Eigen::Array<double, BlockSize / 2, 1>;
+
+        static uint64_t splitmix64(uint64_t& x)
+        {
+            uint64_t z = (x += 0x9E3779B97F4A7C15ull);
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+            return z ^ (z >> 31);
+        }
+
+        static uint64_t rotl(uint64_t x, int k){return (x << k) | (x >> (64 - k));}
+
+        uint64_t next()
+        {
+            const uint64_t result = rotl(m_state[0] + m_state[3], 23) + m_state[0];
+            const uint64_t t = m_state[1] << 17;
+            m_state[2] ^= m_state[0];
+            m_state[3] ^= m_state[1];
+            m_state[1] ^= m_state[2];
+            m_state[0] ^= m_state[3];
+            m_state[2] ^= t;
+            m_state[3] = rotl(m_state[3], 45);
+            return result;
+        }
+
+        void fillBlock()
+        {
+            // u1 in (0, 1] so the log is finite, u2 in [0, 1).
+            for (int i = 0; i < BlockSize / 2; ++i)
+            {
+                m_u1(i) = static_cast<double>((next() >> 11) + 1) * 0x1.0p-53;
+                m_u2(i) = static_cast<double>(next() >> 11) * 0x1.0p-53;
+            }
+            m_radius = (-2.0 * m_u1.log()).sqrt();
+            m_angle = (2.0 * M_PI) * m_u2;
+
+            Eigen::Map<HalfBlock> first(m_block);
+            Eigen::Map<HalfBlock> second(m_block + BlockSize / 2);
+            first = m_radius * m_angle.cos();
+            second = m_radius * m_angle.sin();
+            m_index = 0;
+        }
+
+        uint64_t m_state[4];
+        HalfBlock m_u1, m_u2, m_radius, m_angle;
+        double m_block[BlockSize];
+        int m_index;
+};
+
+#endif  // INCLUDE_AKFSFSIM_NOISE_GENERATOR_H
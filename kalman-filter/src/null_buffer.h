@@ -0,0 +1,15 @@
+#ifndef INCLUDE_AKFSFSIM_NULL_BUFFER_H
+#define INCLUDE_AKFSFSIM_NULL_BUFFER_H
+
+#include <streambuf>
+
+// Discards everything written to it. The headless tools swap it into std::cout, as the simulation and filters log
+// every step there, which would otherwise dominate their run time.
+class NullBuffer : public std::streambuf
+{
+    protected:
+        int overflow(int c) override {return c;}
+        std::streamsize xsputn(const char*, std::streamsize n) override {return n;}
+};
+
+#endif  // INCLUDE_AKFSFSIM_NULL_BUFFER_H
@@ -0,0 +1,23 @@
+#ifndef INCLUDE_AKFSFSIM_PROFILES_H
+#define INCLUDE_AKFSFSIM_PROFILES_H
+
+#include "simulation.h"
+
+// Motion and sensor profiles selectable with the number keys. Each call creates new motion commands, so every 
+// Simulation needs its own copy of the parameters.
+SimulationParams loadSimulation1Parameters();
+SimulationParams loadSimulation2Parameters();
+SimulationParams loadSimulation3Parameters();
+SimulationParams loadSimulation4Parameters();
+SimulationParams loadSimulation5Parameters();
+SimulationParams loadSimulation6Parameters();
+SimulationParams loadSimulation7Parameters();
+SimulationParams loadSimulation8Parameters();
+SimulationParams loadSimulation9Parameters();
+SimulationParams loadSimulation0Parameters();
+
+// Loader of the profile on number key '0' to '9', or nullptr for any other key.
+using ProfileLoader = SimulationParams (*)();
+ProfileLoader getProfileLoader(char key);
+
+#endif  // INCLUDE_AKFSFSIM_PROFILES_H
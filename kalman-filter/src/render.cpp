@@ -0,0 +1,157 @@
+// Drawing code for the simulation objects. This is the only part of the simulation, along with display.cpp and 
+// main.cpp, that depends on SDL, so the headless targets leave it out.
+
+#include "simulation.h"
+#include "display.h"
+#include "utils.h"
+
+void Car::render(Display& disp)
+{
+    double steeringPsi = m_vehicle_model.getVehicleState().steering;
+    double carPsiOffset = m_vehicle_model.getVehicleState().psi;
+    Vector2 carPosOffset = Vector2(m_vehicle_model.getVehicleState().x, m_vehicle_model.getVehicleState().y);
+    
+    disp.setDrawColour(0,255,0);
+    disp.drawLines(transformPoints(m_car_lines_body, carPosOffset, carPsiOffset));
+    disp.drawLines(transformPoints(m_marker_lines, carPosOffset, carPsiOffset));
+
+    disp.setDrawColour(0,201,0);
+    disp.drawLines(transformPoints(transformPoints(m_wheel_lines, m_wheel_fl_offset, steeringPsi), carPosOffset, carPsiOffset));
+    disp.drawLines(transformPoints(transformPoints(m_wheel_lines, m_wheel_fr_offset, steeringPsi), carPosOffset, carPsiOffset));
+    disp.drawLines(transformPoints(offsetPoints(m_wheel_lines, m_wheel_rl_offset), carPosOffset, carPsiOffset));
+    disp.drawLines(transformPoints(offsetPoints(m_wheel_lines, m_wheel_rr_offset), carPosOffset, carPsiOffset));
+}
+
+void BeaconMap::render(Display& disp) const
+{
+    const std::vector<Vector2> beacon_lines = {{1,0},{0,1},{0,-1},{1,0}};
+    disp.setDrawColour(255,255,0);
+    for (const auto& beacon : m_beacon_map){disp.drawLines(offsetPoints(beacon_lines, Vector2(beacon.x,beacon.y)));}
+}
+
+void Simulation::render(Display& disp)
+{
+    std::vector<Vector2> marker_lines1 = {{0.5,0.5},{-0.5,-0.5}};
+    std::vector<Vector2> marker_lines2 = {{0.5,-0.5},{-0.5,0.5}};
+
+    disp.setView(m_view_size * disp.getScreenAspectRatio(),m_view_size, m_car.getVehicleState().x, m_car.getVehicleState().y);
+
+    m_car.render(disp);
+    m_beacons.render(disp);
+
+    disp.setDrawColour(0,100,0);
+    disp.drawLines(m_vehicle_position_history.getPoints());
+
+    disp.setDrawColour(100,0,0);
+    disp.drawLines(m_filter_position_history.getPoints());
+
+    if (m_kalman_filter.isInitialised())
+    {
+        VehicleState filter_state = m_kalman_filter.getVehicleState();
+        Eigen::Matrix2d cov = m_kalman_filter.getVehicleStatePositionCovariance();
+
+        double x = filter_state.x;
+        double y = filter_state.y;
+        double sigma_xx = cov(0,0);
+        double sigma_yy = cov(1,1);
+        double sigma_xy = cov(0,1);
+
+        std::vector<Vector2> marker_lines1_world = offsetPoints(marker_lines1, Vector2(x,y));
+        std::vector<Vector2> marker_lines2_world = offsetPoints(marker_lines2, Vector2(x,y));
+        disp.setDrawColour(255,0,0);
+        disp.drawLines(marker_lines1_world);
+        disp.drawLines(marker_lines2_world);
+
+        std::vector<Vector2> cov_world = generateEllipse(x,y,sigma_xx,sigma_yy,sigma_xy);
+        disp.setDrawColour(255,0,0);
+        disp.drawLines(cov_world);
+
+    }
+
+    // Render GPS Measurements
+    std::vector<std::vector<Vector2>> m_gps_marker = {{{0.5,0.5},{-0.5,-0.5}}, {{0.5,-0.5},{-0.5,0.5}}};
+    disp.setDrawColour(255,255,255);
+    for(const auto& meas : m_gps_measurement_history){disp.drawLines(offsetPoints(m_gps_marker, Vector2(meas.x,meas.y)));}
+
+    // Render GPS Denied Zone
+    if(m_sim_parameters.gps_denied_range > 0)
+    {
+        std::vector<Vector2> zone_lines = generateCircle(m_sim_parameters.gps_denied_x, m_sim_parameters.gps_denied_y, m_sim_parameters.gps_denied_range);
+        disp.setDrawColour(255,150,0);
+        disp.drawLines(zone_lines);
+    }
+
+    // Render Lidar Measurements
+    for(const auto& meas : m_lidar_measurement_history)
+    {
+        double x0 = m_car.getVehicleState().x;
+        double y0 = m_car.getVehicleState().y;
+        double delta_x = meas.range * cos(meas.theta + m_car.getVehicleState().psi);
+        double delta_y = meas.range * sin(meas.theta + m_car.getVehicleState().psi);
+        disp.setDrawColour(201,201,0);
+        disp.drawLine(Vector2(x0,y0), Vector2(x0 + delta_x,y0 + delta_y));
+    }
+
+    int x_offset, y_offset; 
+    int stride = 20;
+    // Simulation Status / Parameters
+    x_offset = 10;
+    y_offset = 30;
+    std::string time_string = string_format("Time: %0.2f (x%d)",m_time,m_time_multiplier);
+    std::string profile_string = string_format("Profile: %s", m_sim_parameters.profile_name.c_str());
+    std::string gps_string = string_format("GPS: %s (%0.1f Hz)", (m_sim_parameters.gps_enabled ? "ON" : "OFF"), m_sim_parameters.gps_update_rate);
+    std::string lidar_string = string_format("LIDAR: %s (%0.1f Hz)", (m_sim_parameters.lidar_enabled ? "ON" : "OFF"), m_sim_parameters.lidar_update_rate);
+    std::string gyro_string = string_format("GYRO: %s (%0.1f Hz)", (m_sim_parameters.gyro_enabled ? "ON" : "OFF"), m_sim_parameters.gyro_update_rate);
+    disp.drawText_MainFont(profile_string,Vector2(x_offset,y_offset+stride*-1),1.0,{255,255,255});
+    disp.drawText_MainFont(time_string,Vector2(x_offset,y_offset+stride*0),1.0,{255,255,255});
+    disp.drawText_MainFont(gps_string,Vector2(x_offset,y_offset+stride*1),1.0,{255,255,255});
+    disp.drawText_MainFont(lidar_string,Vector2(x_offset,y_offset+stride*2),1.0,{255,255,255});
+    disp.drawText_MainFont(gyro_string,Vector2(x_offset,y_offset+stride*3),1.0,{255,255,255});
+    if (m_is_paused){disp.drawText_MainFont("PAUSED",Vector2(x_offset,y_offset+stride*4),1.0,{255,0,0});}
+    if (!m_is_running){disp.drawText_MainFont("FINISHED",Vector2(x_offset,y_offset+stride*5),1.0,{255,0,0});}
+
+    // Vehicle State
+    x_offset = 800;
+    y_offset = 10;
+    std::string velocity_string = string_format("    Velocity: %0.2f m/s",m_car.getVehicleState().V);
+    std::string yaw_string = string_format("   Heading: %0.2f deg",m_car.getVehicleState().psi * 180.0/M_PI);
+    std::string xpos = string_format("X Position: %0.2f m",m_car.getVehicleState().x);
+    std::string ypos = string_format("Y Position: %0.2f m",m_car.getVehicleState().y);
+    disp.drawText_MainFont("Vehicle State",Vector2(x_offset-5,y_offset+stride*0),1.0,{255,255,255});
+    disp.drawText_MainFont(velocity_string,Vector2(x_offset,y_offset+stride*1),1.0,{255,255,255});
+    disp.drawText_MainFont(yaw_string,Vector2(x_offset,y_offset+stride*2),1.0,{255,255,255});
+    disp.drawText_MainFont(xpos,Vector2(x_offset,y_offset+stride*3),1.0,{255,255,255});
+    disp.drawText_MainFont(ypos,Vector2(x_offset,y_offset+stride*4),1.0,{255,255,255});
+
+    std::string kf_velocity_string = string_format("    Velocity: %0.2f m/s",m_kalman_filter.getVehicleState().V);
+    std::string kf_yaw_string = string_format("   Heading: %0.2f deg",m_kalman_filter.getVehicleState().psi * 180.0/M_PI);
+    std::string kf_xpos = string_format("X Position: %0.2f m",m_kalman_filter.getVehicleState().x);
+    std::string kf_ypos = string_format("Y Position: %0.2f m",m_kalman_filter.getVehicleState().y);
+    disp.drawText_MainFont("Filter State",Vector2(x_offset,y_offset+stride*6),1.0,{255,255,255});
+    disp.drawText_MainFont(kf_velocity_string,Vector2(x_offset,y_offset+stride*7),1.0,{255,255,255});
+    disp.drawText_MainFont(kf_yaw_string,Vector2(x_offset,y_offset+stride*8),1.0,{255,255,255});
+    disp.drawText_MainFont(kf_xpos,Vector2(x_offset,y_offset+stride*9),1.0,{255,255,255});
+    disp.drawText_MainFont(kf_ypos,Vector2(x_offset,y_offset+stride*10),1.0,{255,255,255});
+
+    // Keyboard Input
+    x_offset = 10;
+    y_offset = 650;
+    disp.drawText_MainFont("Reset Key: r",Vector2(x_offset,y_offset+stride*0),1.0,{255,255,255});
+    disp.drawText_MainFont("Pause Key: [space bar]",Vector2(x_offset,y_offset+stride*1),1.0,{255,255,255});
+    disp.drawText_MainFont("Speed Multiplier (+/-) Key: [ / ] ",Vector2(x_offset,y_offset+stride*2),1.0,{255,255,255});
+    disp.drawText_MainFont("Zoom (+/-) Key: + / - (keypad)",Vector2(x_offset,y_offset+stride*3),1.0,{255,255,255});
+    disp.drawText_MainFont("Motion Profile Key: 1 - 9,0",Vector2(x_offset,y_offset+stride*4),1.0,{255,255,255});
+
+
+    // Filter Error State
+    x_offset = 750;
+    y_offset = 650;
+    std::string xpos_error_string = string_format("X Position RMSE: %0.2f m",m_filter_error_x_position.getRMSE());
+    std::string ypos_error_string = string_format("Y Position RMSE: %0.2f m",m_filter_error_y_position.getRMSE());
+    std::string heading_error_string = string_format("   Heading RMSE: %0.2f deg",180.0 / M_PI * m_filter_error_heading.getRMSE());
+    std::string velocity_error_string = string_format("    Velocity RMSE: %0.2f m/s",m_filter_error_velocity.getRMSE());
+    disp.drawText_MainFont(xpos_error_string,Vector2(x_offset,y_offset+stride*0),1.0,{255,255,255});
+    disp.drawText_MainFont(ypos_error_string,Vector2(x_offset,y_offset+stride*1),1.0,{255,255,255});
+    disp.drawText_MainFont(heading_error_string,Vector2(x_offset,y_offset+stride*2),1.0,{255,255,255});
+    disp.drawText_MainFont(velocity_error_string,Vector2(x_offset,y_offset+stride*3),1.0,{255,255,255});
+}
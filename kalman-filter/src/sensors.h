@@ -1,21 +1,21 @@
 #ifndef INCLUDE_AKFSFSIM_SENSORS_H
 #define INCLUDE_AKFSFSIM_SENSORS_H
 
-#include <random>
 #include <vector>
 
+#include "beacons.h"
+#include "noise_generator.h"
+
 struct GPSMeasurement{double x,y;};
 struct GyroMeasurement{double psi_dot;};
 struct LidarMeasurement{double range, theta;int id;};
 
-class BeaconMap;
-
 class GPSSensor
 {
     public:
 
         GPSSensor();
-        void reset();
+        void reset(unsigned int seed = NoiseGenerator::DefaultSeed);
         void setGPSNoiseStd(double std);
         void setGPSErrorProb(double prob);
         void setGPSDeniedZone(double x, double y, double r);
@@ -23,7 +23,7 @@ class GPSSensor
 
     private:
 
-        std::mt19937 m_rand_gen;
+        NoiseGenerator m_rand_gen;
         double m_noise_std;
         double m_error_prob;
         double m_gps_denied_x, m_gps_denied_y, m_gps_denied_range;
@@ -35,14 +35,14 @@ class GyroSensor
     public:
 
         GyroSensor();
-        void reset();
+        void reset(unsigned int seed = NoiseGenerator::DefaultSeed);
         void setGyroNoiseStd(double std);
         void setGyroBias(double bias);
         GyroMeasurement generateGyroMeasurement(double sensor_yaw_rate);
 
     private:
 
-        std::mt19937 m_rand_gen;
+        NoiseGenerator m_rand_gen;
         double m_noise_std;
         double m_bias;
 };
@@ -52,7 +52,7 @@ class LidarSensor
     public:
 
         LidarSensor();
-        void reset();
+        void reset(unsigned int seed = NoiseGenerator::DefaultSeed);
         void setLidarNoiseStd(double range_std, double theta_std);
         void setLidarMaxRange(double range);
         void setLidarDAEnabled(bool id_enabled);
@@ -60,11 +60,12 @@ class LidarSensor
 
     private:
 
-        std::mt19937 m_rand_gen;
+        NoiseGenerator m_rand_gen;
         double m_range_noise_std;
         double m_theta_noise_std;
         double m_max_range;
         bool m_id_enabled;
+        std::vector<BeaconData> m_visible_beacons;
 };
 
 #endif  // INCLUDE_AKFSFSIM_SENSORS_H
\ No newline at end of file
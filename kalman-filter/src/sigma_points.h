@@ -0,0 +1,103 @@
+#ifndef INCLUDE_AKFSFSIM_SIGMA_POINTS_H
+#define INCLUDE_AKFSFSIM_SIGMA_POINTS_H
+
+#include <cmath>
+#include <Eigen/Dense>
+
+#include "square_root.h"
+
+// Sigma points of the unscented transform for an N dimensional (augmented) state, using kappa = 3 - N. The 2N+1
+// points are the columns of one fixed-size matrix, ordered [mean, mean + d_0, mean - d_0, mean + d_1, ...], so they
+// can be generated and pushed through a process or measurement model without allocating. The matrices are row-major:
+// each state component of all the points is one contiguous row, so a model evaluates a component over every point
+// as a single array expression.
+template <int N>
+class SigmaPoints
+{
+    public:
+
+        static constexpr int NumPoints = 2 * N + 1;
+
+        using Vector = Eigen::Matrix<double, N, 1>;
+        using Matrix = Eigen::Matrix<double, N, N>;
+        using PointMatrix = Eigen::Matrix<double, N, NumPoints, Eigen::RowMajor>;
+        using WeightVector = Eigen::Matrix<double, NumPoints, 1>;
+
+        // Points transformed into an M dimensional space (the output of a model evaluated on every column).
+        template <int M> using TransformedPoints = Eigen::Matrix<double, M, NumPoints, Eigen::RowMajor>;
+
+        // The weights only depend on N, so they are computed once and shared by every filter step.
+        static const WeightVector& weights()
+        {
+            static const WeightVector weights = makeWeights();
+            return weights;
+        }
+
+        void generate(const Vector& mean, const Matrix& cov)
+        {
+            m_llt.compute(cov);
+            generateFromFactor(mean, m_llt.matrixL().toDenseMatrix());
+        }
+
+        // Same points from a covariance factor S (cov = S S^T) that is already known, as in the square-root filters,
+        // which skips the factorisation.
+        void generateFromFactor(const Vector& mean, const Matrix& sqrt_cov)
+        {
+            m_delta = std::sqrt(N + kappa()) * sqrt_cov;
+
+            m_points.col(0) = mean;
+            for (int i = 0; i < N; ++i)
+            {
+                m_points.col(2 * i + 1) = mean + m_delta.col(i);
+                m_points.col(2 * i + 2) = mean - m_delta.col(i);
+            }
+        }
+
+        const PointMatrix& points() const {return m_points;}
+
+        // Factor of the weighted covariance of transformed points, computed from their deviations from the mean 
+        // without forming the covariance: a QR of the positively weighted deviations, then a rank-one update with the
+        // centre point, whose weight is negative for N > 3. Returns false if that downdate fails.
+        template <int M>
+        static bool covarianceFactor(const TransformedPoints<M>& deviations, Eigen::Matrix<double, M, M>& sqrt_cov)
+        {
+            const Eigen::Matrix<double, 2 * N, M> weighted = 
+                std::sqrt(weights()(1)) * deviations.template rightCols<2 * N>().transpose();
+            sqrt_cov = triangularFactor(weighted);
+            const double centre_weight = weights()(0);
+            return choleskyRankOneUpdate<M>(sqrt_cov, std::sqrt(std::abs(centre_weight)) * deviations.col(0), 
+                                            centre_weight < 0.0 ? -1.0 : 1.0);
+        }
+
+        // Weighted mean of the columns of the transformed points.
+        template <int M>
+        static Eigen::Matrix<double, M, 1> mean(const TransformedPoints<M>& points)
+        {
+            return points * weights();
+        }
+
+        // Weighted outer product sum of two sets of deviations from their means, i.e. the (cross) covariance.
+        template <int M, int K>
+        static Eigen::Matrix<double, M, K> covariance(const TransformedPoints<M>& deviationsA,
+                                                      const TransformedPoints<K>& deviationsB)
+        {
+            return deviationsA * weights().asDiagonal() * deviationsB.transpose();
+        }
+
+    private:
+
+        static constexpr double kappa() {return 3.0 - N;}
+
+        static WeightVector makeWeights()
+        {
+            WeightVector weights = WeightVector::Constant(0.5 / (N + kappa()));
+            weights(0) = kappa() / (N + kappa());
+            return weights;
+        }
+
+        Eigen::LLT<Matrix> m_llt;
+        Matrix m_delta;
+        PointMatrix m_points;
+};
+
+#endif  // INCLUDE_AKFSFSIM_SIGMA_POINTS_H
@@ -2,13 +2,17 @@
 #define INCLUDE_AKFSFSIM_SIMULATION_H
 
 #include <memory>
+#include <string>
 #include <vector>
 
 #include "kalmanfilter.h"
-#include "display.h"
 #include "car.h"
 #include "beacons.h"
 #include "sensors.h"
+#include "history.h"
+
+class Display;
+class TraceWriter;
 
 
 struct SimulationParams
@@ -30,6 +34,7 @@ struct SimulationParams
     double lidar_update_rate;
     double lidar_range_noise_std;
     double lidar_theta_noise_std;
+    LidarUpdateMode lidar_update_mode;
 
     bool gyro_enabled;
     double gyro_update_rate;
@@ -41,27 +46,42 @@ struct SimulationParams
     double car_initial_psi;
     double car_initial_velocity;
 
+    unsigned int random_seed;
+
+    // Binary trace of the run (see trace.h), or empty to not record one.
+    std::string trace_filename;
+
     std::vector<std::shared_ptr<MotionCommandBase>> car_commands;
 
     SimulationParams()
     :profile_name(""),
      time_step(0.1),end_time(120),
      gps_enabled(true), gps_update_rate(1.0), gps_position_noise_std(3), gps_error_probability(0.0),gps_denied_x(0.0),gps_denied_y(0.0),gps_denied_range(-1.0),
-     lidar_enabled(false), lidar_id_enabled(true), lidar_update_rate(10.0),lidar_range_noise_std(3),lidar_theta_noise_std(0.02),
+     lidar_enabled(false), lidar_id_enabled(true), lidar_update_rate(10.0),lidar_range_noise_std(3),lidar_theta_noise_std(0.02),lidar_update_mode(LidarUpdateMode::Sequential),
      gyro_enabled(true), gyro_update_rate(10.0),gyro_noise_std(0.001), gyro_bias(0.0),
-     car_initial_x(0.0),car_initial_y(0.0),car_initial_psi(0.0),car_initial_velocity(5.0)
+     car_initial_x(0.0),car_initial_y(0.0),car_initial_psi(0.0),car_initial_velocity(5.0),
+     random_seed(NoiseGenerator::DefaultSeed), trace_filename("")
     {}
 };
 
+// Root mean square of the filter error over every time step since the filter initialised.
+struct FilterErrorStats
+{
+    double x_position_rmse, y_position_rmse, heading_rmse, velocity_rmse;
+    FilterErrorStats():x_position_rmse(0.0),y_position_rmse(0.0),heading_rmse(0.0),velocity_rmse(0.0){}
+};
+
 
 class Simulation
 {
     public:
 
         Simulation();
+        ~Simulation();
         void reset();
         void reset(SimulationParams sim_params);
         void update();
+        void runToEnd();
         void render(Display& disp);
         void increaseTimeMultiplier();
         void decreaseTimeMultiplier();
@@ -71,9 +91,13 @@ class Simulation
         void togglePauseSimulation();
         bool isPaused();
         bool isRunning();
+        double getTime() const {return m_time;}
+        FilterErrorStats getFilterErrorStats() const;
 
     private:
 
+        void step();
+
         SimulationParams m_sim_parameters;
         KalmanFilter m_kalman_filter;
         Car m_car;
@@ -81,6 +105,7 @@ class Simulation
         GyroSensor m_gyro_sensor;
         GPSSensor m_gps_sensor;
         LidarSensor m_lidar_sensor;
+        std::unique_ptr<TraceWriter> m_trace_writer;
 
         bool m_is_paused;
         bool m_is_running;
@@ -92,16 +117,18 @@ class Simulation
         double m_time_till_gps_measurement;
         double m_time_till_lidar_measurement;
 
-        std::vector<GPSMeasurement> m_gps_measurement_history;
+        // The plotting histories have a fixed size, so memory and drawing time stay flat however long the run: the
+        // paths are decimated and only the most recent GPS measurements are kept.
+        RingBuffer<GPSMeasurement> m_gps_measurement_history;
         std::vector<LidarMeasurement> m_lidar_measurement_history;
 
-        std::vector<Vector2> m_vehicle_position_history;
-        std::vector<Vector2> m_filter_position_history;
+        DecimatedPath m_vehicle_position_history;
+        DecimatedPath m_filter_position_history;
 
-        std::vector<double> m_filter_error_x_position_history;
-        std::vector<double> m_filter_error_y_position_history;
-        std::vector<double> m_filter_error_heading_history;
-        std::vector<double> m_filter_error_velocity_history;
+        RunningRMSE m_filter_error_x_position;
+        RunningRMSE m_filter_error_y_position;
+        RunningRMSE m_filter_error_heading;
+        RunningRMSE m_filter_error_velocity;
 
 };
 
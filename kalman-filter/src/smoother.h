@@ -0,0 +1,100 @@
+#ifndef INCLUDE_AKFSFSIM_SMOOTHER_H
+#define INCLUDE_AKFSFSIM_SMOOTHER_H
+
+#include <vector>
+#include <Eigen/Dense>
+
+#include "utils.h"
+
+// Fixed-lag Rauch-Tung-Striebel smoother for the linear and extended filters. For every prediction step the filter
+// records the filtered estimate it started from, the transition matrix (the Jacobian for the EKF) and the predicted
+// estimate. After each recording the smoother runs the RTS backward pass over the last lag steps and so always holds
+// the smoothed estimate of the filtered estimate lag predictions back:
+//
+//   C_k   = P_k F_k+1^T (P-_k+1)^-1
+//   x^s_k = x_k + C_k (x^s_k+1 - x-_k+1)
+//   P^s_k = P_k + C_k (P^s_k+1 - P-_k+1) C_k^T
+//
+// The gain C_k only depends on step k, so it is computed once when the step is recorded and the backward pass is only
+// matrix products. The steps are kept in a ring buffer sized once on construction, so recording and smoothing never
+// allocate.
+template <int NX>
+class FixedLagSmoother
+{
+    public:
+
+        using StateVector = Eigen::Matrix<double, NX, 1>;
+        using StateMatrix = Eigen::Matrix<double, NX, NX>;
+
+        explicit FixedLagSmoother(int lag):m_lag(lag),m_steps(lag + 1),m_num_steps(0),m_newest(lag){}
+
+        void reset(){m_num_steps = 0; m_newest = m_lag;}
+        int getLag() const {return m_lag;}
+
+        // Records one prediction step from the filtered estimate (x_filtered, P_filtered) to the predicted estimate
+        // (x_predicted, P_predicted) with transition matrix F. angle_state is the index of a heading state whose
+        // differences are wrapped, or -1 if the state has none.
+        void addPrediction(const StateVector& x_filtered, const StateMatrix& P_filtered, const StateMatrix& F,
+                           const StateVector& x_predicted, const StateMatrix& P_predicted, int angle_state)
+        {
+            m_newest = (m_newest + 1) % (m_lag + 1);
+            Step& step = m_steps[m_newest];
+            step.x_filtered = x_filtered;
+            step.P_filtered = P_filtered;
+            step.x_predicted = x_predicted;
+            step.P_predicted = P_predicted;
+
+            // C = P F^T (P-)^-1, computed as ((P-)^-1 F P)^T since both covariances are symmetric.
+            m_llt.compute(P_predicted);
+            step.gain = m_llt.solve(F * P_filtered).transpose();
+
+            m_angle_state = angle_state;
+            if (m_num_steps <= m_lag){++m_num_steps;}
+            if (m_num_steps > m_lag){smooth();}
+        }
+
+        // True once lag + 1 predictions have been recorded, after which the smoothed estimate is refreshed with every
+        // prediction.
+        bool hasSmoothedEstimate() const {return m_num_steps > m_lag;}
+        const StateVector& getSmoothedState() const {return m_x_smoothed;}
+        const StateMatrix& getSmoothedCovariance() const {return m_P_smoothed;}
+
+    private:
+
+        struct Step
+        {
+            StateVector x_filtered;     // Estimate at step k, after its measurement updates
+            StateMatrix P_filtered;
+            StateVector x_predicted;    // Prediction of step k + 1 from step k
+            StateMatrix P_predicted;
+            StateMatrix gain;           // Smoother gain C_k
+        };
+
+        void smooth()
+        {
+            // The newest filtered estimate is already its own smoothed estimate.
+            m_x_smoothed = m_steps[m_newest].x_filtered;
+            m_P_smoothed = m_steps[m_newest].P_filtered;
+            for (int i = 1; i <= m_lag; ++i)
+            {
+                const Step& step = m_steps[(m_newest + m_lag + 1 - i) % (m_lag + 1)];
+                StateVector correction = m_x_smoothed - step.x_predicted;
+                if (m_angle_state >= 0){correction(m_angle_state) = wrapAngle(correction(m_angle_state));}
+                m_x_smoothed = step.x_filtered + step.gain * correction;
+                if (m_angle_state >= 0){m_x_smoothed(m_angle_state) = wrapAngle(m_x_smoothed(m_angle_state));}
+                m_P_smoothed = step.P_filtered + step.gain * (m_P_smoothed - step.P_predicted) * step.gain.transpose();
+            }
+        }
+
+        int m_lag;
+        std::vector<Step> m_steps;  // Ring buffer of the last lag + 1 steps, m_newest the most recent
+        int m_num_steps;
+        int m_newest;
+        int m_angle_state = -1;
+
+        Eigen::LLT<StateMatrix> m_llt;
+        StateVector m_x_smoothed = StateVector::Zero();
+        StateMatrix m_P_smoothed = StateMatrix::Zero();
+};
+
+#endif  // INCLUDE_AKFSFSIM_SMOOTHER_H
@@ -0,0 +1,76 @@
+#ifndef INCLUDE_AKFSFSIM_SQUARE_ROOT_H
+#define INCLUDE_AKFSFSIM_SQUARE_ROOT_H
+
+#include <cmath>
+#include <Eigen/Dense>
+
+// Helpers for the square-root filters, which propagate a lower-triangular factor S of the covariance (P = S S^T)
+// instead of P. Every step rebuilds S with an orthogonal transformation (QR) or a rank-one update of S, so P is
+// never formed and factorised again, and it stays positive definite by construction however long the filter runs.
+
+// Returns the lower-triangular L with L L^T = A^T A for a matrix A with at least as many rows as columns, from the R
+// factor of a QR decomposition of A. Stacking the factors of a sum of covariances as the rows of A gives the factor of
+// the sum, e.g. A = [(F S)^T; Q^(1/2)] gives the factor of F P F^T + Q.
+template <typename Derived>
+Eigen::Matrix<double, Derived::ColsAtCompileTime, Derived::ColsAtCompileTime> triangularFactor(
+    const Eigen::MatrixBase<Derived>& A)
+{
+    constexpr int N = Derived::ColsAtCompileTime;
+    using Factor = Eigen::Matrix<double, N, N>;
+
+    const Eigen::HouseholderQR<typename Derived::PlainObject> qr(A);
+    Factor L = qr.matrixQR().template topRows<N>().template triangularView<Eigen::Upper>().transpose();
+
+    // The signs of the rows of R are arbitrary; flip them so L has a positive diagonal like a Cholesky factor.
+    for (int i = 0; i < N; ++i)
+    {
+        if (L(i, i) < 0.0){L.col(i) = -L.col(i);}
+    }
+    return L;
+}
+
+// Rank-one update (sign = 1) or downdate (sign = -1) of the lower-triangular factor L in place, L L^T += sign x x^T.
+// Returns false if a downdate would make the matrix indefinite, in which case L is left partly updated.
+template <int N>
+bool choleskyRankOneUpdate(Eigen::Matrix<double, N, N>& L, Eigen::Matrix<double, N, 1> x, double sign)
+{
+    for (int k = 0; k < N; ++k)
+    {
+        const double diagonal_sq = L(k, k) * L(k, k) + sign * x(k) * x(k);
+        if (L(k, k) <= 0.0 || diagonal_sq <= 0.0){return false;}
+
+        const double diagonal = std::sqrt(diagonal_sq);
+        const double c = diagonal / L(k, k);
+        const double s = x(k) / L(k, k);
+        L(k, k) = diagonal;
+
+        const int rest = N - k - 1;
+        L.col(k).tail(rest) = (L.col(k).tail(rest) + sign * s * x.tail(rest)) / c;
+        x.tail(rest) = c * x.tail(rest) - s * L.col(k).tail(rest);
+    }
+    return true;
+}
+
+// Kalman update of the state x and covariance factor S with the innovation y of a measurement with Jacobian H and noise
+// factor R_sqrt (R = R_sqrt R_sqrt^T). Triangularises the array [R_sqrt, H S; 0, S] into [Sy, 0; K Sy, S+], where
+// Sy is the factor of the innovation covariance, so the gain and the updated factor come from one QR decomposition.
+template <int NX, int NZ>
+void squareRootUpdate(Eigen::Matrix<double, NX, 1>& x, Eigen::Matrix<double, NX, NX>& S,
+                      const Eigen::Matrix<double, NZ, 1>& y, const Eigen::Matrix<double, NZ, NX>& H,
+                      const Eigen::Matrix<double, NZ, NZ>& R_sqrt)
+{
+    // Transpose of the pre-array, as triangularFactor works on the rows of its argument.
+    Eigen::Matrix<double, NZ + NX, NZ + NX> pre_array = Eigen::Matrix<double, NZ + NX, NZ + NX>::Zero();
+    pre_array.template topLeftCorner<NZ, NZ>() = R_sqrt.transpose();
+    pre_array.template bottomLeftCorner<NX, NZ>() = (H * S).transpose();
+    pre_array.template bottomRightCorner<NX, NX>() = S.transpose();
+
+    const Eigen::Matrix<double, NZ + NX, NZ + NX> post_array = triangularFactor(pre_array);
+    const Eigen::Matrix<double, NZ, NZ> Sy = post_array.template topLeftCorner<NZ, NZ>();
+
+    // x+ = x + K y with K = (K Sy) Sy^-1.
+    x += post_array.template bottomLeftCorner<NX, NZ>() * Sy.template triangularView<Eigen::Lower>().solve(y);
+    S = post_array.template bottomRightCorner<NX, NX>();
+}
+
+#endif  // INCLUDE_AKFSFSIM_SQUARE_ROOT_H
@@ -27,9 +27,9 @@ int main() {
     using namespace Eigen;
 
     Measurement meas { .range = 32.5135, .theta = -0.676827 };
-    VectorXd state = VectorXd::Zero(4);
+    Vector4d state = Vector4d::Zero();
     state << 500.0, 500.0, -2.356194490192345, 5.0;
-    MatrixXd cov = MatrixXd::Zero(4, 4);
+    Matrix4d cov = Matrix4d::Zero();
     cov(0, 0) = GPS_POS_STD * GPS_POS_STD;
     cov(1, 1) = GPS_POS_STD * GPS_POS_STD;
     cov(2, 2) = INIT_PSI_STD * INIT_PSI_STD;
@@ -38,59 +38,55 @@ int main() {
 
     ///////////////////////////////////////////////////////////////////////////
 
-    const size_t nz = 2;
-    const size_t nx = state.size();
-    const size_t na = nx + nz;
+    constexpr int nz = 2;
+    constexpr int nx = 4;
+    using AugSigmaPoints = SigmaPoints<nx + nz>;
 
     // Augmentation of state and covariance.
-    VectorXd augState = VectorXd::Zero(na);
-    augState.head(nx) = state;
+    AugSigmaPoints::Vector augState = AugSigmaPoints::Vector::Zero();
+    augState.head<nx>() = state;
 
-    MatrixXd augCov = MatrixXd::Zero(na, na);
-    augCov.topLeftCorner(nx, nx) = cov;
+    AugSigmaPoints::Matrix augCov = AugSigmaPoints::Matrix::Zero();
+    augCov.topLeftCorner<nx, nx>() = cov;
     augCov(nx, nx) = LIDAR_RANGE_STD * LIDAR_RANGE_STD;
     augCov(nx + 1, nx + 1) = LIDAR_THETA_STD * LIDAR_THETA_STD;
 
     // Generate sigma points and weights.
-    auto sigmaPoints = generateSigmaPoints(augState, augCov);
-    auto weights = generateSigmaWeights(na);
+    AugSigmaPoints sigma;
+    sigma.generate(augState, augCov);
+    const AugSigmaPoints::PointMatrix& sigmaPoints = sigma.points();
+    const AugSigmaPoints::WeightVector& weights = AugSigmaPoints::weights();
 
     // Assert sigmaPoints
     // With a diagonal covariance, we expect the offset on each of the state to be sqrt(3) (1.73205080) times the 
     // standard deviation given to each. The psi offset is 77 degs.
     double multiplier = 1.73205080;
     std::cout << "--- Test Sigma Points ---" << std::endl; 
-    std::cout << "expected: " << -multiplier * GPS_POS_STD << ", actual: " << augState(0) - sigmaPoints[1](0) << std::endl;
-    std::cout << "expected: " << multiplier * GPS_POS_STD << ", actual: " << augState(0) - sigmaPoints[2](0) << std::endl;
-    std::cout << "expected: " << -multiplier * GPS_POS_STD << ", actual: " << augState(1) - sigmaPoints[3](1) << std::endl;
-    std::cout << "expected: " << multiplier * GPS_POS_STD << ", actual: " << augState(1) - sigmaPoints[4](1) << std::endl;
-    std::cout << "expected: " << -multiplier * INIT_PSI_STD << ", actual: " << augState(2) - sigmaPoints[5](2) << std::endl;
-    std::cout << "expected: " << multiplier * INIT_PSI_STD << ", actual: " << augState(2) - sigmaPoints[6](2) << std::endl;
-    std::cout << "expected: " << -multiplier * INIT_VEL_STD << ", actual: " << augState(3) - sigmaPoints[7](3) << std::endl;
-    std::cout << "expected: " << multiplier * INIT_VEL_STD << ", actual: " << augState(3) - sigmaPoints[8](3) << std::endl;
-    std::cout << "expected: " << -multiplier * LIDAR_RANGE_STD << ", actual: " << augState(4) - sigmaPoints[9](4) << std::endl;
-    std::cout << "expected: " << multiplier * LIDAR_RANGE_STD << ", actual: " << augState(4) - sigmaPoints[10](4) << std::endl;
-    std::cout << "expected: " << -multiplier * LIDAR_THETA_STD << ", actual: " << augState(5) - sigmaPoints[11](5) << std::endl;
-    std::cout << "expected: " << multiplier * LIDAR_THETA_STD << ", actual: " << augState(5) - sigmaPoints[12](5) << std::endl;
+    std::cout << "expected: " << -multiplier * GPS_POS_STD << ", actual: " << augState(0) - sigmaPoints(0, 1) << std::endl;
+    std::cout << "expected: " << multiplier * GPS_POS_STD << ", actual: " << augState(0) - sigmaPoints(0, 2) << std::endl;
+    std::cout << "expected: " << -multiplier * GPS_POS_STD << ", actual: " << augState(1) - sigmaPoints(1, 3) << std::endl;
+    std::cout << "expected: " << multiplier * GPS_POS_STD << ", actual: " << augState(1) - sigmaPoints(1, 4) << std::endl;
+    std::cout << "expected: " << -multiplier * INIT_PSI_STD << ", actual: " << augState(2) - sigmaPoints(2, 5) << std::endl;
+    std::cout << "expected: " << multiplier * INIT_PSI_STD << ", actual: " << augState(2) - sigmaPoints(2, 6) << std::endl;
+    std::cout << "expected: " << -multiplier * INIT_VEL_STD << ", actual: " << augState(3) - sigmaPoints(3, 7) << std::endl;
+    std::cout << "expected: " << multiplier * INIT_VEL_STD << ", actual: " << augState(3) - sigmaPoints(3, 8) << std::endl;
+    std::cout << "expected: " << -multiplier * LIDAR_RANGE_STD << ", actual: " << augState(4) - sigmaPoints(4, 9) << std::endl;
+    std::cout << "expected: " << multiplier * LIDAR_RANGE_STD << ", actual: " << augState(4) - sigmaPoints(4, 10) << std::endl;
+    std::cout << "expected: " << -multiplier * LIDAR_THETA_STD << ", actual: " << augState(5) - sigmaPoints(5, 11) << std::endl;
+    std::cout << "expected: " << multiplier * LIDAR_THETA_STD << ", actual: " << augState(5) - sigmaPoints(5, 12) << std::endl;
 
     // Assert weights
     std::cout << "--- Test Weights ---" << std::endl; 
-    std::cout << "expected: " << -1.0 << ", actual: " << weights[0] << std::endl;
-    for (size_t i = 1; i < weights.size(); i++) {
-        std::cout << "expected: " << 0.16668 << ", actual: " << weights[i] << std::endl;
+    std::cout << "expected: " << -1.0 << ", actual: " << weights(0) << std::endl;
+    for (int i = 1; i < weights.size(); i++) {
+        std::cout << "expected: " << 0.16668 << ", actual: " << weights(i) << std::endl;
     }
 
-    std::vector<Vector2d> transformedPoints;
-    transformedPoints.push_back(lidarMeasurementModel(sigmaPoints[0], map_beacon.x, map_beacon.y, std::nullopt));
-    for (size_t i = 1; i < sigmaPoints.size(); i++) {
-        transformedPoints.push_back(lidarMeasurementModel(sigmaPoints[i], map_beacon.x, map_beacon.y, transformedPoints[0](1)));
-    }
+    AugSigmaPoints::TransformedPoints<nz> transformedPoints = 
+        lidarMeasurementModel(sigmaPoints, map_beacon.x, map_beacon.y);
     
     // Calculate the mean of the transformed sigma points
-    Vector2d zhat = Vector2d::Zero();
-    for (size_t i = 0; i < transformedPoints.size(); i++) {
-        zhat += weights[i] * transformedPoints[i];
-    }
+    Vector2d zhat = AugSigmaPoints::mean(transformedPoints);
 
     // Calculate the innovation.
     Vector2d z = Vector2d::Zero();
@@ -98,22 +94,15 @@ int main() {
     Vector2d innovation = normaliseLidarMeasurement(z - zhat);
 
     // Calculate the covariance of the transformed signal.
-    Matrix2d innovationcov = Matrix2d::Zero();
-    for (size_t i = 0; i < transformedPoints.size(); i++) {
-        Vector2d err = normaliseLidarMeasurement(transformedPoints[i] - zhat);
-        innovationcov += weights[i] * err * err.transpose();
-    }
+    AugSigmaPoints::TransformedPoints<nz> errz = normaliseLidarMeasurement(transformedPoints.colwise() - zhat);
+    Matrix2d innovationcov = AugSigmaPoints::covariance(errz, errz);
 
     // Calculate the cross covariance
-    MatrixXd crosscov = MatrixXd::Zero(nx, nz);
-    for (size_t i = 0; i < transformedPoints.size(); i++) {
-        VectorXd errz = normaliseLidarMeasurement(transformedPoints[i] - zhat);
-        VectorXd errx = normaliseState(sigmaPoints[i].head(nx) - state);
-        crosscov += weights[i] * errx * errz.transpose();
-    }
+    AugSigmaPoints::TransformedPoints<nx> errx = normaliseState(sigmaPoints.topRows<nx>().colwise() - state);
+    Matrix<double, nx, nz> crosscov = AugSigmaPoints::covariance(errx, errz);
 
     // UKF update step equations.
-    MatrixXd kalmanGain = crosscov * innovationcov.inverse();
+    Matrix<double, nx, nz> kalmanGain = crosscov * innovationcov.inverse();
     state += kalmanGain * innovation;
     cov -= kalmanGain * innovationcov * kalmanGain.transpose();
 
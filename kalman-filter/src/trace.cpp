@@ -0,0 +1,272 @@
+#include "trace.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define AKFSFSIM_TRACE_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "utils.h"
+
+// Trace Writer
+TraceWriter::TraceWriter():m_file(nullptr){m_chunk.reserve(TRACE_CHUNK_RECORDS);}
+TraceWriter::~TraceWriter(){close();}
+
+bool TraceWriter::open(const std::string& filename, const std::string& profile_name, double time_step,
+                       LidarUpdateMode lidar_update_mode)
+{
+    close();
+    m_file = std::fopen(filename.c_str(), "wb");
+    if (m_file == nullptr){return false;}
+
+    TraceFileHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, TRACE_MAGIC, sizeof(header.magic));
+    header.version = TRACE_VERSION;
+    header.record_size = sizeof(TraceRecord);
+    header.lidar_update_mode = static_cast<uint32_t>(lidar_update_mode);
+    header.time_step = time_step;
+    std::strncpy(header.profile_name, profile_name.c_str(), sizeof(header.profile_name) - 1);
+    std::fwrite(&header, sizeof(header), 1, m_file);
+    return true;
+}
+
+void TraceWriter::close()
+{
+    if (m_file == nullptr){return;}
+    flushChunk();
+    std::fclose(m_file);
+    m_file = nullptr;
+}
+
+void TraceWriter::write(TraceRecordType type, double time, double a, double b, double c, double d, int32_t id)
+{
+    if (m_file == nullptr){return;}
+    m_chunk.push_back(TraceRecord{type, id, time, {a, b, c, d}});
+    if (m_chunk.size() == TRACE_CHUNK_RECORDS){flushChunk();}
+}
+
+void TraceWriter::flushChunk()
+{
+    if (m_chunk.empty()){return;}
+    const TraceChunkHeader chunk_header{TRACE_CHUNK_MAGIC, static_cast<uint32_t>(m_chunk.size())};
+    std::fwrite(&chunk_header, sizeof(chunk_header), 1, m_file);
+    std::fwrite(m_chunk.data(), sizeof(TraceRecord), m_chunk.size(), m_file);
+    m_chunk.clear();
+}
+
+// Trace Reader
+TraceReader::TraceReader():m_data(nullptr),m_size(0),m_mapped(false),m_header(nullptr){}
+TraceReader::~TraceReader(){close();}
+
+bool TraceReader::open(const std::string& filename)
+{
+    close();
+
+#ifdef AKFSFSIM_TRACE_MMAP
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0){return false;}
+    struct stat file_stat;
+    if (::fstat(fd, &file_stat) == 0 && file_stat.st_size > 0)
+    {
+        void* mapping = ::mmap(nullptr, file_stat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping != MAP_FAILED)
+        {
+            m_data = static_cast<const char*>(mapping);
+            m_size = file_stat.st_size;
+            m_mapped = true;
+        }
+    }
+    ::close(fd);
+#endif
+
+    if (!m_mapped)
+    {
+        std::FILE* file = std::fopen(filename.c_str(), "rb");
+        if (file == nullptr){return false;}
+        std::fseek(file, 0, SEEK_END);
+        const long size = std::ftell(file);
+        std::fseek(file, 0, SEEK_SET);
+        m_buffer.resize((std::max(size, 0L) + sizeof(uint64_t) - 1) / sizeof(uint64_t));
+        m_size = std::fread(m_buffer.data(), 1, std::max(size, 0L), file);
+        m_data = reinterpret_cast<const char*>(m_buffer.data());
+        std::fclose(file);
+    }
+
+    // Validate the header, then index the complete chunks.
+    if (m_size < sizeof(TraceFileHeader)){close(); return false;}
+    m_header = reinterpret_cast<const TraceFileHeader*>(m_data);
+    if (std::memcmp(m_header->magic, TRACE_MAGIC, sizeof(TRACE_MAGIC)) != 0 || m_header->version != TRACE_VERSION
+        || m_header->record_size != sizeof(TraceRecord)){close(); return false;}
+
+    size_t offset = sizeof(TraceFileHeader);
+    while (offset + sizeof(TraceChunkHeader) <= m_size)
+    {
+        const auto* chunk_header = reinterpret_cast<const TraceChunkHeader*>(m_data + offset);
+        const size_t chunk_bytes = sizeof(TraceChunkHeader) + chunk_header->num_records * sizeof(TraceRecord);
+        if (chunk_header->magic != TRACE_CHUNK_MAGIC || offset + chunk_bytes > m_size){break;}
+        m_chunks.push_back(Chunk{reinterpret_cast<const TraceRecord*>(chunk_header + 1), chunk_header->num_records});
+        offset += chunk_bytes;
+    }
+    return true;
+}
+
+void TraceReader::close()
+{
+#ifdef AKFSFSIM_TRACE_MMAP
+    if (m_mapped){::munmap(const_cast<char*>(m_data), m_size);}
+#endif
+    m_data = nullptr;
+    m_size = 0;
+    m_mapped = false;
+    m_buffer.clear();
+    m_header = nullptr;
+    m_chunks.clear();
+}
+
+size_t TraceReader::getNumRecords() const
+{
+    size_t num_records = 0;
+    for (const Chunk& chunk : m_chunks){num_records += chunk.num_records;}
+    return num_records;
+}
+
+// Replay
+static TraceReplayResult replay(const TraceReader& trace, KalmanFilter& filter, const BeaconMap& map,
+                                const FixedLagSmoother<KalmanFilter::StateSize>* smoother)
+{
+    TraceReplayResult result;
+    filter.reset();
+    filter.setLidarUpdateMode(static_cast<LidarUpdateMode>(trace.getHeader().lidar_update_mode));
+
+    // A time step starts with its Truth record, so the filter is scored when the next one arrives (or at the end),
+    // after every measurement of the step, the same as Simulation::step.
+    const TraceRecord* truth = nullptr;
+    const TraceRecord* recorded_filter = nullptr;
+    double sum_sq_x = 0.0, sum_sq_y = 0.0, sum_sq_psi = 0.0, sum_sq_v = 0.0;
+    size_t num_scored = 0;
+    auto finishStep = [&]()
+    {
+        if (truth == nullptr){return;}
+        ++result.num_steps;
+        if (filter.isInitialised())
+        {
+            const VehicleState state = filter.getVehicleState();
+            const double error_x = state.x - truth->data[0];
+            const double error_y = state.y - truth->data[1];
+            const double error_psi = wrapAngle(state.psi - truth->data[2]);
+            const double error_v = state.V - truth->data[3];
+            sum_sq_x += error_x * error_x;
+            sum_sq_y += error_y * error_y;
+            sum_sq_psi += error_psi * error_psi;
+            sum_sq_v += error_v * error_v;
+            ++num_scored;
+
+            if (recorded_filter != nullptr)
+            {
+                const double dev_x = state.x - recorded_filter->data[0];
+                const double dev_y = state.y - recorded_filter->data[1];
+                const double dev_psi = std::abs(wrapAngle(state.psi - recorded_filter->data[2]));
+                result.max_position_deviation = std::max(result.max_position_deviation, std::hypot(dev_x, dev_y));
+                result.max_heading_deviation = std::max(result.max_heading_deviation, dev_psi);
+            }
+        }
+        recorded_filter = nullptr;
+    };
+
+    // The smoother records the estimate a prediction starts from, i.e. the end of the previous step, so the truth of
+    // that step is kept per recorded prediction in a ring of the same length as the smoother's.
+    const int smoother_slots = smoother != nullptr ? smoother->getLag() + 1 : 1;
+    std::vector<const TraceRecord*> smoother_truth(smoother_slots, nullptr);
+    size_t num_smoother_steps = 0;
+    const TraceRecord* previous_truth = nullptr;
+    double sum_sq_smoothed_x = 0.0, sum_sq_smoothed_y = 0.0;
+
+    std::vector<LidarMeasurement> scan;
+    uint32_t pending_returns = 0;
+    for (const TraceReader::Chunk& chunk : trace.getChunks())
+    {
+        for (const TraceRecord* record = chunk.records; record != chunk.records + chunk.num_records; ++record)
+        {
+            if (pending_returns > 0 && record->type == TraceRecordType::LidarReturn)
+            {
+                scan.push_back(LidarMeasurement{record->data[0], record->data[1], record->id});
+                if (--pending_returns == 0){filter.handleLidarMeasurements(scan, map);}
+                continue;
+            }
+
+            switch (record->type)
+            {
+                case TraceRecordType::Truth:
+                    finishStep();
+                    previous_truth = truth;
+                    truth = record;
+                    break;
+                case TraceRecordType::Gyro:
+                {
+                    const bool was_initialised = filter.isInitialised();
+                    filter.predictionStep(GyroMeasurement{record->data[0]}, record->data[1]);
+                    if (smoother == nullptr || !was_initialised || previous_truth == nullptr){break;}
+
+                    smoother_truth[num_smoother_steps++ % smoother_slots] = previous_truth;
+                    if (smoother->hasSmoothedEstimate())
+                    {
+                        // The smoothed estimate is of the oldest step in the ring, which the next one overwrites.
+                        const TraceRecord* smoothed_truth = smoother_truth[num_smoother_steps % smoother_slots];
+                        const double error_x = smoother->getSmoothedState()(0) - smoothed_truth->data[0];
+                        const double error_y = smoother->getSmoothedState()(1) - smoothed_truth->data[1];
+                        sum_sq_smoothed_x += error_x * error_x;
+                        sum_sq_smoothed_y += error_y * error_y;
+                        ++result.num_smoothed;
+                    }
+                    break;
+                }
+                case TraceRecordType::GPS:
+                    filter.handleGPSMeasurement(GPSMeasurement{record->data[0], record->data[1]});
+                    break;
+                case TraceRecordType::LidarScan:
+                    scan.clear();
+                    pending_returns = static_cast<uint32_t>(record->data[0]);
+                    if (pending_returns == 0){filter.handleLidarMeasurements(scan, map);}
+                    break;
+                case TraceRecordType::Filter:
+                    recorded_filter = record;
+                    break;
+                case TraceRecordType::LidarReturn:
+                    break;
+            }
+        }
+    }
+    finishStep();
+
+    if (num_scored > 0)
+    {
+        result.error.x_position_rmse = std::sqrt(sum_sq_x / num_scored);
+        result.error.y_position_rmse = std::sqrt(sum_sq_y / num_scored);
+        result.error.heading_rmse = std::sqrt(sum_sq_psi / num_scored);
+        result.error.velocity_rmse = std::sqrt(sum_sq_v / num_scored);
+    }
+    if (result.num_smoothed > 0)
+    {
+        result.smoothed_x_position_rmse = std::sqrt(sum_sq_smoothed_x / result.num_smoothed);
+        result.smoothed_y_position_rmse = std::sqrt(sum_sq_smoothed_y / result.num_smoothed);
+    }
+    return result;
+}
+
+TraceReplayResult replayTrace(const TraceReader& trace, KalmanFilter& filter, const BeaconMap& map)
+{
+    return replay(trace, filter, map, nullptr);
+}
+
+TraceReplayResult replayTrace(const TraceReader& trace, SmoothingKalmanFilter& filter, const BeaconMap& map)
+{
+    filter.reset();
+    return replay(trace, filter, map, &filter.getSmoother());
+}
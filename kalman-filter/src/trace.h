@@ -0,0 +1,172 @@
+#ifndef INCLUDE_AKFSFSIM_TRACE_H
+#define INCLUDE_AKFSFSIM_TRACE_H
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "simulation.h"
+#include "smoother.h"
+
+// Binary trace of a simulation run: the ground truth, every sensor measurement and the filter output, in the order
+// the simulation produced them. A trace can be replayed into any KalmanFilter without simulating the car or sensors.
+//
+// File layout (native byte order):
+//   TraceFileHeader
+//   { TraceChunkHeader, TraceRecord[num_records] } ...
+// Every record has the same size and every offset is a multiple of 8, so a reader can memory-map the file and use the
+// records in place. The writer emits whole chunks, so a trace cut short by a crash is still readable up to its last
+// complete chunk.
+
+enum class TraceRecordType : uint32_t
+{
+    Truth = 1,          // data = [X, Y, PSI, V] of the car, once per time step
+    Gyro = 2,           // data = [PSI_DOT, DT]
+    GPS = 3,            // data = [X, Y]
+    LidarScan = 4,      // data = [NUM_RETURNS], followed by that many LidarReturn records
+    LidarReturn = 5,    // data = [RANGE, THETA], id = beacon id or -1
+    Filter = 6          // data = [X, Y, PSI, V] of the filter, once per time step after it initialised
+};
+
+struct TraceRecord
+{
+    TraceRecordType type;
+    int32_t id;
+    double time;
+    double data[4];
+};
+static_assert(sizeof(TraceRecord) == 48, "Trace records must stay 48 bytes");
+
+struct TraceFileHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t record_size;
+    uint32_t lidar_update_mode;
+    uint32_t reserved;
+    double time_step;
+    char profile_name[64];
+};
+static_assert(sizeof(TraceFileHeader) % 8 == 0, "Records after the header must stay 8-byte aligned");
+
+struct TraceChunkHeader
+{
+    uint32_t magic;
+    uint32_t num_records;
+};
+
+constexpr char TRACE_MAGIC[8] = {'A','K','F','T','R','A','C','E'};
+constexpr uint32_t TRACE_VERSION = 1;
+constexpr uint32_t TRACE_CHUNK_MAGIC = 0x4B4E4843;  // "CHNK"
+constexpr uint32_t TRACE_CHUNK_RECORDS = 4096;
+
+// Streams records to a trace file, a chunk at a time.
+class TraceWriter
+{
+    public:
+
+        TraceWriter();
+        ~TraceWriter();
+        TraceWriter(const TraceWriter&) = delete;
+        TraceWriter& operator=(const TraceWriter&) = delete;
+
+        bool open(const std::string& filename, const std::string& profile_name, double time_step,
+                  LidarUpdateMode lidar_update_mode);
+        void close();
+        bool isOpen() const {return m_file != nullptr;}
+
+        void write(TraceRecordType type, double time, double a = 0.0, double b = 0.0, double c = 0.0,
+                   double d = 0.0, int32_t id = 0);
+
+    private:
+
+        void flushChunk();
+
+        std::FILE* m_file;
+        std::vector<TraceRecord> m_chunk;
+};
+
+// Read-only view of a trace file. The file is memory-mapped where the platform supports it, otherwise read into
+// memory, and the chunks are indexed on open.
+class TraceReader
+{
+    public:
+
+        struct Chunk
+        {
+            const TraceRecord* records;
+            uint32_t num_records;
+        };
+
+        TraceReader();
+        ~TraceReader();
+        TraceReader(const TraceReader&) = delete;
+        TraceReader& operator=(const TraceReader&) = delete;
+
+        bool open(const std::string& filename);
+        void close();
+
+        const TraceFileHeader& getHeader() const {return *m_header;}
+        const std::vector<Chunk>& getChunks() const {return m_chunks;}
+        size_t getNumRecords() const;
+
+    private:
+
+        const char* m_data;
+        size_t m_size;
+        bool m_mapped;
+        std::vector<uint64_t> m_buffer;     // File contents when it can't be mapped (uint64_t keeps them aligned)
+        const TraceFileHeader* m_header;
+        std::vector<Chunk> m_chunks;
+};
+
+struct TraceReplayResult
+{
+    FilterErrorStats error;         // Filter error against the recorded ground truth
+    double max_position_deviation;  // Largest distance between the replayed and the recorded filter position
+    double max_heading_deviation;   // Largest heading difference between the replayed and the recorded filter
+    size_t num_steps;
+
+    // Position error of the fixed-lag smoothed estimates, when replaying into a SmoothingKalmanFilter.
+    double smoothed_x_position_rmse, smoothed_y_position_rmse;
+    size_t num_smoothed;
+
+    TraceReplayResult():max_position_deviation(0.0),max_heading_deviation(0.0),num_steps(0),
+        smoothed_x_position_rmse(0.0),smoothed_y_position_rmse(0.0),num_smoothed(0){}
+};
+
+// KalmanFilter with a fixed-lag RTS smoother fed from its prediction steps, lag steps behind the filter. Only the
+// filters that predict through linearisedPrediction() feed the smoother, i.e. the linear and extended ones.
+class SmoothingKalmanFilter : public KalmanFilter
+{
+    public:
+
+        explicit SmoothingKalmanFilter(int lag):m_smoother(lag){}
+
+        void reset(){KalmanFilter::reset(); m_smoother.reset();}
+        const FixedLagSmoother<StateSize>& getSmoother() const {return m_smoother;}
+
+    protected:
+
+        void onLinearisedPrediction(const StateVector& x, const CovarianceMatrix& P, const StateMatrix& F, 
+                                    const StateVector& x_predicted, const CovarianceMatrix& P_predicted, 
+                                    int angle_state) override
+        {
+            m_smoother.addPrediction(x, P, F, x_predicted, P_predicted, angle_state);
+        }
+
+    private:
+
+        FixedLagSmoother<StateSize> m_smoother;
+};
+
+// Feeds the recorded measurements of a trace into filter (which is reset first) in their original order and scores
+// it against the recorded ground truth and filter output. The trace doesn't store the beacon map, so map must be the
+// one it was recorded with (the default BeaconMap).
+TraceReplayResult replayTrace(const TraceReader& trace, KalmanFilter& filter, const BeaconMap& map);
+
+// As above, and also scores the smoothed estimates against the ground truth of the step they smooth.
+TraceReplayResult replayTrace(const TraceReader& trace, SmoothingKalmanFilter& filter, const BeaconMap& map);
+
+#endif  // INCLUDE_AKFSFSIM_TRACE_H
@@ -0,0 +1,47 @@
+#include <string>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+
+#include "miner/block.h"
+
+static void BM_HexStrToBinary(benchmark::State &state) {
+    const std::string merkleRoot = "3BA3EDFD7A7B12B27AC72C3E67768F617FC81BC3888A51323A9FB8AA4B1E5E4A";
+    for (auto _ : state) {
+        auto binary = miner::BlockHeader::hexStrToBinary(merkleRoot);
+        benchmark::DoNotOptimize(binary);
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * merkleRoot.size()));
+}
+BENCHMARK(BM_HexStrToBinary);
+
+static void BM_NbitsToThreshold(benchmark::State &state) {
+    uint32_t nbits = 0x1d00ffff;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(nbits);
+        auto threshold = miner::BlockHeader::nbitsToThreshold(nbits);
+        benchmark::DoNotOptimize(threshold);
+    }
+}
+BENCHMARK(BM_NbitsToThreshold);
+
+/// Parsing a text of header hex lines, as when replaying chain history.
+static void BM_ParseHeaders(benchmark::State &state) {
+    const std::string line = "01000000"
+        "81cd02ab7e569e8bcd9317e2fe99f2de44d49ab2b8851ba4a308000000000000"
+        "e320b6c2fffc8d750423db8b1eb942ae710e951ed797f7affc8892b0f1fc122b"
+        "c7f5d74df2b9441a42a14695\n";
+    std::string text;
+    for (int i = 0; i < state.range(0); ++i) {
+        text += line;
+    }
+
+    std::vector<miner::BlockHeader> headers;
+    for (auto _ : state) {
+        headers.clear();
+        benchmark::DoNotOptimize(miner::BlockHeader::parseHeaders(text, headers));
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * text.size()));
+}
+BENCHMARK(BM_ParseHeaders)->ArgName("headers")->Arg(10000);
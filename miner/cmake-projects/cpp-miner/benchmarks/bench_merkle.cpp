@@ -0,0 +1,45 @@
+#include <thread>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+
+#include "miner/merkle.h"
+
+static std::vector<miner::MerkleTree::Hash> makeLeaves(size_t n) {
+    std::vector<miner::MerkleTree::Hash> leaves(n);
+    uint32_t x = 1;
+    for (auto &leaf : leaves) {
+        for (auto &w : leaf) {
+            x = x * 1664525 + 1013904223;
+            w = x;
+        }
+    }
+    return leaves;
+}
+
+/// Building a whole tree. The arguments are the number of leaves and threads.
+static void BM_MerkleBuild(benchmark::State &state) {
+    const auto leaves = makeLeaves(static_cast<size_t>(state.range(0)));
+    const auto nThreads = static_cast<unsigned>(state.range(1));
+    for (auto _ : state) {
+        miner::MerkleTree tree(leaves, nThreads);
+        benchmark::DoNotOptimize(tree.root());
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * leaves.size()));
+}
+BENCHMARK(BM_MerkleBuild)
+    ->ArgNames({"leaves", "threads"})
+    ->ArgsProduct({{4096, 1 << 20}, {1, std::max<int64_t>(std::thread::hardware_concurrency(), 1)}})
+    ->UseRealTime();
+
+/// Replacing the coinbase, as done for every extranonce.
+static void BM_MerkleUpdateCoinbase(benchmark::State &state) {
+    miner::MerkleTree tree(makeLeaves(static_cast<size_t>(state.range(0))));
+    auto coinbase = tree.leaves().front();
+    for (auto _ : state) {
+        ++coinbase[0];
+        tree.setCoinbase(coinbase);
+        benchmark::DoNotOptimize(tree.root());
+    }
+}
+BENCHMARK(BM_MerkleUpdateCoinbase)->ArgName("leaves")->Arg(4096)->Arg(1 << 20);
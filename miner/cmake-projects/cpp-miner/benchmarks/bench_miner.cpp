@@ -0,0 +1,30 @@
+#include <algorithm>
+#include <thread>
+
+#include "benchmark/benchmark.h"
+
+#include "miner/block.h"
+#include "miner/miner.h"
+
+/// End-to-end hash rate of Miner::mineParallel for a given number of threads. Each iteration mines a fixed range of 
+/// the genesis block that holds no valid nonce, so every nonce in the range is hashed. items_per_second is the 
+/// aggregate hash rate.
+static void BM_MineParallel(benchmark::State &state) {
+    static constexpr uint32_t sNonces = 1U << 20;
+
+    const auto nThreads = static_cast<unsigned>(state.range(0));
+    auto header = miner::BlockHeader::genesisBlock();
+    uint64_t hashes = 0;
+    for (auto _ : state) {
+        auto result = miner::Miner::mineParallel(header, nThreads, 0, sNonces - 1);
+        benchmark::DoNotOptimize(result);
+        hashes += result.hashes;
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(hashes));
+}
+BENCHMARK(BM_MineParallel)
+    ->ArgName("threads")
+    ->RangeMultiplier(2)
+    ->Range(1, std::max(std::thread::hardware_concurrency(), 1U))
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
@@ -0,0 +1,117 @@
+#include <array>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+
+#include "miner/block.h"
+#include "miner/sha256.h"
+#include "miner/sha256_lanes.h"
+
+static void BM_HashBlock(benchmark::State &state) {
+    miner::Sha256::HashValue hash = miner::Sha256::sInitialHash;
+    miner::Sha256::Block block{};
+    for (auto _ : state) {
+        hash = miner::Sha256::hashBlock(hash, block);
+        benchmark::DoNotOptimize(hash);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_HashBlock);
+
+static void BM_HashBlockScalar(benchmark::State &state) {
+    miner::Sha256::HashValue hash = miner::Sha256::sInitialHash;
+    miner::Sha256::Block block{};
+    for (auto _ : state) {
+        hash = miner::Sha256::hashBlockScalar(hash, block);
+        benchmark::DoNotOptimize(hash);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_HashBlockScalar);
+
+static void BM_HashBlockShaNi(benchmark::State &state) {
+    if (!miner::Sha256::shaNiSupported()) {
+        state.SkipWithError("CPU does not support the SHA extensions");
+        return;
+    }
+    miner::Sha256::HashValue hash = miner::Sha256::sInitialHash;
+    miner::Sha256::Block block{};
+    for (auto _ : state) {
+        hash = miner::Sha256::hashBlockShaNi(hash, block);
+        benchmark::DoNotOptimize(hash);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_HashBlockShaNi);
+
+/// Sha256::hash on an 80-byte block header, the first pass of the bitcoin hash.
+static void BM_Hash80(benchmark::State &state) {
+    auto header = miner::BlockHeader::genesisBlock();
+    for (auto _ : state) {
+        auto hash = miner::Sha256::hash(header.data());
+        benchmark::DoNotOptimize(hash);
+    }
+    state.SetBytesProcessed(state.iterations() * 80);
+}
+BENCHMARK(BM_Hash80);
+
+/// Sha256::hash on a 32-byte hash, the second pass of the bitcoin hash.
+static void BM_Hash32(benchmark::State &state) {
+    miner::Sha256::HashValue hash = miner::Sha256::sInitialHash;
+    for (auto _ : state) {
+        hash = miner::Sha256::hash(hash);
+        benchmark::DoNotOptimize(hash);
+    }
+    state.SetBytesProcessed(state.iterations() * 32);
+}
+BENCHMARK(BM_Hash32);
+
+static void BM_DoubleHashHeader(benchmark::State &state) {
+    auto header = miner::BlockHeader::genesisBlock();
+    const auto midstate = miner::Sha256::midstate(header.data());
+    auto tail = miner::Sha256::tailBlock(header.data());
+    const auto maxTopWord = static_cast<uint32_t>(state.range(0));
+    miner::Sha256::HashValue hash;
+    for (auto _ : state) {
+        ++tail[3];
+        benchmark::DoNotOptimize(miner::Sha256::doubleHashHeader(midstate, tail, maxTopWord, hash));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_DoubleHashHeader)->ArgName("maxTopWord")->Arg(0)->Arg(0xFFFFFFFF);
+
+/// Double hashes of consecutive nonces through each multi-lane instruction set. The argument is the Isa value.
+static void BM_HashNonces(benchmark::State &state) {
+    const auto isa = static_cast<miner::Sha256Lanes::Isa>(state.range(0));
+    if (!miner::Sha256Lanes::supported(isa)) {
+        state.SkipWithError("CPU does not support this instruction set");
+        return;
+    }
+    state.SetLabel(miner::Sha256Lanes::name(isa));
+
+    auto header = miner::BlockHeader::genesisBlock();
+    const auto midstate = miner::Sha256::midstate(header.data());
+    const auto tail = miner::Sha256::tailBlock(header.data());
+    std::array<miner::Sha256::HashValue, 64> hashes;
+    uint32_t nonce = 0;
+    for (auto _ : state) {
+        miner::Sha256Lanes::hashNonces(isa, midstate, tail, nonce, hashes, 0);
+        benchmark::DoNotOptimize(hashes);
+        nonce += hashes.size();
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * hashes.size()));
+}
+BENCHMARK(BM_HashNonces)->ArgName("isa")->DenseRange(0, 3);
+
+/// Streaming throughput of Sha256::Context for different update sizes.
+static void BM_ContextUpdate(benchmark::State &state) {
+    std::vector<uint8_t> data(static_cast<size_t>(state.range(0)), 0xA5);
+    for (auto _ : state) {
+        miner::Sha256::Context context;
+        context.update(data);
+        auto hash = context.finalize();
+        benchmark::DoNotOptimize(hash);
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * data.size()));
+}
+BENCHMARK(BM_ContextUpdate)->RangeMultiplier(16)->Range(64, 1 << 24);
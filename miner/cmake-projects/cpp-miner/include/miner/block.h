@@ -4,10 +4,11 @@
 #include <cctype>
 #include <cstdint>
 #include <cstdlib>
-#include <map>
+#include <optional>
 #include <ranges>
 #include <span>
 #include <string>
+#include <string_view>
 #include <vector>
 
 namespace miner {
@@ -20,11 +21,13 @@ public:
     ///////////////////////////////////////////////////////////////////////////
 
     static constexpr size_t sHeaderSize = 20;
+    static constexpr size_t sNonceIndex = 19;
     static constexpr size_t sThresholdSize = 8;
     static constexpr size_t sHashSize = 8;
     static constexpr size_t sNibblesPerWord = 8;
     static constexpr size_t sBitsPerByte = 8;
     static constexpr size_t sBitsPerNibble = 4;
+    static constexpr size_t sHeaderHexSize = sHeaderSize * sNibblesPerWord;
 
     ///////////////////////////////////////////////////////////////////////////
     // PUBLIC TYPES
@@ -39,6 +42,10 @@ public:
     BlockHeader(const std::string &version, const std::string &prevhash, const std::string &merkleRoot, 
         const std::string &time, const std::string &nbits);
 
+    explicit BlockHeader(std::span<const uint32_t, sHeaderSize> words) {
+        std::ranges::copy(words, mBlockHeader);
+    }
+
     uint32_t version(void) const {
         return mBlockHeader[0];
     }
@@ -60,11 +67,19 @@ public:
     }
 
     uint32_t nonce(void) const {
-        return mBlockHeader[19];
+        return mBlockHeader[sNonceIndex];
     }
 
     void setNonce(uint32_t nonce) {
-        mBlockHeader[19] = nonce;
+        mBlockHeader[sNonceIndex] = nonce;
+    }
+
+    void setTime(uint32_t time) {
+        mBlockHeader[17] = time;
+    }
+
+    void setMerkleRoot(std::span<const uint32_t, 8> merkleRoot) {
+        std::ranges::copy(merkleRoot, mBlockHeader + 9);
     }
 
     std::span<uint32_t> data(void) {
@@ -75,6 +90,14 @@ public:
 
     static std::vector<uint32_t> hexStrToBinary(const std::string &hex);
 
+    static bool hexToWords(std::string_view hex, std::span<uint32_t> words);
+
+    static std::optional<BlockHeader> fromHex(std::string_view hex);
+
+    static bool parseHeaders(std::string_view text, std::vector<BlockHeader> &headers);
+
+    static std::optional<std::vector<BlockHeader>> parseHeaderFile(const std::string &path);
+
     static BlockHeader genesisBlock(void);
 
 private:
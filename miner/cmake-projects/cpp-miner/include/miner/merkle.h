@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstddef>
+#include <span>
+#include <vector>
+
+#include "miner/sha256.h"
+
+namespace miner {
+
+/// A bitcoin merkle tree over transaction hashes. Every level of the tree is kept so that changing one leaf, 
+/// usually the coinbase transaction when rolling the extranonce, only rehashes the path from that leaf to the root. 
+/// Hashes use the same convention as Sha256::hash: the bytes in memory are in the order they appear in a block.
+class MerkleTree {
+public:
+
+    ///////////////////////////////////////////////////////////////////////////
+    // PUBLIC CONSTANTS AND TYPES
+    ///////////////////////////////////////////////////////////////////////////
+
+    using Hash = Sha256::HashValue;
+
+    /// Levels with fewer pairs than this per thread are hashed on the calling thread.
+    static constexpr size_t sMinPairsPerThread = 4096;
+
+    ///////////////////////////////////////////////////////////////////////////
+    // PUBLIC FUNCTIONS
+    ///////////////////////////////////////////////////////////////////////////
+
+    explicit MerkleTree(std::vector<Hash> leaves, unsigned nThreads = 1);
+
+    const Hash &root(void) const {
+        return mLevels.back().front();
+    }
+
+    size_t size(void) const {
+        return mLevels.front().size();
+    }
+
+    std::span<const Hash> leaves(void) const {
+        return mLevels.front();
+    }
+
+    void updateLeaf(size_t index, const Hash &leaf);
+
+    void setCoinbase(const Hash &coinbase) {
+        updateLeaf(0, coinbase);
+    }
+
+    static Hash hashPair(const Hash &left, const Hash &right);
+
+    static void hashLevel(std::span<const Hash> level, std::span<Hash> parents, unsigned nThreads);
+
+private:
+
+    ///////////////////////////////////////////////////////////////////////////
+    // PRIVATE FIELDS
+    ///////////////////////////////////////////////////////////////////////////
+
+    /// mLevels[0] holds the leaves and mLevels.back() holds just the root.
+    std::vector<std::vector<Hash>> mLevels;
+
+};
+
+} // namespace miner
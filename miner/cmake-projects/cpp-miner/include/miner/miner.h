@@ -1,22 +1,68 @@
 #pragma once
 
+#include <atomic>
 #include <cstdint>
+#include <limits>
+#include <optional>
 
 #include "miner/block.h"
 #include "miner/sha256.h"
+#include "miner/telemetry.h"
+#include "miner/work.h"
 
 namespace miner {
 
 class Miner {
 public:
 
+    ///////////////////////////////////////////////////////////////////////////
+    // PUBLIC CONSTANTS AND TYPES
+    ///////////////////////////////////////////////////////////////////////////
+
+    /// The number of nonces a worker hashes between checks of the shared stop flag. Checking less often keeps the
+    /// cache line holding the flag out of the hot loop.
+    static constexpr uint32_t sStopCheckInterval = 4096;
+
+    /// The number of consecutive nonces handed to the multi-lane hasher at once. This is a multiple of the widest
+    /// lane count and divides sStopCheckInterval.
+    static constexpr uint32_t sNonceBatchSize = 64;
+
+    static constexpr uint32_t sMaxNonce = std::numeric_limits<uint32_t>::max();
+
+    /// Position of the nonce within the second SHA-256 block of the header.
+    static constexpr size_t sTailNonceIndex = BlockHeader::sNonceIndex - Sha256::sBlockSize;
+
+    /// The outcome of a parallel search. If no worker found a valid hash in the range, nonce is empty.
+    struct Result {
+        std::optional<uint32_t> nonce;
+        unsigned worker = 0;
+        uint64_t hashes = 0;
+    };
+
+    /// The outcome of mining from a work generator. If a valid hash was found, unit holds the work it was found in 
+    /// with the winning nonce set in its header.
+    struct WorkResult {
+        std::optional<WorkUnit> unit;
+        unsigned worker = 0;
+        uint64_t hashes = 0;
+    };
+
     ///////////////////////////////////////////////////////////////////////////
     // PUBLIC FUNCTIONS
     ///////////////////////////////////////////////////////////////////////////
 
     static bool validHash(const BlockHeader::Threshold &threshold, const Sha256::HashValue &hashValue);
 
-    static uint32_t mine(const uint32_t startNonce, BlockHeader &header);
+    static std::optional<uint32_t> mine(const uint32_t startNonce, BlockHeader &header, 
+        Telemetry *telemetry = nullptr);
+
+    static std::optional<uint32_t> mineRange(BlockHeader &header, uint32_t first, uint32_t last, 
+        std::atomic<bool> &stop, uint64_t &hashes, Telemetry *telemetry = nullptr, unsigned worker = 0);
+
+    static Result mineParallel(const BlockHeader &header, unsigned nThreads, uint32_t first = 0, 
+        uint32_t last = sMaxNonce, Telemetry *telemetry = nullptr);
+
+    static WorkResult mineWork(WorkGenerator &work, unsigned nThreads, Telemetry *telemetry = nullptr);
 };
 
-}
\ No newline at end of file
+}
@@ -0,0 +1,129 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include <variant>
+#include <vector>
+
+#include "miner/block.h"
+
+namespace miner {
+
+/// The wire protocol between a work server and its workers. Every message is a frame with an 8 byte header, the
+/// message type and the payload size, followed by the payload. All integers are little endian. Work is handed out
+/// in batches of units so a worker can keep a queue and never wait on the network for its next unit.
+class Protocol {
+public:
+
+    ///////////////////////////////////////////////////////////////////////////
+    // PUBLIC CONSTANTS AND TYPES
+    ///////////////////////////////////////////////////////////////////////////
+
+    enum class MessageType : uint32_t { RequestWork = 1, WorkBatch = 2, Share = 3, UnitDone = 4, Stop = 5 };
+
+    static constexpr size_t sFrameHeaderSize = 8;
+
+    /// Frames larger than this are treated as a protocol error.
+    static constexpr uint32_t sMaxPayloadSize = 1 << 20;
+
+    /// Worker to server: asks for up to count more units.
+    struct RequestWork {
+        uint32_t count;
+    };
+
+    /// A header and the nonces [firstNonce, lastNonce] to try on it.
+    struct WorkItem {
+        uint64_t unitId;
+        std::array<uint32_t, BlockHeader::sHeaderSize> header;
+        uint32_t firstNonce;
+        uint32_t lastNonce;
+    };
+
+    /// Server to worker: a batch of units.
+    struct WorkBatch {
+        std::vector<WorkItem> items;
+    };
+
+    /// Worker to server: a nonce in a unit that gives a valid hash.
+    struct Share {
+        uint64_t unitId;
+        uint32_t nonce;
+    };
+
+    /// Worker to server: every nonce of a unit has been tried.
+    struct UnitDone {
+        uint64_t unitId;
+        uint64_t hashes;
+    };
+
+    /// Server to worker: no more work is coming.
+    struct Stop {};
+
+    using Message = std::variant<RequestWork, WorkBatch, Share, UnitDone, Stop>;
+
+    ///////////////////////////////////////////////////////////////////////////
+    // PUBLIC FUNCTIONS
+    ///////////////////////////////////////////////////////////////////////////
+
+    static void encode(const Message &message, std::vector<uint8_t> &out);
+
+    static std::optional<Message> decode(std::vector<uint8_t> &in, bool &error);
+};
+
+/// A non-blocking TCP connection with buffered framing. Callers poll the descriptor, then call receive or flush.
+class Connection {
+public:
+
+    ///////////////////////////////////////////////////////////////////////////
+    // PUBLIC FUNCTIONS
+    ///////////////////////////////////////////////////////////////////////////
+
+    explicit Connection(int fd);
+
+    Connection(Connection &&other) noexcept;
+
+    Connection &operator=(Connection &&other) noexcept;
+
+    Connection(const Connection &) = delete;
+
+    Connection &operator=(const Connection &) = delete;
+
+    ~Connection();
+
+    static Connection connect(const std::string &host, uint16_t port);
+
+    int fd(void) const {
+        return mFd;
+    }
+
+    bool open(void) const {
+        return mFd >= 0;
+    }
+
+    bool wantsWrite(void) const {
+        return !mOutbox.empty();
+    }
+
+    void send(const Protocol::Message &message);
+
+    bool flush(void);
+
+    bool receive(std::vector<Protocol::Message> &messages);
+
+    void close(void);
+
+private:
+
+    ///////////////////////////////////////////////////////////////////////////
+    // PRIVATE FIELDS
+    ///////////////////////////////////////////////////////////////////////////
+
+    int mFd;
+    std::vector<uint8_t> mInbox;
+    std::vector<uint8_t> mOutbox;
+};
+
+} // namespace miner
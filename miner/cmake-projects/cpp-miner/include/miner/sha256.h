@@ -3,7 +3,10 @@
 #include <array>
 #include <bit>
 #include <cstdint>
+#include <limits>
+#include <optional>
 #include <span>
+#include <string>
 #include <tuple>
 
 namespace miner {
@@ -21,11 +24,22 @@ public:
     static constexpr uint32_t sHashSize = 8;
     static constexpr uint32_t sBlockSize = 16;
     static constexpr uint32_t sFirstPadWord = 0x80000000;
+    static constexpr uint32_t sHeaderSize = 20;
 
     using HashValue = std::array<uint32_t, sHashSize>;
     using Block = std::array<uint32_t, sBlockSize>;
     using BigBlock = std::array<uint32_t, 64>;
 
+    /// The message schedule words 8 to 15 of the second pass of a double hash. The 32-byte first hash fills words 0 to
+    /// 7 and the padding and length are always the same.
+    static constexpr Block sDigestPad = {
+        0, 0, 0, 0, 0, 0, 0, 0, sFirstPadWord, 0, 0, 0, 0, 0, 0, 32 * sHashSize
+    };
+
+    /// After this many rounds the working variable e holds the value that ends up in h, which is the most significant
+    /// word of a bitcoin hash.
+    static constexpr uint32_t sTopWordRound = 61;
+
     static constexpr HashValue sInitialHash = {
         0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
     };
@@ -93,9 +107,61 @@ public:
 
     static HashValue hashBlock(const HashValue &lastHash, const Block &block);
 
+    static HashValue hashBlockScalar(const HashValue &lastHash, const Block &block);
+
+    static HashValue hashBlockShaNi(const HashValue &lastHash, const Block &block);
+
+    static bool shaNiSupported(void);
+
     static HashValue hash(std::span<const uint32_t> dataSpan);
 
+    static HashValue midstate(std::span<const uint32_t> header);
+
+    static Block tailBlock(std::span<const uint32_t> header);
+
+    static HashValue hashTail(const HashValue &midstate, const Block &tail);
+
+    static bool doubleHashHeader(const HashValue &midstate, const Block &tail, uint32_t maxTopWord, HashValue &out);
+
+    static bool doubleHashHeaderScalar(const HashValue &midstate, const Block &tail, uint32_t maxTopWord, 
+        HashValue &out);
+
+    static bool doubleHashHeaderShaNi(const HashValue &midstate, const Block &tail, uint32_t maxTopWord, 
+        HashValue &out);
+
+    static HashValue doubleHashHeader(std::span<const uint32_t> header);
+
     static void printHash(const HashValue &hash);
+
+    static std::string toHex(const HashValue &hash);
+
+    static std::optional<HashValue> hashFile(const std::string &path);
+
+    ///////////////////////////////////////////////////////////////////////////
+    // STREAMING HASHER
+    ///////////////////////////////////////////////////////////////////////////
+
+    /// Incremental SHA-256 over a byte stream of any length. Call update as many times as needed and then finalize
+    /// once. Bytes that don't fill a block are kept until the next update, so the input is never copied as a whole.
+    /// The result uses the same convention as hash(): the bytes of the hash value in memory are the digest.
+    class Context {
+    public:
+
+        static constexpr size_t sBlockBytes = sBlockSize * sizeof(uint32_t);
+
+        void update(std::span<const uint8_t> data);
+
+        HashValue finalize(void);
+
+    private:
+
+        HashValue mState = sInitialHash;
+        std::array<uint8_t, sBlockBytes> mBuffer{};
+        size_t mBuffered = 0;
+        uint64_t mLength = 0;
+
+        void compress(const uint8_t *bytes);
+    };
 };
 
 } // namespace miner
\ No newline at end of file
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <span>
+
+#include "miner/sha256.h"
+
+namespace miner {
+
+/// Multi-lane SHA-256 for mining. Each lane of a SIMD register holds the state of an independent hash, so one pass
+/// of the 64 rounds hashes 4 (SSE2), 8 (AVX2) or 16 (AVX-512) nonces at once. The widest instruction set the CPU 
+/// supports is picked at runtime, with the scalar Sha256 functions as the fallback.
+class Sha256Lanes {
+public:
+
+    ///////////////////////////////////////////////////////////////////////////
+    // PUBLIC CONSTANTS AND TYPES
+    ///////////////////////////////////////////////////////////////////////////
+
+    enum class Isa { Scalar, Sse2, Avx2, Avx512 };
+
+    ///////////////////////////////////////////////////////////////////////////
+    // PUBLIC FUNCTIONS
+    ///////////////////////////////////////////////////////////////////////////
+
+    static bool supported(Isa isa);
+
+    static Isa best(void);
+
+    static uint32_t laneCount(Isa isa);
+
+    static const char *name(Isa isa);
+
+    static void hashNonces(const Sha256::HashValue &midstate, const Sha256::Block &tail, uint32_t firstNonce, 
+        std::span<Sha256::HashValue> out, uint32_t maxTopWord = std::numeric_limits<uint32_t>::max());
+
+    static void hashNonces(Isa isa, const Sha256::HashValue &midstate, const Sha256::Block &tail, 
+        uint32_t firstNonce, std::span<Sha256::HashValue> out, 
+        uint32_t maxTopWord = std::numeric_limits<uint32_t>::max());
+
+    static void hashPairs(std::span<const Sha256::HashValue> in, std::span<Sha256::HashValue> out);
+
+    static void hashPairs(Isa isa, std::span<const Sha256::HashValue> in, std::span<Sha256::HashValue> out);
+};
+
+} // namespace miner
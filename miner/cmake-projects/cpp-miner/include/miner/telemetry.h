@@ -0,0 +1,144 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <ostream>
+#include <thread>
+
+namespace miner {
+
+/// Hash rate and share counters for the mining threads. Each thread writes only to its own cache-line-aligned block
+/// of counters with relaxed atomics, so recording never takes a lock, never makes an I/O call and never shares a 
+/// cache line with another thread. A sampling thread sums the blocks once per interval, keeps rolling rates over the
+/// last 1, 10 and 60 seconds and the batch latency percentiles of the last interval, and can write a log line.
+class Telemetry {
+public:
+
+    ///////////////////////////////////////////////////////////////////////////
+    // PUBLIC CONSTANTS AND TYPES
+    ///////////////////////////////////////////////////////////////////////////
+
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr size_t sCacheLineSize = 64;
+
+    /// Batch latencies go in log-scale buckets, four per power of two, so percentiles are within 25% of the true 
+    /// value.
+    static constexpr size_t sSubBucketBits = 2;
+    static constexpr size_t sLatencyBuckets = 64 << sSubBucketBits;
+
+    static constexpr std::array<std::chrono::seconds, 3> sRateWindows = {
+        std::chrono::seconds(1), std::chrono::seconds(10), std::chrono::seconds(60)};
+
+    struct Snapshot {
+        uint64_t hashes = 0;
+        uint64_t shares = 0;
+        uint64_t staleUnits = 0;
+
+        /// Hashes per second over each of sRateWindows. A window longer than the time sampled so far uses all of it.
+        std::array<double, sRateWindows.size()> hashRates{};
+
+        /// Batch latency percentiles over the last sample interval.
+        std::chrono::nanoseconds batchLatencyP50{0};
+        std::chrono::nanoseconds batchLatencyP99{0};
+    };
+
+    ///////////////////////////////////////////////////////////////////////////
+    // PUBLIC FUNCTIONS
+    ///////////////////////////////////////////////////////////////////////////
+
+    explicit Telemetry(unsigned nThreads);
+
+    Telemetry(const Telemetry &) = delete;
+
+    Telemetry &operator=(const Telemetry &) = delete;
+
+    ~Telemetry();
+
+    unsigned threadCount(void) const {
+        return mThreadCount;
+    }
+
+    /// Called by mining thread worker after each batch of nonces.
+    void recordBatch(unsigned worker, uint64_t hashes, std::chrono::nanoseconds latency) {
+        auto &counters = mCounters[worker];
+        bump(counters.hashes, hashes);
+        bump(counters.latency[latencyBucket(static_cast<uint64_t>(latency.count()))], 1);
+    }
+
+    void recordShare(unsigned worker) {
+        bump(mCounters[worker].shares, 1);
+    }
+
+    /// A unit abandoned before every nonce in it was tried.
+    void recordStale(unsigned worker) {
+        bump(mCounters[worker].staleUnits, 1);
+    }
+
+    void start(Clock::duration interval = std::chrono::seconds(1), std::ostream *log = nullptr, 
+        unsigned logEvery = 10);
+
+    void stop(void);
+
+    void sample(Clock::time_point now);
+
+    Snapshot snapshot(void) const;
+
+    static void printSnapshot(std::ostream &out, const Snapshot &snapshot);
+
+    static size_t latencyBucket(uint64_t nanoseconds);
+
+    static uint64_t bucketLowerBound(size_t bucket);
+
+private:
+
+    ///////////////////////////////////////////////////////////////////////////
+    // PRIVATE TYPES
+    ///////////////////////////////////////////////////////////////////////////
+
+    struct alignas(sCacheLineSize) Counters {
+        std::atomic<uint64_t> hashes = 0;
+        std::atomic<uint64_t> shares = 0;
+        std::atomic<uint64_t> staleUnits = 0;
+        std::array<std::atomic<uint64_t>, sLatencyBuckets> latency{};
+    };
+
+    struct Sample {
+        Clock::time_point time;
+        uint64_t hashes;
+    };
+
+    ///////////////////////////////////////////////////////////////////////////
+    // PRIVATE FUNCTIONS
+    ///////////////////////////////////////////////////////////////////////////
+
+    /// Each counter has a single writer, so a plain load and store is enough and avoids a locked instruction.
+    static void bump(std::atomic<uint64_t> &counter, uint64_t n) {
+        counter.store(counter.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+
+    ///////////////////////////////////////////////////////////////////////////
+    // PRIVATE FIELDS
+    ///////////////////////////////////////////////////////////////////////////
+
+    const unsigned mThreadCount;
+    std::unique_ptr<Counters[]> mCounters;
+
+    /// Only the sampling thread and readers of snapshot() take this lock.
+    mutable std::mutex mMutex;
+    std::deque<Sample> mSamples;
+    std::array<uint64_t, sLatencyBuckets> mLastLatency{};
+    Snapshot mSnapshot;
+
+    std::condition_variable_any mWake;
+    std::jthread mSampler;
+};
+
+} // namespace miner
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <span>
+
+#include "miner/block.h"
+#include "miner/merkle.h"
+
+namespace miner {
+
+/// A header to mine and the range of nonces [firstNonce, lastNonce] to try on it.
+struct WorkUnit {
+    BlockHeader header;
+    uint32_t firstNonce;
+    uint32_t lastNonce;
+    uint64_t extranonce;
+};
+
+/// Hands out work to mining threads so they never run out. The nonce space of each header is cut into units. Once 
+/// every nonce of a header has been handed out, a new header is made by rolling the extranonce in the coinbase
+/// transaction, which changes the merkle root, or by rolling the time field if there are no transactions to change.
+/// next() is thread safe and only takes a lock for a moment per unit, so threads pull work with no idle gap.
+class WorkGenerator {
+public:
+
+    ///////////////////////////////////////////////////////////////////////////
+    // PUBLIC CONSTANTS AND TYPES
+    ///////////////////////////////////////////////////////////////////////////
+
+    /// Computes the hash of the coinbase transaction for an extranonce.
+    using CoinbaseFn = std::function<MerkleTree::Hash(uint64_t extranonce)>;
+
+    static constexpr uint64_t sDefaultUnitSize = uint64_t(1) << 24;
+
+    /// How far the time field may be rolled forward. Nodes reject blocks more than two hours in the future.
+    static constexpr uint32_t sMaxTimeRoll = 7200;
+
+    ///////////////////////////////////////////////////////////////////////////
+    // PUBLIC FUNCTIONS
+    ///////////////////////////////////////////////////////////////////////////
+
+    WorkGenerator(const BlockHeader &header, uint64_t unitSize = sDefaultUnitSize);
+
+    WorkGenerator(const BlockHeader &header, MerkleTree tree, CoinbaseFn coinbase, 
+        uint64_t unitSize = sDefaultUnitSize);
+
+    std::optional<WorkUnit> next(void);
+
+    static MerkleTree::Hash coinbaseHash(std::span<const uint8_t> prefix, uint64_t extranonce, 
+        std::span<const uint8_t> suffix);
+
+private:
+
+    ///////////////////////////////////////////////////////////////////////////
+    // PRIVATE FUNCTIONS
+    ///////////////////////////////////////////////////////////////////////////
+
+    bool rollHeader(void);
+
+    ///////////////////////////////////////////////////////////////////////////
+    // PRIVATE FIELDS
+    ///////////////////////////////////////////////////////////////////////////
+
+    std::mutex mMutex;
+    BlockHeader mHeader;
+    std::optional<MerkleTree> mTree;
+    CoinbaseFn mCoinbase;
+    uint64_t mUnitSize;
+    uint64_t mNextNonce = 0;
+    uint64_t mExtranonce = 0;
+    uint32_t mStartTime;
+};
+
+} // namespace miner
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "miner/protocol.h"
+
+namespace miner {
+
+/// A worker for a WorkServer. One thread owns the socket and keeps a local queue of units topped up, so the mining
+/// threads always have work ready when they finish a unit. Shares and finished units are sent back as they happen.
+class WorkClient {
+public:
+
+    ///////////////////////////////////////////////////////////////////////////
+    // PUBLIC CONSTANTS
+    ///////////////////////////////////////////////////////////////////////////
+
+    static constexpr int sPollTimeoutMs = 20;
+
+    ///////////////////////////////////////////////////////////////////////////
+    // PUBLIC FUNCTIONS
+    ///////////////////////////////////////////////////////////////////////////
+
+    /// Connects to the server. Throws std::runtime_error if the connection fails.
+    WorkClient(const std::string &host, uint16_t port, unsigned nThreads, uint32_t batchSize = 8);
+
+    WorkClient(const WorkClient &) = delete;
+
+    WorkClient &operator=(const WorkClient &) = delete;
+
+    void run(void);
+
+    void stop(void);
+
+    uint64_t hashes(void) const {
+        return mHashes.load();
+    }
+
+    uint64_t shares(void) const {
+        return mShares.load();
+    }
+
+    uint64_t unitsDone(void) const {
+        return mUnitsDone.load();
+    }
+
+private:
+
+    ///////////////////////////////////////////////////////////////////////////
+    // PRIVATE FUNCTIONS
+    ///////////////////////////////////////////////////////////////////////////
+
+    void mineUnits(unsigned worker);
+
+    void post(const Protocol::Message &message);
+
+    ///////////////////////////////////////////////////////////////////////////
+    // PRIVATE FIELDS
+    ///////////////////////////////////////////////////////////////////////////
+
+    Connection mConnection;
+    const unsigned mThreadCount;
+    const uint32_t mBatchSize;
+    std::atomic<bool> mStop = false;
+
+    /// One flag per mining thread. mineRange raises the flag it is given when it finds a nonce, so the threads
+    /// can't share mStop. stop() raises all of them.
+    std::vector<std::atomic<bool>> mWorkerStop;
+
+    std::mutex mQueueMutex;
+    std::condition_variable mQueueReady;
+    std::deque<Protocol::WorkItem> mQueue;
+    bool mRequestPending = false;
+
+    /// Messages from the mining threads waiting to be written by the network thread.
+    std::mutex mOutboxMutex;
+    std::vector<Protocol::Message> mOutbox;
+
+    std::atomic<uint64_t> mHashes = 0;
+    std::atomic<uint64_t> mShares = 0;
+    std::atomic<uint64_t> mUnitsDone = 0;
+};
+
+} // namespace miner
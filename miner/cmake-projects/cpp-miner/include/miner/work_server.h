@@ -0,0 +1,132 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <list>
+#include <mutex>
+#include <set>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "miner/protocol.h"
+#include "miner/work.h"
+
+namespace miner {
+
+/// The coordinator for distributed mining. It hands out units from a WorkGenerator to workers over TCP and 
+/// collects the shares they find. If a worker drops, the units it had not finished are handed to the next worker
+/// that asks for work. Once the generator is exhausted, requests are held until a dropped worker's units come back
+/// or every unit is done, and then the server tells the workers to stop and run() returns. All sockets are served 
+/// from one thread with poll.
+class WorkServer {
+public:
+
+    ///////////////////////////////////////////////////////////////////////////
+    // PUBLIC CONSTANTS AND TYPES
+    ///////////////////////////////////////////////////////////////////////////
+
+    /// The most units sent in reply to one request.
+    static constexpr uint32_t sMaxBatchSize = 256;
+
+    static constexpr int sPollTimeoutMs = 20;
+
+    /// A verified share: the header of the unit with the winning nonce set.
+    struct FoundShare {
+        uint64_t unitId;
+        uint64_t extranonce;
+        BlockHeader header;
+    };
+
+    struct Stats {
+        uint64_t unitsIssued = 0;
+        uint64_t unitsCompleted = 0;
+        uint64_t unitsReassigned = 0;
+        uint64_t hashes = 0;
+        uint64_t invalidShares = 0;
+    };
+
+    ///////////////////////////////////////////////////////////////////////////
+    // PUBLIC FUNCTIONS
+    ///////////////////////////////////////////////////////////////////////////
+
+    explicit WorkServer(WorkGenerator &work, uint16_t port = 0);
+
+    WorkServer(const WorkServer &) = delete;
+
+    WorkServer &operator=(const WorkServer &) = delete;
+
+    ~WorkServer();
+
+    uint16_t port(void) const {
+        return mPort;
+    }
+
+    void run(void);
+
+    void stop(void) {
+        mStop.store(true);
+    }
+
+    /// True once run() has returned, either after stop() or because all the work is done.
+    bool finished(void) const {
+        return mFinished.load();
+    }
+
+    std::vector<FoundShare> shares(void) const;
+
+    Stats stats(void) const;
+
+    bool completed(uint64_t unitId) const;
+
+private:
+
+    ///////////////////////////////////////////////////////////////////////////
+    // PRIVATE TYPES
+    ///////////////////////////////////////////////////////////////////////////
+
+    struct Peer {
+        Connection connection;
+        std::unordered_map<uint64_t, WorkUnit> assigned;
+        /// Units asked for while there was no work to hand out.
+        uint32_t deferred = 0;
+    };
+
+    ///////////////////////////////////////////////////////////////////////////
+    // PRIVATE FUNCTIONS
+    ///////////////////////////////////////////////////////////////////////////
+
+    void accept(void);
+
+    void handle(Peer &peer, const Protocol::Message &message);
+
+    void sendWork(Peer &peer, uint32_t count);
+
+    void dropPeer(Peer &peer);
+
+    bool workDone(void) const;
+
+    ///////////////////////////////////////////////////////////////////////////
+    // PRIVATE FIELDS
+    ///////////////////////////////////////////////////////////////////////////
+
+    WorkGenerator &mWork;
+    int mListenFd = -1;
+    uint16_t mPort = 0;
+    std::atomic<bool> mStop = false;
+    std::atomic<bool> mFinished = false;
+    /// Set when the generator runs out of units.
+    bool mExhausted = false;
+    std::list<Peer> mPeers;
+    /// Units taken back from dropped workers. They keep their ids.
+    std::deque<std::pair<uint64_t, WorkUnit>> mRequeue;
+    uint64_t mNextUnitId = 0;
+
+    mutable std::mutex mMutex;
+    std::vector<FoundShare> mShares;
+    std::set<uint64_t> mCompleted;
+    Stats mStats;
+};
+
+} // namespace miner
@@ -1,4 +1,9 @@
+#include <bit>
 #include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
 #include <string>
 
 #include "miner/block.h"
@@ -12,11 +17,14 @@ BlockHeader::BlockHeader(const std::string &version, const std::string &prevhash
         (time.size() == 8) && (nbits.size() == 8);
 
     if (ok) {
-        std::ranges::copy(hexStrToBinary(version), mBlockHeader);
-        std::ranges::copy(hexStrToBinary(prevhash), mBlockHeader + 1);
-        std::ranges::copy(hexStrToBinary(merkleRoot), mBlockHeader + 9);
-        std::ranges::copy(hexStrToBinary(time), mBlockHeader + 17);
-        std::ranges::copy(hexStrToBinary(nbits), mBlockHeader + 18);
+        ok = hexToWords(version, std::span(mBlockHeader, 1));
+        ok = hexToWords(prevhash, std::span(mBlockHeader + 1, 8)) && ok;
+        ok = hexToWords(merkleRoot, std::span(mBlockHeader + 9, 8)) && ok;
+        ok = hexToWords(time, std::span(mBlockHeader + 17, 1)) && ok;
+        ok = hexToWords(nbits, std::span(mBlockHeader + 18, 1)) && ok;
+        if (!ok) {
+            throw std::out_of_range("invalid hex digit");
+        }
     }
 }
 
@@ -42,28 +50,124 @@ BlockHeader::Threshold BlockHeader::nbitsToThreshold(uint32_t nbits) {
     return threshold;
 }
 
+namespace {
+
+// The hex is copied into registers and words with memcpy, which puts the first character in the least significant
+// byte only on a little-endian host.
+static_assert(std::endian::native == std::endian::little);
+
+constexpr uint64_t sOnes = 0x0101010101010101ULL;
+constexpr uint64_t sHighBits = 0x8080808080808080ULL;
+
+/// Decodes eight hex characters packed little endian into a uint64_t, eight characters at a time in one register. 
+/// Returns false if any of them is not a hex digit.
+///
+/// The range checks rely on every byte being below 0x80 so adding to a byte never carries into the next one. A 
+/// byte's high bit is set by the first addition when it is at least the lower bound and cleared by the second
+/// when it is past the upper bound.
+bool decodeWord(uint64_t chars, uint32_t &word) {
+    const uint64_t lower = chars | (0x20 * sOnes);
+    const uint64_t digit = (chars + (0x80 - '0') * sOnes) & ~(chars + (0x80 - '9' - 1) * sOnes);
+    const uint64_t letter = (lower + (0x80 - 'a') * sOnes) & ~(lower + (0x80 - 'f' - 1) * sOnes);
+    const bool valid = ((chars & sHighBits) == 0) && (((digit | letter) & sHighBits) == sHighBits);
+
+    // '0'-'9' have bit 6 clear and 'A'-'F'/'a'-'f' have it set, so the nibble is the low four bits plus 9 for 
+    // letters.
+    const uint64_t nibbles = (chars & (0x0F * sOnes)) + 9 * ((chars >> 6) & sOnes);
+
+    // The first character of each pair is the upper nibble of its byte. Pack the pairs into bytes and then squeeze
+    // the bytes together.
+    constexpr uint64_t sEvenBytes = 0x000F000F000F000FULL;
+    uint64_t bytes = ((nibbles & sEvenBytes) << BlockHeader::sBitsPerNibble) | ((nibbles >> 8) & sEvenBytes);
+    bytes = (bytes | (bytes >> 8)) & 0x0000FFFF0000FFFFULL;
+    bytes = (bytes | (bytes >> 16)) & 0x00000000FFFFFFFFULL;
+
+    word = static_cast<uint32_t>(bytes);
+    return valid;
+}
+
+} // namespace
+
+/// Converts a hex string to words without allocating. We use little endian representation. The first byte is the 
+/// least significant byte of the first word. A final partial word is filled from its least significant byte. words
+/// must hold exactly one word per eight characters, rounded up. Returns false if the sizes don't match or any 
+/// character is not a hex digit.
+bool BlockHeader::hexToWords(std::string_view hex, std::span<uint32_t> words) {
+
+    if (words.size() != (hex.size() + sNibblesPerWord - 1) / sNibblesPerWord) {
+        return false;
+    }
+
+    bool valid = true;
+    for (size_t i = 0; i < words.size(); ++i) {
+        const size_t n = std::min(sNibblesPerWord, hex.size() - i * sNibblesPerWord);
+
+        // A partial word is padded with '0's, which decode to zero nibbles.
+        uint64_t chars = 0x3030303030303030ULL;
+        std::memcpy(&chars, hex.data() + i * sNibblesPerWord, n);
+        valid = decodeWord(chars, words[i]) && valid;
+    }
+    return valid;
+}
+
 /// Converts a hex string to a binary representation. We use little endian representation. The first bytes
-/// is the least significant byte of the first word.
+/// is the least significant byte of the first word. Throws std::out_of_range if a character is not a hex digit.
 std::vector<uint32_t> BlockHeader::hexStrToBinary(const std::string &hex) {
+    std::vector<uint32_t> binary((hex.size() + sNibblesPerWord - 1) / sNibblesPerWord);
+    if (!hexToWords(hex, binary)) {
+        throw std::out_of_range("invalid hex digit");
+    }
+    return binary;
+}
 
-    static const std::map<char, uint32_t> lookup = {
-        {'0', 0}, {'1', 1}, {'2', 2}, {'3', 3}, {'4', 4}, {'5', 5}, {'6', 6}, {'7', 7}, {'8', 8}, 
-        {'9', 9}, {'A', 10}, {'B', 11}, {'C', 12}, {'D', 13}, {'E', 14}, {'F', 15}
-    };
-
-    std::vector<uint32_t> binary;
-    for (auto elem : hex | std::views::chunk(sNibblesPerWord)) {
-        uint32_t value = 0;
-        uint32_t shift = 0;
-        bool upperNibble = true;
-        for (auto e : elem) {
-            value += lookup.at(toupper(e)) << (shift + (upperNibble ? 4 : 0));
-            shift += upperNibble ? 0 : sBitsPerByte;
-            upperNibble = !upperNibble;
+/// Parses a whole serialised header of 160 hex characters, in the byte order used on the wire.
+std::optional<BlockHeader> BlockHeader::fromHex(std::string_view hex) {
+    std::array<uint32_t, sHeaderSize> words;
+    if (hex.size() != sHeaderHexSize || !hexToWords(hex, words)) {
+        return std::nullopt;
+    }
+    return BlockHeader(words);
+}
+
+/// Parses one header per line and appends them to headers. Blank lines and carriage returns are skipped. The
+/// headers are decoded straight into the vector, so nothing is allocated per header. Returns false at the first 
+/// line that isn't a valid header.
+bool BlockHeader::parseHeaders(std::string_view text, std::vector<BlockHeader> &headers) {
+    headers.reserve(headers.size() + text.size() / (sHeaderHexSize + 1));
+    while (!text.empty()) {
+        const size_t end = std::min(text.find('\n'), text.size());
+        std::string_view line = text.substr(0, end);
+        text.remove_prefix(std::min(end + 1, text.size()));
+
+        if (!line.empty() && line.back() == '\r') {
+            line.remove_suffix(1);
         }
-        binary.push_back(value); 
-    } 
-    return binary;
+        if (line.empty()) {
+            continue;
+        }
+        auto header = fromHex(line);
+        if (!header.has_value()) {
+            return false;
+        }
+        headers.push_back(*header);
+    }
+    return true;
+}
+
+/// Reads a file of header hex lines with a single read and parses it. Returns nothing if the file can't be read or
+/// holds an invalid line.
+std::optional<std::vector<BlockHeader>> BlockHeader::parseHeaderFile(const std::string &path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        return std::nullopt;
+    }
+    std::string text{std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+
+    std::vector<BlockHeader> headers;
+    if (!parseHeaders(text, headers)) {
+        return std::nullopt;
+    }
+    return headers;
 }
 
 BlockHeader BlockHeader::genesisBlock(void) {
@@ -1,20 +1,96 @@
+#include <chrono>
 #include <iostream>
+#include <string>
+#include <thread>
 
 #include "miner/block.h"
 #include "miner/miner.h"
+#include "miner/work.h"
+#include "miner/work_client.h"
+#include "miner/work_server.h"
 
 static constexpr uint32_t sStartNonce = 2080000000UL;
 
-int main() {
+/// Prints the SHA-256 digest of each file in the same format as sha256sum.
+static int hashFiles(int argc, char **argv) {
+    int status = 0;
+    for (int i = 2; i < argc; ++i) {
+        auto hashValue = miner::Sha256::hashFile(argv[i]);
+        if (!hashValue.has_value()) {
+            std::cerr << "Failed to read " << argv[i] << '\n';
+            status = 1;
+            continue;
+        }
+        std::cout << miner::Sha256::toHex(*hashValue) << "  " << argv[i] << '\n';
+    }
+    return status;
+}
+
+/// Hands out work on the genesis block to workers that connect on the given port and prints each share they find.
+/// Returns once every unit of the work has been done.
+static int serve(uint16_t port) {
+    miner::WorkGenerator work(miner::BlockHeader::genesisBlock());
+    miner::WorkServer server(work, port);
+    std::cout << "Serving work on port " << server.port() << '\n';
+
+    std::jthread serverThread([&] { server.run(); });
+    size_t reported = 0;
+    bool finished = false;
+    while (!finished) {
+        std::this_thread::sleep_for(std::chrono::seconds(1));
+        finished = server.finished();
+        const auto shares = server.shares();
+        for (; reported < shares.size(); ++reported) {
+            auto header = shares[reported].header;
+            std::cout << "Share in unit " << shares[reported].unitId << ", nonce " << header.nonce() << '\n';
+            miner::Sha256::printHash(miner::Sha256::doubleHashHeader(header.data()));
+        }
+    }
+
+    const auto stats = server.stats();
+    std::cout << "Work done: " << stats.unitsCompleted << " units, " << stats.hashes << " hashes\n";
+    return 0;
+}
+
+/// Mines units from a work server on every hardware thread until the server stops.
+static int connect(const std::string &host, uint16_t port) {
+    const unsigned nThreads = std::max(std::thread::hardware_concurrency(), 1U);
+    miner::WorkClient client(host, port, nThreads);
+    client.run();
+    std::cout << "Worker done: " << client.unitsDone() << " units, " << client.hashes() << " hashes, " 
+        << client.shares() << " shares\n";
+    return 0;
+}
+
+int main(int argc, char **argv) {
+
+    if (argc > 1 && std::string(argv[1]) == "--hash-file") {
+        return hashFiles(argc, argv);
+    }
+    if (argc > 2 && std::string(argv[1]) == "--serve") {
+        return serve(static_cast<uint16_t>(std::stoul(argv[2])));
+    }
+    if (argc > 3 && std::string(argv[1]) == "--connect") {
+        return connect(argv[2], static_cast<uint16_t>(std::stoul(argv[3])));
+    }
 
     miner::BlockHeader header = miner::BlockHeader::genesisBlock();
 
-    auto nonce = miner::Miner::mine(sStartNonce, header);
-    
+    const unsigned nThreads = std::max(std::thread::hardware_concurrency(), 1U);
+    miner::Telemetry telemetry(nThreads);
+    telemetry.start(std::chrono::seconds(1), &std::cout);
+    auto result = miner::Miner::mineParallel(header, nThreads, sStartNonce, miner::Miner::sMaxNonce, &telemetry);
+    telemetry.stop();
+    if (!result.nonce.has_value()) {
+        std::cout << "No valid nonce found.\n";
+        return 1;
+    }
+
+    const uint32_t nonce = *result.nonce;
     header.setNonce(nonce);
-    auto hashValue = miner::Sha256::hash(miner::Sha256::hash(header.data()));
+    auto hashValue = miner::Sha256::doubleHashHeader(header.data());
 
-    std::cout << "Block solved ! Nonce: " << nonce << '\n';
+    std::cout << "Block solved ! Nonce: " << nonce << " (worker " << result.worker << " of " << nThreads << ")\n";
     miner::Sha256::printHash(hashValue);
     
     return 0;
@@ -0,0 +1,76 @@
+#include <algorithm>
+#include <thread>
+
+#include "miner/merkle.h"
+#include "miner/sha256_lanes.h"
+
+namespace miner {
+
+/// Builds every level of the tree. A tree with no leaves has an all-zero root.
+MerkleTree::MerkleTree(std::vector<Hash> leaves, unsigned nThreads) {
+    if (leaves.empty()) {
+        leaves.push_back(Hash{});
+    }
+    mLevels.push_back(std::move(leaves));
+
+    while (mLevels.back().size() > 1) {
+        const auto &level = mLevels.back();
+        std::vector<Hash> parents((level.size() + 1) / 2);
+        hashLevel(level, parents, nThreads);
+        mLevels.push_back(std::move(parents));
+    }
+}
+
+/// Replaces one leaf and rehashes only the nodes on the path from it to the root.
+void MerkleTree::updateLeaf(size_t index, const Hash &leaf) {
+    mLevels.front().at(index) = leaf;
+
+    for (size_t k = 0; k + 1 < mLevels.size(); ++k) {
+        const auto &level = mLevels[k];
+        const size_t left = index & ~size_t(1);
+        const size_t right = std::min(left + 1, level.size() - 1);
+        index /= 2;
+        mLevels[k + 1][index] = hashPair(level[left], level[right]);
+    }
+}
+
+/// The double SHA-256 of two concatenated hashes.
+MerkleTree::Hash MerkleTree::hashPair(const Hash &left, const Hash &right) {
+    Sha256::Block block;
+    std::ranges::copy(left, block.begin());
+    std::ranges::copy(right, block.begin() + Sha256::sHashSize);
+    return Sha256::hash(Sha256::hash(block));
+}
+
+/// Hashes one level of the tree into its parents. If the level has an odd number of nodes, the last node is paired
+/// with itself. Pairs are hashed in batches through the multi-lane hasher. Large levels are also split into one 
+/// contiguous chunk per thread.
+void MerkleTree::hashLevel(std::span<const Hash> level, std::span<Hash> parents, unsigned nThreads) {
+
+    const size_t nFullPairs = level.size() / 2;
+    auto evenLevel = level.first(2 * nFullPairs);
+    auto fullParents = parents.first(nFullPairs);
+
+    const size_t maxThreads = std::max<size_t>(nFullPairs / sMinPairsPerThread, 1);
+    const size_t nChunks = std::min<size_t>(std::max(nThreads, 1U), maxThreads);
+    const size_t chunkSize = (nFullPairs + nChunks - 1) / nChunks;
+
+    if (nChunks == 1) {
+        Sha256Lanes::hashPairs(evenLevel, fullParents);
+    } else {
+        std::vector<std::jthread> workers;
+        workers.reserve(nChunks);
+        for (size_t first = 0; first < nFullPairs; first += chunkSize) {
+            const size_t count = std::min(chunkSize, nFullPairs - first);
+            workers.emplace_back([=]() {
+                Sha256Lanes::hashPairs(evenLevel.subspan(2 * first, 2 * count), fullParents.subspan(first, count));
+            });
+        }
+    }
+
+    if (level.size() % 2 == 1) {
+        parents.back() = hashPair(level.back(), level.back());
+    }
+}
+
+} // namespace miner
@@ -1,10 +1,13 @@
 #include <algorithm>
+#include <array>
 #include <bit>
 #include <chrono>
-#include <iostream>
 #include <string>
+#include <thread>
+#include <vector>
 
 #include "miner/miner.h"
+#include "miner/sha256_lanes.h"
 
 namespace miner {
 
@@ -15,36 +18,203 @@ bool Miner::validHash(const BlockHeader::Threshold &threshold, const Sha256::Has
     return std::ranges::lexicographical_compare(lhs, rhs);
 }
 
-uint32_t Miner::mine(const uint32_t startNonce, BlockHeader &header) {
+/// Mines on one thread from startNonce until a valid hash is found. When the nonces run out the time field is rolled
+/// forward, at most WorkGenerator::sMaxTimeRoll seconds; returns nothing if that is exhausted too. If telemetry is
+/// given, the hash rate is recorded as worker 0 every sStopCheckInterval nonces.
+std::optional<uint32_t> Miner::mine(const uint32_t startNonce, BlockHeader &header, Telemetry *telemetry) {
 
     auto threshold = BlockHeader::nbitsToThreshold(header.nbits());
+    const auto midstate = Sha256::midstate(header.data());
+    auto tail = Sha256::tailBlock(header.data());
+    const uint32_t startTime = header.time();
     uint32_t nonce = startNonce;
     uint32_t count = 0;
 
-    auto start = std::chrono::steady_clock::now();
+    auto start = Telemetry::Clock::now();
 
     while (true) {
         
-        header.setNonce(nonce);
-        auto hashValue = Sha256::hash(header.data());
-        hashValue = Sha256::hash(hashValue);
+        tail[sTailNonceIndex] = nonce;
+        Sha256::HashValue hashValue;
         
-        if (validHash(threshold, hashValue)) {
+        if (Sha256::doubleHashHeader(midstate, tail, threshold[7], hashValue) && validHash(threshold, hashValue)) {
+            header.setNonce(nonce);
+            if (telemetry != nullptr) {
+                telemetry->recordBatch(0, count + 1, Telemetry::Clock::now() - start);
+                telemetry->recordShare(0);
+            }
             return nonce;
         }
         
-        if (count == 10000) {
-            std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
-            long duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
-            double hashrate = 10000000.0 / static_cast<double>(duration);
-            std::cout << "Currently mining at " << hashrate << " hashes / second" << std::endl;
-            start = std::chrono::steady_clock::now();
+        if (count == sStopCheckInterval) {
+            if (telemetry != nullptr) {
+                const auto end = Telemetry::Clock::now();
+                telemetry->recordBatch(0, count, end - start);
+                start = end;
+            }
             count = 0;
         }
 
+        // Roll the time field rather than repeat the nonces already tried. The time is in the tail block so the 
+        // midstate stays the same.
+        if (nonce == sMaxNonce) {
+            if (header.time() - startTime >= WorkGenerator::sMaxTimeRoll) {
+                if (telemetry != nullptr) {
+                    telemetry->recordBatch(0, count + 1, Telemetry::Clock::now() - start);
+                }
+                return std::nullopt;
+            }
+            header.setTime(header.time() + 1);
+            tail = Sha256::tailBlock(header.data());
+        }
+
         nonce++;
         count++;
     }
 }
 
+/// Searches the nonces in [first, last] for a valid hash. The search gives up early if another worker sets the stop
+/// flag. If this worker finds a valid hash it sets the stop flag itself so its peers stop too. The number of hashes
+/// computed is written to hashes when the search finishes. If telemetry is given, each interval between stop checks
+/// is recorded as a batch of the given worker.
+std::optional<uint32_t> Miner::mineRange(BlockHeader &header, uint32_t first, uint32_t last, 
+    std::atomic<bool> &stop, uint64_t &hashes, Telemetry *telemetry, unsigned worker) {
+
+    const auto threshold = BlockHeader::nbitsToThreshold(header.nbits());
+    const auto midstate = Sha256::midstate(header.data());
+    const auto tail = Sha256::tailBlock(header.data());
+    std::array<Sha256::HashValue, sNonceBatchSize> batch;
+    uint64_t nonce = first;
+
+    while (nonce <= last) {
+        if (stop.load(std::memory_order_relaxed)) {
+            break;
+        }
+
+        const uint64_t intervalEnd = std::min<uint64_t>(nonce + sStopCheckInterval - 1, last);
+        const uint64_t intervalFirst = nonce;
+        const auto intervalStart = telemetry != nullptr ? Telemetry::Clock::now() : Telemetry::Clock::time_point{};
+        while (nonce <= intervalEnd) {
+            const auto count = static_cast<size_t>(std::min<uint64_t>(sNonceBatchSize, intervalEnd - nonce + 1));
+            auto hashValues = std::span(batch).first(count);
+            Sha256Lanes::hashNonces(midstate, tail, static_cast<uint32_t>(nonce), hashValues, threshold[7]);
+            
+            // Hashes whose top word is above the threshold are left incomplete, but validHash rejects them on the 
+            // top word before looking at the rest.
+            for (size_t i = 0; i < count; ++i) {
+                if (validHash(threshold, hashValues[i])) {
+                    const auto result = static_cast<uint32_t>(nonce + i);
+                    header.setNonce(result);
+                    stop.store(true, std::memory_order_relaxed);
+                    hashes = nonce + count - first;
+                    if (telemetry != nullptr) {
+                        telemetry->recordBatch(worker, nonce + count - intervalFirst, 
+                            Telemetry::Clock::now() - intervalStart);
+                        telemetry->recordShare(worker);
+                    }
+                    return result;
+                }
+            }
+            nonce += count;
+        }
+
+        if (telemetry != nullptr) {
+            telemetry->recordBatch(worker, nonce - intervalFirst, Telemetry::Clock::now() - intervalStart);
+        }
+    }
+
+    hashes = nonce - first;
+    return std::nullopt;
+}
+
+/// Splits the nonces in [first, last] into one contiguous chunk per thread and mines them in parallel. All workers
+/// stop as soon as one of them finds a valid hash. If more than one worker finds a hash before noticing the stop
+/// flag, the worker with the lowest index wins. A telemetry, if given, needs a counter block for each thread.
+Miner::Result Miner::mineParallel(const BlockHeader &header, unsigned nThreads, uint32_t first, uint32_t last, 
+    Telemetry *telemetry) {
+
+    nThreads = std::max(nThreads, 1U);
+    const uint64_t rangeSize = static_cast<uint64_t>(last) - first + 1;
+    const uint64_t chunkSize = (rangeSize + nThreads - 1) / nThreads;
+
+    std::atomic<bool> stop = false;
+    std::vector<std::optional<uint32_t>> nonces(nThreads);
+    std::vector<uint64_t> hashes(nThreads, 0);
+
+    {
+        std::vector<std::jthread> workers;
+        workers.reserve(nThreads);
+        for (unsigned i = 0; i < nThreads; ++i) {
+            const uint64_t chunkFirst = first + i * chunkSize;
+            if (chunkFirst > last) {
+                break;
+            }
+            const uint64_t chunkLast = std::min<uint64_t>(chunkFirst + chunkSize - 1, last);
+            workers.emplace_back([&, i, chunkFirst, chunkLast, copy = header]() mutable {
+                nonces[i] = mineRange(copy, static_cast<uint32_t>(chunkFirst), static_cast<uint32_t>(chunkLast), 
+                    stop, hashes[i], telemetry, i);
+            });
+        }
+    }
+
+    Result result;
+    for (unsigned i = 0; i < nThreads; ++i) {
+        result.hashes += hashes[i];
+        if (!result.nonce.has_value() && nonces[i].has_value()) {
+            result.nonce = nonces[i];
+            result.worker = i;
+        }
+    }
+    return result;
+}
+
+/// Mines units from the work generator on nThreads threads until one of them finds a valid hash or the generator 
+/// runs out of work. Each thread pulls its next unit as soon as it finishes the last one. A telemetry, if given,
+/// needs a counter block for each thread.
+Miner::WorkResult Miner::mineWork(WorkGenerator &work, unsigned nThreads, Telemetry *telemetry) {
+
+    nThreads = std::max(nThreads, 1U);
+
+    std::atomic<bool> stop = false;
+    std::vector<std::optional<WorkUnit>> solved(nThreads);
+    std::vector<uint64_t> hashes(nThreads, 0);
+
+    {
+        std::vector<std::jthread> workers;
+        workers.reserve(nThreads);
+        for (unsigned i = 0; i < nThreads; ++i) {
+            workers.emplace_back([&, i]() {
+                while (!stop.load(std::memory_order_relaxed)) {
+                    auto unit = work.next();
+                    if (!unit.has_value()) {
+                        break;
+                    }
+                    uint64_t unitHashes = 0;
+                    auto nonce = mineRange(unit->header, unit->firstNonce, unit->lastNonce, stop, unitHashes, 
+                        telemetry, i);
+                    hashes[i] += unitHashes;
+                    if (nonce.has_value()) {
+                        solved[i] = unit;
+                        break;
+                    }
+                    // Another worker found a hash before this unit was finished, so the rest of it is stale.
+                    if (telemetry != nullptr && unitHashes < uint64_t(unit->lastNonce) - unit->firstNonce + 1) {
+                        telemetry->recordStale(i);
+                    }
+                }
+            });
+        }
+    }
+
+    WorkResult result;
+    for (unsigned i = 0; i < nThreads; ++i) {
+        result.hashes += hashes[i];
+        if (!result.unit.has_value() && solved[i].has_value()) {
+            result.unit = solved[i];
+            result.worker = i;
+        }
+    }
+    return result;
+}
+
 } // namespace miner
\ No newline at end of file
@@ -0,0 +1,292 @@
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "miner/protocol.h"
+
+namespace miner {
+
+namespace {
+
+///////////////////////////////////////////////////////////////////////////////
+// SERIALISATION HELPERS
+///////////////////////////////////////////////////////////////////////////////
+
+template <typename T>
+void put(std::vector<uint8_t> &out, T value) {
+    for (size_t i = 0; i < sizeof(T); ++i) {
+        out.push_back(static_cast<uint8_t>(value >> (8 * i)));
+    }
+}
+
+/// Reads little endian integers from a payload and remembers if it ran past the end.
+class Reader {
+public:
+    explicit Reader(std::span<const uint8_t> data) : mData(data) {}
+
+    template <typename T>
+    T get(void) {
+        T value = 0;
+        if (mData.size() < sizeof(T)) {
+            mOverrun = true;
+            return value;
+        }
+        for (size_t i = 0; i < sizeof(T); ++i) {
+            value |= static_cast<T>(mData[i]) << (8 * i);
+        }
+        mData = mData.subspan(sizeof(T));
+        return value;
+    }
+
+    /// True if every byte was consumed and nothing was read past the end.
+    bool done(void) const {
+        return !mOverrun && mData.empty();
+    }
+
+private:
+    std::span<const uint8_t> mData;
+    bool mOverrun = false;
+};
+
+constexpr size_t sWorkItemSize = 8 + 4 * BlockHeader::sHeaderSize + 4 + 4;
+
+} // namespace
+
+///////////////////////////////////////////////////////////////////////////////
+// PROTOCOL
+///////////////////////////////////////////////////////////////////////////////
+
+/// Appends the frame for a message to out.
+void Protocol::encode(const Message &message, std::vector<uint8_t> &out) {
+    const size_t start = out.size();
+    put<uint32_t>(out, static_cast<uint32_t>(message.index() + 1));
+    put<uint32_t>(out, 0);
+
+    if (const auto *m = std::get_if<RequestWork>(&message)) {
+        put(out, m->count);
+    } else if (const auto *m = std::get_if<WorkBatch>(&message)) {
+        out.reserve(out.size() + 4 + m->items.size() * sWorkItemSize);
+        put<uint32_t>(out, static_cast<uint32_t>(m->items.size()));
+        for (const auto &item : m->items) {
+            put(out, item.unitId);
+            for (uint32_t w : item.header) {
+                put(out, w);
+            }
+            put(out, item.firstNonce);
+            put(out, item.lastNonce);
+        }
+    } else if (const auto *m = std::get_if<Share>(&message)) {
+        put(out, m->unitId);
+        put(out, m->nonce);
+    } else if (const auto *m = std::get_if<UnitDone>(&message)) {
+        put(out, m->unitId);
+        put(out, m->hashes);
+    }
+
+    const auto size = static_cast<uint32_t>(out.size() - start - sFrameHeaderSize);
+    for (size_t i = 0; i < sizeof(uint32_t); ++i) {
+        out[start + 4 + i] = static_cast<uint8_t>(size >> (8 * i));
+    }
+}
+
+/// Removes and returns the first complete frame in `in`. Returns nothing if more bytes are needed, or sets error if 
+/// the frame is malformed.
+std::optional<Protocol::Message> Protocol::decode(std::vector<uint8_t> &in, bool &error) {
+    error = false;
+    if (in.size() < sFrameHeaderSize) {
+        return std::nullopt;
+    }
+
+    Reader header{std::span(in).first(sFrameHeaderSize)};
+    const auto type = static_cast<MessageType>(header.get<uint32_t>());
+    const auto size = header.get<uint32_t>();
+    if (size > sMaxPayloadSize) {
+        error = true;
+        return std::nullopt;
+    }
+    if (in.size() < sFrameHeaderSize + size) {
+        return std::nullopt;
+    }
+
+    Reader reader{std::span(in).subspan(sFrameHeaderSize, size)};
+    std::optional<Message> message;
+    switch (type) {
+    case MessageType::RequestWork:
+        message = RequestWork{reader.get<uint32_t>()};
+        break;
+    case MessageType::WorkBatch: {
+        WorkBatch batch;
+        const auto count = reader.get<uint32_t>();
+        if (count > size / sWorkItemSize) {
+            break;
+        }
+        batch.items.resize(count);
+        for (auto &item : batch.items) {
+            item.unitId = reader.get<uint64_t>();
+            for (auto &w : item.header) {
+                w = reader.get<uint32_t>();
+            }
+            item.firstNonce = reader.get<uint32_t>();
+            item.lastNonce = reader.get<uint32_t>();
+        }
+        message = std::move(batch);
+        break;
+    }
+    case MessageType::Share: {
+        Share share;
+        share.unitId = reader.get<uint64_t>();
+        share.nonce = reader.get<uint32_t>();
+        message = share;
+        break;
+    }
+    case MessageType::UnitDone: {
+        UnitDone done;
+        done.unitId = reader.get<uint64_t>();
+        done.hashes = reader.get<uint64_t>();
+        message = done;
+        break;
+    }
+    case MessageType::Stop:
+        message = Stop{};
+        break;
+    }
+
+    if (!message.has_value() || !reader.done()) {
+        error = true;
+        return std::nullopt;
+    }
+    in.erase(in.begin(), in.begin() + static_cast<ptrdiff_t>(sFrameHeaderSize + size));
+    return message;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// CONNECTION
+///////////////////////////////////////////////////////////////////////////////
+
+/// Takes ownership of a connected socket and makes it non-blocking. Nagle's algorithm is turned off because frames
+/// are already batched.
+Connection::Connection(int fd) : mFd(fd) {
+    if (mFd >= 0) {
+        ::fcntl(mFd, F_SETFL, ::fcntl(mFd, F_GETFL) | O_NONBLOCK);
+        int one = 1;
+        ::setsockopt(mFd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    }
+}
+
+Connection::Connection(Connection &&other) noexcept 
+    : mFd(std::exchange(other.mFd, -1)), mInbox(std::move(other.mInbox)), mOutbox(std::move(other.mOutbox)) {}
+
+Connection &Connection::operator=(Connection &&other) noexcept {
+    if (this != &other) {
+        close();
+        mFd = std::exchange(other.mFd, -1);
+        mInbox = std::move(other.mInbox);
+        mOutbox = std::move(other.mOutbox);
+    }
+    return *this;
+}
+
+Connection::~Connection() {
+    close();
+}
+
+/// Opens a blocking connect to host:port and then switches to non-blocking. Throws std::runtime_error if the host 
+/// can't be resolved or reached.
+Connection Connection::connect(const std::string &host, uint16_t port) {
+    struct addrinfo hints{};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+
+    struct addrinfo *info = nullptr;
+    if (::getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &info) != 0) {
+        throw std::runtime_error("Failed to resolve " + host);
+    }
+
+    int fd = -1;
+    for (auto *p = info; p != nullptr; p = p->ai_next) {
+        fd = ::socket(p->ai_family, p->ai_socktype, p->ai_protocol);
+        if (fd < 0) {
+            continue;
+        }
+        if (::connect(fd, p->ai_addr, p->ai_addrlen) == 0) {
+            break;
+        }
+        ::close(fd);
+        fd = -1;
+    }
+    ::freeaddrinfo(info);
+
+    if (fd < 0) {
+        throw std::runtime_error("Failed to connect to " + host + ":" + std::to_string(port));
+    }
+    return Connection(fd);
+}
+
+/// Queues a message. Nothing is written until flush.
+void Connection::send(const Protocol::Message &message) {
+    Protocol::encode(message, mOutbox);
+}
+
+/// Writes as much of the queued data as the socket takes. Returns false if the connection has failed.
+bool Connection::flush(void) {
+    while (open() && !mOutbox.empty()) {
+        const ssize_t n = ::send(mFd, mOutbox.data(), mOutbox.size(), MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
+                return true;
+            }
+            close();
+            return false;
+        }
+        mOutbox.erase(mOutbox.begin(), mOutbox.begin() + n);
+    }
+    return open();
+}
+
+/// Reads whatever is available and appends every complete message to messages. Returns false if the peer closed
+/// the connection or sent a malformed frame. Messages decoded before that are still returned.
+bool Connection::receive(std::vector<Protocol::Message> &messages) {
+    std::array<uint8_t, 64 * 1024> buffer;
+    bool ok = open();
+    while (ok) {
+        const ssize_t n = ::recv(mFd, buffer.data(), buffer.size(), 0);
+        if (n > 0) {
+            mInbox.insert(mInbox.end(), buffer.begin(), buffer.begin() + n);
+            continue;
+        }
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            break;
+        }
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        ok = false;
+    }
+
+    bool error = false;
+    while (auto message = Protocol::decode(mInbox, error)) {
+        messages.push_back(std::move(*message));
+    }
+    if (!ok || error) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void Connection::close(void) {
+    if (mFd >= 0) {
+        ::close(mFd);
+        mFd = -1;
+    }
+}
+
+} // namespace miner
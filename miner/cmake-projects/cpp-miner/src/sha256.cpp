@@ -5,7 +5,13 @@
 
 namespace miner {
 
+/// Compresses one block with the fastest implementation the CPU supports. The choice is made on the first call.
 Sha256::HashValue Sha256::hashBlock(const HashValue &lastHash, const Block &block) {
+    static const auto sImpl = shaNiSupported() ? &hashBlockShaNi : &hashBlockScalar;
+    return sImpl(lastHash, block);
+}
+
+Sha256::HashValue Sha256::hashBlockScalar(const HashValue &lastHash, const Block &block) {
 
     uint32_t a = lastHash[0];
     uint32_t b = lastHash[1];
@@ -97,6 +103,109 @@ Sha256::HashValue Sha256::hash(std::span<const uint32_t> dataSpan) {
     return hash;
 }
 
+/// Compresses the first block of an 80-byte block header. The first block holds the version, prevhash and most of
+/// the merkle root, none of which change while mining, so it only needs to be compressed once per header.
+Sha256::HashValue Sha256::midstate(std::span<const uint32_t> header) {
+    Block block;
+    std::copy_n(header.begin(), sBlockSize, block.begin());
+    return hashBlock(sInitialHash, block);
+}
+
+/// Builds the padded second block of an 80-byte block header. The nonce is word 3 of this block and can be 
+/// overwritten in place to try the next nonce.
+Sha256::Block Sha256::tailBlock(std::span<const uint32_t> header) {
+    Block block;
+    std::copy_n(header.begin() + sBlockSize, sHeaderSize - sBlockSize, block.begin());
+    std::fill(block.begin() + (sHeaderSize - sBlockSize), block.end(), uint32_t(0));
+    block[sHeaderSize - sBlockSize] = tobe(sFirstPadWord);
+    std::tie(block[14], block[15]) = length2Words(32 * sHeaderSize);
+    return block;
+}
+
+/// Finishes the hash of an 80-byte block header from its midstate and tail block. The result is identical to 
+/// calling hash() on the whole header.
+Sha256::HashValue Sha256::hashTail(const HashValue &midstate, const Block &tail) {
+    HashValue hash = hashBlock(midstate, tail);
+    if constexpr (std::endian::native == std::endian::little) {
+        std::ranges::transform(hash, hash.begin(), [](uint32_t w){ return tobe(w); });
+    }
+    return hash;
+}
+
+/// The double hash of an 80-byte header given by its midstate and tail block, the same as hash(hash(header)). The 
+/// second pass uses the constant padding in sDigestPad. If the most significant word of the result exceeds 
+/// maxTopWord the hash can't be valid and false is returned. Uses the fastest implementation the CPU supports. The
+/// choice is made on the first call.
+bool Sha256::doubleHashHeader(const HashValue &midstate, const Block &tail, uint32_t maxTopWord, HashValue &out) {
+    static const auto sImpl = shaNiSupported() ? &doubleHashHeaderShaNi : &doubleHashHeaderScalar;
+    return sImpl(midstate, tail, maxTopWord, out);
+}
+
+/// doubleHashHeader with the SHA extensions. The whole hash is always written.
+bool Sha256::doubleHashHeaderShaNi(const HashValue &midstate, const Block &tail, uint32_t maxTopWord, 
+    HashValue &out) {
+
+    const HashValue digest = hashBlockShaNi(midstate, tail);
+
+    Block block;
+    std::ranges::transform(digest, block.begin(), [](uint32_t w){ return tobe(w); });
+    std::transform(sDigestPad.begin() + sHashSize, sDigestPad.end(), block.begin() + sHashSize, 
+        [](uint32_t w){ return tobe(w); });
+    out = hashBlockShaNi(sInitialHash, block);
+    std::ranges::transform(out, out.begin(), [](uint32_t w){ return tobe(w); });
+    return out[7] <= maxTopWord;
+}
+
+/// doubleHashHeader without the SHA extensions. When the top word exceeds maxTopWord, only out[7] is written and
+/// the last three rounds of the second pass are skipped.
+bool Sha256::doubleHashHeaderScalar(const HashValue &midstate, const Block &tail, uint32_t maxTopWord, 
+    HashValue &out) {
+
+    const HashValue digest = hashBlockScalar(midstate, tail);
+
+    BigBlock w;
+    std::ranges::copy(digest, w.begin());
+    std::copy(sDigestPad.begin() + sHashSize, sDigestPad.end(), w.begin() + sHashSize);
+
+    HashValue v = sInitialHash;
+    auto rounds = [&v, &w](uint32_t begin, uint32_t end) {
+        auto &[a, b, c, d, e, f, g, h] = v;
+        for (uint32_t j = begin; j < end; ++j) {
+            if (j >= sBlockSize) {
+                w[j] = smallSig1(w[j-2]) + w[j-7] + smallSig0(w[j-15]) + w[j-16];
+            }
+            uint32_t T1 = calcT1(e, f, g, h, sK[j], w[j]);
+            uint32_t T2 = bigSig0(a) + maj(a, b, c);
+            h = g;
+            g = f;
+            f = e;
+            e = d + T1;
+            d = c;
+            c = b;
+            b = a;
+            a = T1 + T2;
+        }
+    };
+
+    rounds(0, sTopWordRound);
+    out[7] = tobe(v[4] + sInitialHash[7]);
+    if (out[7] > maxTopWord) {
+        return false;
+    }
+
+    rounds(sTopWordRound, 64);
+    for (uint32_t i = 0; i < sHashSize; ++i) {
+        out[i] = tobe(v[i] + sInitialHash[i]);
+    }
+    return true;
+}
+
+Sha256::HashValue Sha256::doubleHashHeader(std::span<const uint32_t> header) {
+    HashValue out;
+    doubleHashHeader(midstate(header), tailBlock(header), std::numeric_limits<uint32_t>::max(), out);
+    return out;
+}
+
 void Sha256::printHash(const HashValue &hash) {
     std::cout << "Hash Value:";
     std::cout << std::hex;
@@ -106,4 +215,22 @@ void Sha256::printHash(const HashValue &hash) {
     std::cout << std::endl;
 }
 
+/// The hash as a hex string of its bytes in memory order, which is how sha256sum prints digests.
+std::string Sha256::toHex(const HashValue &hash) {
+    static constexpr char sDigits[] = "0123456789abcdef";
+    std::string hex;
+    hex.reserve(2 * sizeof(HashValue));
+    for (uint32_t w : hash) {
+        for (size_t i = 0; i < sizeof(uint32_t); ++i) {
+            // The i-th byte in memory is the i-th least significant on a little endian host and the i-th most 
+            // significant on a big endian one.
+            const size_t shift = std::endian::native == std::endian::little ? 8 * i : 8 * (sizeof(uint32_t) - 1 - i);
+            const uint32_t byte = (w >> shift) & 0xFF;
+            hex.push_back(sDigits[byte >> 4]);
+            hex.push_back(sDigits[byte & 0xF]);
+        }
+    }
+    return hex;
+}
+
 } // namespace miner
\ No newline at end of file
@@ -0,0 +1,135 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "miner/sha256.h"
+
+namespace miner {
+
+namespace {
+
+/// The size of the chunks read when a file can't be memory mapped.
+constexpr size_t sReadChunkSize = 1 << 20;
+
+/// Closes a file descriptor when it goes out of scope.
+class FileDescriptor {
+public:
+    explicit FileDescriptor(int fd) : mFd(fd) {}
+    FileDescriptor(const FileDescriptor &) = delete;
+    FileDescriptor &operator=(const FileDescriptor &) = delete;
+    ~FileDescriptor() {
+        if (mFd >= 0) {
+            ::close(mFd);
+        }
+    }
+    int get(void) const {
+        return mFd;
+    }
+private:
+    int mFd;
+};
+
+} // namespace
+
+void Sha256::Context::compress(const uint8_t *bytes) {
+    Block block;
+    std::memcpy(block.data(), bytes, sBlockBytes);
+    mState = hashBlock(mState, block);
+}
+
+/// Hashes every whole block straight out of data and keeps the remainder for the next call.
+void Sha256::Context::update(std::span<const uint8_t> data) {
+    mLength += data.size();
+
+    if (mBuffered > 0) {
+        const size_t n = std::min(sBlockBytes - mBuffered, data.size());
+        std::copy_n(data.begin(), n, mBuffer.begin() + mBuffered);
+        mBuffered += n;
+        data = data.subspan(n);
+        if (mBuffered < sBlockBytes) {
+            return;
+        }
+        compress(mBuffer.data());
+        mBuffered = 0;
+    }
+
+    while (data.size() >= sBlockBytes) {
+        compress(data.data());
+        data = data.subspan(sBlockBytes);
+    }
+
+    std::ranges::copy(data, mBuffer.begin());
+    mBuffered = data.size();
+}
+
+/// Pads the message and returns the hash. The context must not be updated afterwards.
+Sha256::HashValue Sha256::Context::finalize(void) {
+    static constexpr size_t sLengthBytes = 8;
+
+    const uint64_t bitLength = 8 * mLength;
+
+    mBuffer[mBuffered++] = 0x80;
+    if (mBuffered > sBlockBytes - sLengthBytes) {
+        std::fill(mBuffer.begin() + mBuffered, mBuffer.end(), uint8_t(0));
+        compress(mBuffer.data());
+        mBuffered = 0;
+    }
+    std::fill(mBuffer.begin() + mBuffered, mBuffer.end() - sLengthBytes, uint8_t(0));
+    for (size_t i = 0; i < sLengthBytes; ++i) {
+        mBuffer[sBlockBytes - 1 - i] = static_cast<uint8_t>(bitLength >> (8 * i));
+    }
+    compress(mBuffer.data());
+
+    HashValue hash = mState;
+    std::ranges::transform(hash, hash.begin(), [](uint32_t w){ return tobe(w); });
+    return hash;
+}
+
+/// Hashes the contents of a file. Regular files are memory mapped so the data goes straight from the page cache to 
+/// the compression function. Anything that can't be mapped, such as a pipe, is read in large chunks instead. 
+/// Returns nothing if the file can't be opened or read.
+std::optional<Sha256::HashValue> Sha256::hashFile(const std::string &path) {
+
+    FileDescriptor fd(::open(path.c_str(), O_RDONLY));
+    if (fd.get() < 0) {
+        return std::nullopt;
+    }
+
+    Context context;
+
+    struct stat st{};
+    if (::fstat(fd.get(), &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+        const auto size = static_cast<size_t>(st.st_size);
+        void *addr = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd.get(), 0);
+        if (addr != MAP_FAILED) {
+            ::madvise(addr, size, MADV_SEQUENTIAL);
+            context.update(std::span<const uint8_t>(static_cast<const uint8_t *>(addr), size));
+            ::munmap(addr, size);
+            return context.finalize();
+        }
+    }
+
+    std::vector<uint8_t> chunk(sReadChunkSize);
+    while (true) {
+        const ssize_t n = ::read(fd.get(), chunk.data(), chunk.size());
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n < 0) {
+            return std::nullopt;
+        }
+        if (n == 0) {
+            break;
+        }
+        context.update(std::span<const uint8_t>(chunk.data(), static_cast<size_t>(n)));
+    }
+    return context.finalize();
+}
+
+} // namespace miner
@@ -0,0 +1,390 @@
+#include <algorithm>
+#include <array>
+
+#include "miner/sha256_lanes.h"
+
+namespace miner {
+
+namespace {
+
+///////////////////////////////////////////////////////////////////////////////
+// LANE KERNEL
+///////////////////////////////////////////////////////////////////////////////
+
+// The kernel is written once against GCC/Clang vector extensions and force-inlined into one entry point per 
+// instruction set, each compiled with its own target attribute. Arithmetic and shifts on these types operate on
+// every lane and a scalar operand is broadcast to all lanes.
+using Vec4 = uint32_t __attribute__((vector_size(16)));
+using Vec8 = uint32_t __attribute__((vector_size(32)));
+using Vec16 = uint32_t __attribute__((vector_size(64)));
+
+// The kernel functions are always inlined, so the vector calling convention they would otherwise use never matters.
+#pragma GCC diagnostic ignored "-Wpsabi"
+
+using HashValue = Sha256::HashValue;
+using Block = Sha256::Block;
+
+/// The padding block of a 64-byte message, as message schedule words.
+constexpr Block sPairPad = {Sha256::sFirstPadWord, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 512};
+
+template <typename V>
+[[gnu::always_inline]] inline V rotr(const V &x, int n) {
+    return (x >> n) | (x << (32 - n));
+}
+
+/// The eight working variables a..h of the compression function.
+template <typename V>
+struct Working {
+    V a, b, c, d, e, f, g, h;
+};
+
+/// Runs rounds [begin, end) of the compression function. The message schedule is kept in a 16 word ring rather 
+/// than the full 64 words.
+template <typename V>
+[[gnu::always_inline]] inline void rounds(Working<V> &s, V (&w)[Sha256::sBlockSize], uint32_t begin, uint32_t end) {
+    for (uint32_t j = begin; j < end; ++j) {
+        if (j >= Sha256::sBlockSize) {
+            const V &w2 = w[(j - 2) & 15];
+            const V &w15 = w[(j - 15) & 15];
+            V s1 = rotr(w2, 17) ^ rotr(w2, 19) ^ (w2 >> 10);
+            V s0 = rotr(w15, 7) ^ rotr(w15, 18) ^ (w15 >> 3);
+            w[j & 15] += s1 + w[(j - 7) & 15] + s0;
+        }
+
+        V T1 = s.h + (rotr(s.e, 6) ^ rotr(s.e, 11) ^ rotr(s.e, 25)) + ((s.e & s.f) ^ (~s.e & s.g)) + Sha256::sK[j] 
+            + w[j & 15];
+        V T2 = (rotr(s.a, 2) ^ rotr(s.a, 13) ^ rotr(s.a, 22)) + ((s.a & s.b) ^ (s.a & s.c) ^ (s.b & s.c));
+        s.h = s.g;
+        s.g = s.f;
+        s.f = s.e;
+        s.e = s.d + T1;
+        s.d = s.c;
+        s.c = s.b;
+        s.b = s.a;
+        s.a = T1 + T2;
+    }
+}
+
+template <typename V>
+[[gnu::always_inline]] inline void addWorking(V (&state)[Sha256::sHashSize], const Working<V> &s) {
+    state[0] += s.a;
+    state[1] += s.b;
+    state[2] += s.c;
+    state[3] += s.d;
+    state[4] += s.e;
+    state[5] += s.f;
+    state[6] += s.g;
+    state[7] += s.h;
+}
+
+template <typename V>
+[[gnu::always_inline]] inline void compress(V (&state)[Sha256::sHashSize], V (&w)[Sha256::sBlockSize]) {
+    Working<V> s{state[0], state[1], state[2], state[3], state[4], state[5], state[6], state[7]};
+    rounds(s, w, 0, 64);
+    addWorking(state, s);
+}
+
+/// Runs the second pass of a double hash on the first-pass hash held in state and writes the result for each lane.
+/// The words of the first hash are already in the order the second pass consumes them, so they are fed straight
+/// back in. 
+///
+/// The top word of the final hash is the value of e after round 60. If it exceeds maxTopWord in every lane, the 
+/// last three rounds are skipped and only the top word of each output is written.
+template <typename V, uint32_t N>
+[[gnu::always_inline]] inline void finishDoubleHash(V (&state)[Sha256::sHashSize], uint32_t maxTopWord, 
+    HashValue *out) {
+
+    V w[Sha256::sBlockSize];
+    for (uint32_t i = 0; i < Sha256::sHashSize; ++i) {
+        w[i] = state[i];
+        state[i] = V{} + Sha256::sInitialHash[i];
+    }
+    for (uint32_t j = Sha256::sHashSize; j < Sha256::sBlockSize; ++j) {
+        w[j] = V{} + Sha256::sDigestPad[j];
+    }
+    Working<V> s{state[0], state[1], state[2], state[3], state[4], state[5], state[6], state[7]};
+    rounds(s, w, 0, Sha256::sTopWordRound);
+
+    const V top = s.e + Sha256::sInitialHash[7];
+    bool candidate = false;
+    for (uint32_t lane = 0; lane < N; ++lane) {
+        out[lane][7] = Sha256::tobe(top[lane]);
+        candidate = candidate || out[lane][7] <= maxTopWord;
+    }
+    if (!candidate) {
+        return;
+    }
+
+    rounds(s, w, Sha256::sTopWordRound, 64);
+    addWorking(state, s);
+
+    for (uint32_t lane = 0; lane < N; ++lane) {
+        for (uint32_t i = 0; i < Sha256::sHashSize; ++i) {
+            out[lane][i] = Sha256::tobe(state[i][lane]);
+        }
+    }
+}
+
+/// Double hashes N consecutive nonces, one per lane. The first pass starts from the header midstate.
+template <typename V, uint32_t N>
+[[gnu::always_inline]] inline void hashBatch(const HashValue &midstate, const Block &tail, uint32_t firstNonce, 
+    uint32_t maxTopWord, HashValue *out) {
+
+    V state[Sha256::sHashSize];
+    V w[Sha256::sBlockSize];
+
+    for (uint32_t i = 0; i < Sha256::sHashSize; ++i) {
+        state[i] = V{} + midstate[i];
+    }
+    for (uint32_t j = 0; j < Sha256::sBlockSize; ++j) {
+        w[j] = V{} + Sha256::tobe(tail[j]);
+    }
+    for (uint32_t lane = 0; lane < N; ++lane) {
+        w[3][lane] = Sha256::tobe(firstNonce + lane);
+    }
+    compress(state, w);
+    finishDoubleHash<V, N>(state, maxTopWord, out);
+}
+
+template <typename V, uint32_t N>
+[[gnu::always_inline]] inline void hashNoncesLanes(const HashValue &midstate, const Block &tail, uint32_t firstNonce, 
+    uint32_t maxTopWord, std::span<HashValue> out) {
+
+    size_t i = 0;
+    for (; i + N <= out.size(); i += N) {
+        hashBatch<V, N>(midstate, tail, firstNonce + i, maxTopWord, out.data() + i);
+    }
+    if (i < out.size()) {
+        std::array<HashValue, N> rest;
+        hashBatch<V, N>(midstate, tail, firstNonce + i, maxTopWord, rest.data());
+        std::copy_n(rest.begin(), out.size() - i, out.begin() + i);
+    }
+}
+
+/// Double hashes N 64-byte messages, one per lane. Message i is the concatenation of in[2i] and in[2i+1]. The 
+/// message fills a whole block, so the first pass needs a second block holding only the padding.
+template <typename V, uint32_t N>
+[[gnu::always_inline]] inline void hashPairsBatch(const HashValue *in, HashValue *out) {
+
+    V state[Sha256::sHashSize];
+    V w[Sha256::sBlockSize];
+
+    for (uint32_t i = 0; i < Sha256::sHashSize; ++i) {
+        state[i] = V{} + Sha256::sInitialHash[i];
+    }
+    for (uint32_t lane = 0; lane < N; ++lane) {
+        for (uint32_t j = 0; j < Sha256::sBlockSize; ++j) {
+            w[j][lane] = Sha256::tobe(in[2*lane + j / Sha256::sHashSize][j % Sha256::sHashSize]);
+        }
+    }
+    compress(state, w);
+
+    for (uint32_t j = 0; j < Sha256::sBlockSize; ++j) {
+        w[j] = V{} + sPairPad[j];
+    }
+    compress(state, w);
+
+    finishDoubleHash<V, N>(state, std::numeric_limits<uint32_t>::max(), out);
+}
+
+template <typename V, uint32_t N>
+[[gnu::always_inline]] inline void hashPairsLanes(std::span<const HashValue> in, std::span<HashValue> out) {
+
+    size_t i = 0;
+    for (; i + N <= out.size(); i += N) {
+        hashPairsBatch<V, N>(in.data() + 2*i, out.data() + i);
+    }
+    if (i < out.size()) {
+        std::array<HashValue, 2*N> restIn{};
+        std::array<HashValue, N> restOut;
+        std::copy(in.begin() + 2*i, in.end(), restIn.begin());
+        hashPairsBatch<V, N>(restIn.data(), restOut.data());
+        std::copy_n(restOut.begin(), out.size() - i, out.begin() + i);
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// INSTRUCTION SET ENTRY POINTS
+///////////////////////////////////////////////////////////////////////////////
+
+void hashNoncesScalar(const HashValue &midstate, const Block &tail, uint32_t firstNonce, uint32_t maxTopWord,
+    std::span<HashValue> out) {
+    Block block = tail;
+    for (size_t i = 0; i < out.size(); ++i) {
+        block[3] = firstNonce + i;
+        Sha256::doubleHashHeader(midstate, block, maxTopWord, out[i]);
+    }
+}
+
+void hashPairsScalar(std::span<const HashValue> in, std::span<HashValue> out) {
+    Block block;
+    for (size_t i = 0; i < out.size(); ++i) {
+        std::ranges::copy(in[2*i], block.begin());
+        std::ranges::copy(in[2*i + 1], block.begin() + Sha256::sHashSize);
+        out[i] = Sha256::hash(Sha256::hash(block));
+    }
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+
+[[gnu::target("sse2")]]
+void hashNoncesSse2(const HashValue &midstate, const Block &tail, uint32_t firstNonce, uint32_t maxTopWord,
+    std::span<HashValue> out) {
+    hashNoncesLanes<Vec4, 4>(midstate, tail, firstNonce, maxTopWord, out);
+}
+
+[[gnu::target("avx2")]]
+void hashNoncesAvx2(const HashValue &midstate, const Block &tail, uint32_t firstNonce, uint32_t maxTopWord,
+    std::span<HashValue> out) {
+    hashNoncesLanes<Vec8, 8>(midstate, tail, firstNonce, maxTopWord, out);
+}
+
+[[gnu::target("avx512f")]]
+void hashNoncesAvx512(const HashValue &midstate, const Block &tail, uint32_t firstNonce, uint32_t maxTopWord,
+    std::span<HashValue> out) {
+    hashNoncesLanes<Vec16, 16>(midstate, tail, firstNonce, maxTopWord, out);
+}
+
+[[gnu::target("sse2")]]
+void hashPairsSse2(std::span<const HashValue> in, std::span<HashValue> out) {
+    hashPairsLanes<Vec4, 4>(in, out);
+}
+
+[[gnu::target("avx2")]]
+void hashPairsAvx2(std::span<const HashValue> in, std::span<HashValue> out) {
+    hashPairsLanes<Vec8, 8>(in, out);
+}
+
+[[gnu::target("avx512f")]]
+void hashPairsAvx512(std::span<const HashValue> in, std::span<HashValue> out) {
+    hashPairsLanes<Vec16, 16>(in, out);
+}
+
+#endif
+
+} // namespace
+
+///////////////////////////////////////////////////////////////////////////////
+// PUBLIC FUNCTIONS
+///////////////////////////////////////////////////////////////////////////////
+
+bool Sha256Lanes::supported(Isa isa) {
+#if defined(__x86_64__) || defined(__i386__)
+    switch (isa) {
+    case Isa::Sse2:
+        return __builtin_cpu_supports("sse2");
+    case Isa::Avx2:
+        return __builtin_cpu_supports("avx2");
+    case Isa::Avx512:
+        return __builtin_cpu_supports("avx512f");
+    default:
+        return true;
+    }
+#else
+    return isa == Isa::Scalar;
+#endif
+}
+
+/// The widest supported instruction set. This is detected once and cached. A single stream through the SHA 
+/// extensions outruns four SSE2 lanes, so the scalar path is preferred over SSE2 when they are available.
+Sha256Lanes::Isa Sha256Lanes::best(void) {
+    static const Isa sBest = []() {
+        for (auto isa : {Isa::Avx512, Isa::Avx2}) {
+            if (supported(isa)) {
+                return isa;
+            }
+        }
+        if (!Sha256::shaNiSupported() && supported(Isa::Sse2)) {
+            return Isa::Sse2;
+        }
+        return Isa::Scalar;
+    }();
+    return sBest;
+}
+
+uint32_t Sha256Lanes::laneCount(Isa isa) {
+    switch (isa) {
+    case Isa::Sse2:
+        return 4;
+    case Isa::Avx2:
+        return 8;
+    case Isa::Avx512:
+        return 16;
+    default:
+        return 1;
+    }
+}
+
+const char *Sha256Lanes::name(Isa isa) {
+    switch (isa) {
+    case Isa::Sse2:
+        return "SSE2";
+    case Isa::Avx2:
+        return "AVX2";
+    case Isa::Avx512:
+        return "AVX-512";
+    default:
+        return "Scalar";
+    }
+}
+
+/// Computes the double SHA-256 hash of an 80-byte header for the nonces firstNonce, firstNonce + 1, ... and writes
+/// one hash per element of out. The header is given by its midstate and tail block, see Sha256::midstate. The 
+/// nonce word of the tail block is ignored. The hashes match Sha256::hash(Sha256::hash(header.data())).
+///
+/// Word 7 of every output, the most significant word of the hash, is always written. The other words are only
+/// guaranteed to be written when word 7 is no greater than maxTopWord, which lets hashes that can't meet the target
+/// skip the last rounds.
+void Sha256Lanes::hashNonces(const Sha256::HashValue &midstate, const Sha256::Block &tail, uint32_t firstNonce, 
+    std::span<Sha256::HashValue> out, uint32_t maxTopWord) {
+    hashNonces(best(), midstate, tail, firstNonce, out, maxTopWord);
+}
+
+/// As above but with an explicit instruction set. The caller must check the instruction set is supported.
+void Sha256Lanes::hashNonces(Isa isa, const Sha256::HashValue &midstate, const Sha256::Block &tail, 
+    uint32_t firstNonce, std::span<Sha256::HashValue> out, uint32_t maxTopWord) {
+#if defined(__x86_64__) || defined(__i386__)
+    switch (isa) {
+    case Isa::Sse2:
+        hashNoncesSse2(midstate, tail, firstNonce, maxTopWord, out);
+        return;
+    case Isa::Avx2:
+        hashNoncesAvx2(midstate, tail, firstNonce, maxTopWord, out);
+        return;
+    case Isa::Avx512:
+        hashNoncesAvx512(midstate, tail, firstNonce, maxTopWord, out);
+        return;
+    default:
+        break;
+    }
+#endif
+    hashNoncesScalar(midstate, tail, firstNonce, maxTopWord, out);
+}
+
+/// Double hashes pairs of hashes: out[i] is the double SHA-256 of in[2i] followed by in[2i+1], which is how bitcoin
+/// combines two nodes of a merkle tree. in must hold exactly twice as many hashes as out.
+void Sha256Lanes::hashPairs(std::span<const Sha256::HashValue> in, std::span<Sha256::HashValue> out) {
+    hashPairs(best(), in, out);
+}
+
+/// As above but with an explicit instruction set. The caller must check the instruction set is supported.
+void Sha256Lanes::hashPairs(Isa isa, std::span<const Sha256::HashValue> in, std::span<Sha256::HashValue> out) {
+#if defined(__x86_64__) || defined(__i386__)
+    switch (isa) {
+    case Isa::Sse2:
+        hashPairsSse2(in, out);
+        return;
+    case Isa::Avx2:
+        hashPairsAvx2(in, out);
+        return;
+    case Isa::Avx512:
+        hashPairsAvx512(in, out);
+        return;
+    default:
+        break;
+    }
+#endif
+    hashPairsScalar(in, out);
+}
+
+} // namespace miner
@@ -0,0 +1,97 @@
+#include "miner/sha256.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#include <immintrin.h>
+#endif
+
+namespace miner {
+
+#if defined(__x86_64__) || defined(__i386__)
+
+/// SHA-NI needs CPUID.(EAX=7,ECX=0):EBX.SHA[bit 29], and the shuffles around it need SSE4.1 
+/// (CPUID.(EAX=1):ECX.SSE4_1[bit 19]).
+bool Sha256::shaNiSupported(void) {
+    unsigned int eax = 0;
+    unsigned int ebx = 0;
+    unsigned int ecx = 0;
+    unsigned int edx = 0;
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx) || (ecx & (1U << 19)) == 0) {
+        return false;
+    }
+    if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) {
+        return false;
+    }
+    return (ebx & (1U << 29)) != 0;
+}
+
+/// The compression function using the x86 SHA extensions. sha256rnds2 does two rounds at a time on a state split
+/// into the ABEF and CDGH registers, and sha256msg1/sha256msg2 compute the message schedule four words at a time.
+/// Each group of four rounds below also advances the schedule for a later group.
+[[gnu::target("sha,sse4.1")]]
+Sha256::HashValue Sha256::hashBlockShaNi(const HashValue &lastHash, const Block &block) {
+
+    // Swaps the bytes of each word, the same as tobe.
+    const __m128i byteswap = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+
+    __m128i tmp = _mm_loadu_si128(reinterpret_cast<const __m128i *>(lastHash.data()));
+    __m128i state1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(lastHash.data() + 4));
+    tmp = _mm_shuffle_epi32(tmp, 0xB1);             // CDAB
+    state1 = _mm_shuffle_epi32(state1, 0x1B);       // EFGH
+    __m128i state0 = _mm_alignr_epi8(tmp, state1, 8);  // ABEF
+    state1 = _mm_blend_epi16(state1, tmp, 0xF0);    // CDGH
+
+    const __m128i abefSave = state0;
+    const __m128i cdghSave = state1;
+
+    __m128i msgs[4];
+    for (uint32_t i = 0; i < 4; ++i) {
+        __m128i msg = _mm_loadu_si128(reinterpret_cast<const __m128i *>(block.data() + 4*i));
+        msgs[i] = _mm_shuffle_epi8(msg, byteswap);
+    }
+
+    for (uint32_t g = 0; g < 16; ++g) {
+        __m128i &cur = msgs[g % 4];
+        __m128i &next = msgs[(g + 1) % 4];
+        __m128i &prev = msgs[(g + 3) % 4];
+
+        __m128i msg = _mm_add_epi32(cur, _mm_loadu_si128(reinterpret_cast<const __m128i *>(sK.data() + 4*g)));
+        state1 = _mm_sha256rnds2_epu32(state1, state0, msg);
+        if (g >= 3 && g <= 14) {
+            next = _mm_add_epi32(next, _mm_alignr_epi8(cur, prev, 4));
+            next = _mm_sha256msg2_epu32(next, cur);
+        }
+        msg = _mm_shuffle_epi32(msg, 0x0E);
+        state0 = _mm_sha256rnds2_epu32(state0, state1, msg);
+        if (g >= 1 && g <= 12) {
+            prev = _mm_sha256msg1_epu32(prev, cur);
+        }
+    }
+
+    state0 = _mm_add_epi32(state0, abefSave);
+    state1 = _mm_add_epi32(state1, cdghSave);
+
+    tmp = _mm_shuffle_epi32(state0, 0x1B);          // FEBA
+    state1 = _mm_shuffle_epi32(state1, 0xB1);       // DCHG
+    state0 = _mm_blend_epi16(tmp, state1, 0xF0);    // DCBA
+    state1 = _mm_alignr_epi8(state1, tmp, 8);       // ABEF
+
+    HashValue res;
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(res.data()), state0);
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(res.data() + 4), state1);
+    return res;
+}
+
+#else
+
+bool Sha256::shaNiSupported(void) {
+    return false;
+}
+
+Sha256::HashValue Sha256::hashBlockShaNi(const HashValue &lastHash, const Block &block) {
+    return hashBlockScalar(lastHash, block);
+}
+
+#endif
+
+} // namespace miner
@@ -0,0 +1,155 @@
+#include <algorithm>
+#include <bit>
+#include <iomanip>
+
+#include "miner/telemetry.h"
+
+namespace miner {
+
+Telemetry::Telemetry(unsigned nThreads) : mThreadCount(std::max(nThreads, 1U)), 
+    mCounters(std::make_unique<Counters[]>(mThreadCount)) {
+}
+
+Telemetry::~Telemetry() {
+    stop();
+}
+
+/// Starts the sampling thread. If log is set, a line with the latest snapshot is written to it every logEvery 
+/// samples. The sampling thread is the only one that writes to the log.
+void Telemetry::start(Clock::duration interval, std::ostream *log, unsigned logEvery) {
+
+    stop();
+    logEvery = std::max(logEvery, 1U);
+    mSampler = std::jthread([this, interval, log, logEvery](std::stop_token stopToken) {
+        std::mutex mutex;
+        auto next = Clock::now();
+        sample(next);
+        for (unsigned count = 1; !stopToken.stop_requested(); ++count) {
+            next += interval;
+            {
+                std::unique_lock lock(mutex);
+                mWake.wait_until(lock, stopToken, next, [] { return false; });
+            }
+            if (stopToken.stop_requested()) {
+                break;
+            }
+            sample(Clock::now());
+            if (log != nullptr && count % logEvery == 0) {
+                printSnapshot(*log, snapshot());
+            }
+        }
+    });
+}
+
+/// Stops the sampling thread and takes one last sample so the totals are up to date.
+void Telemetry::stop(void) {
+    if (mSampler.joinable()) {
+        mSampler.request_stop();
+        mSampler.join();
+        sample(Clock::now());
+    }
+}
+
+/// Sums the counters of every thread and updates the snapshot. The counters are read with relaxed loads while the
+/// mining threads keep writing, so a sample may be a batch behind, but it is never torn.
+void Telemetry::sample(Clock::time_point now) {
+
+    Snapshot next;
+    std::array<uint64_t, sLatencyBuckets> latency{};
+    for (unsigned i = 0; i < mThreadCount; ++i) {
+        const auto &counters = mCounters[i];
+        next.hashes += counters.hashes.load(std::memory_order_relaxed);
+        next.shares += counters.shares.load(std::memory_order_relaxed);
+        next.staleUnits += counters.staleUnits.load(std::memory_order_relaxed);
+        for (size_t b = 0; b < sLatencyBuckets; ++b) {
+            latency[b] += counters.latency[b].load(std::memory_order_relaxed);
+        }
+    }
+
+    std::scoped_lock lock(mMutex);
+
+    // Percentiles of the batches recorded since the last sample.
+    uint64_t batches = 0;
+    std::array<uint64_t, sLatencyBuckets> delta;
+    for (size_t b = 0; b < sLatencyBuckets; ++b) {
+        delta[b] = latency[b] - mLastLatency[b];
+        batches += delta[b];
+    }
+    mLastLatency = latency;
+    auto percentile = [&](uint64_t per100) {
+        const uint64_t rank = std::max<uint64_t>((batches * per100 + 99) / 100, 1);
+        uint64_t seen = 0;
+        for (size_t b = 0; b < sLatencyBuckets; ++b) {
+            seen += delta[b];
+            if (seen >= rank) {
+                return std::chrono::nanoseconds(bucketLowerBound(b));
+            }
+        }
+        return std::chrono::nanoseconds(0);
+    };
+    if (batches > 0) {
+        next.batchLatencyP50 = percentile(50);
+        next.batchLatencyP99 = percentile(99);
+    }
+
+    // Keep just enough samples to cover the longest window.
+    mSamples.push_back(Sample{now, next.hashes});
+    while (mSamples.size() > 2 && now - mSamples[1].time >= sRateWindows.back()) {
+        mSamples.pop_front();
+    }
+
+    // Each rate is measured from the newest sample at least a window old, or the oldest sample if none is.
+    for (size_t w = 0; w < sRateWindows.size(); ++w) {
+        const Sample *base = &mSamples.front();
+        for (const auto &s : mSamples) {
+            if (now - s.time < sRateWindows[w]) {
+                break;
+            }
+            base = &s;
+        }
+        const std::chrono::duration<double> elapsed = now - base->time;
+        if (elapsed.count() > 0) {
+            next.hashRates[w] = static_cast<double>(next.hashes - base->hashes) / elapsed.count();
+        }
+    }
+
+    mSnapshot = next;
+}
+
+Telemetry::Snapshot Telemetry::snapshot(void) const {
+    std::scoped_lock lock(mMutex);
+    return mSnapshot;
+}
+
+void Telemetry::printSnapshot(std::ostream &out, const Snapshot &snapshot) {
+    const auto flags = out.flags();
+    out << std::fixed << std::setprecision(2) << "Hash rate " << snapshot.hashRates[0] / 1e6 << " / " 
+        << snapshot.hashRates[1] / 1e6 << " / " << snapshot.hashRates[2] / 1e6 << " MH/s (1s/10s/60s), " 
+        << snapshot.hashes << " hashes, " << snapshot.shares << " shares, " << snapshot.staleUnits 
+        << " stale, batch p50 " << snapshot.batchLatencyP50.count() / 1000 << " us p99 " 
+        << snapshot.batchLatencyP99.count() / 1000 << " us\n";
+    out.flags(flags);
+}
+
+/// Values below 4 get a bucket each. Above that, the bucket is the position of the top bit followed by the next
+/// sSubBucketBits bits.
+size_t Telemetry::latencyBucket(uint64_t nanoseconds) {
+    static constexpr uint64_t sSubBuckets = 1 << sSubBucketBits;
+    if (nanoseconds < sSubBuckets) {
+        return static_cast<size_t>(nanoseconds);
+    }
+    const auto msb = static_cast<size_t>(std::bit_width(nanoseconds) - 1);
+    const auto sub = static_cast<size_t>((nanoseconds >> (msb - sSubBucketBits)) & (sSubBuckets - 1));
+    return (msb << sSubBucketBits) | sub;
+}
+
+uint64_t Telemetry::bucketLowerBound(size_t bucket) {
+    static constexpr uint64_t sSubBuckets = 1 << sSubBucketBits;
+    const size_t msb = bucket >> sSubBucketBits;
+    if (msb < sSubBucketBits) {
+        return bucket;
+    }
+    return (sSubBuckets | (bucket & (sSubBuckets - 1))) << (msb - sSubBucketBits);
+}
+
+} // namespace miner
@@ -0,0 +1,74 @@
+#include <algorithm>
+#include <limits>
+
+#include "miner/sha256.h"
+#include "miner/work.h"
+
+namespace miner {
+
+namespace {
+
+constexpr uint64_t sNonceSpace = uint64_t(std::numeric_limits<uint32_t>::max()) + 1;
+
+} // namespace
+
+/// Rolls only the time field of the header.
+WorkGenerator::WorkGenerator(const BlockHeader &header, uint64_t unitSize) 
+    : mHeader(header), mUnitSize(std::clamp<uint64_t>(unitSize, 1, sNonceSpace)), mStartTime(header.time()) {}
+
+/// Rolls the extranonce of the coinbase transaction, leaf 0 of the tree. The merkle root of the header is replaced
+/// by the root for extranonce 0.
+WorkGenerator::WorkGenerator(const BlockHeader &header, MerkleTree tree, CoinbaseFn coinbase, uint64_t unitSize) 
+    : mHeader(header), mTree(std::move(tree)), mCoinbase(std::move(coinbase)), 
+    mUnitSize(std::clamp<uint64_t>(unitSize, 1, sNonceSpace)), mStartTime(header.time()) {
+    mTree->setCoinbase(mCoinbase(mExtranonce));
+    mHeader.setMerkleRoot(mTree->root());
+}
+
+/// The next unit of work, or nothing once the time field can't be rolled any further.
+std::optional<WorkUnit> WorkGenerator::next(void) {
+    std::scoped_lock lock(mMutex);
+
+    if (mNextNonce >= sNonceSpace && !rollHeader()) {
+        return std::nullopt;
+    }
+
+    const uint64_t first = mNextNonce;
+    const uint64_t last = std::min(first + mUnitSize, sNonceSpace) - 1;
+    mNextNonce = last + 1;
+    return WorkUnit{mHeader, static_cast<uint32_t>(first), static_cast<uint32_t>(last), mExtranonce};
+}
+
+/// Makes a fresh header once the nonce space of the current one is used up.
+bool WorkGenerator::rollHeader(void) {
+    if (mTree.has_value()) {
+        ++mExtranonce;
+        mTree->setCoinbase(mCoinbase(mExtranonce));
+        mHeader.setMerkleRoot(mTree->root());
+    } else {
+        if (mHeader.time() - mStartTime >= sMaxTimeRoll) {
+            return false;
+        }
+        mHeader.setTime(mHeader.time() + 1);
+    }
+    mNextNonce = 0;
+    return true;
+}
+
+/// The txid of a coinbase transaction serialised as prefix, the extranonce as 8 little endian bytes, then suffix.
+MerkleTree::Hash WorkGenerator::coinbaseHash(std::span<const uint8_t> prefix, uint64_t extranonce, 
+    std::span<const uint8_t> suffix) {
+
+    std::array<uint8_t, sizeof(uint64_t)> extranonceBytes;
+    for (size_t i = 0; i < extranonceBytes.size(); ++i) {
+        extranonceBytes[i] = static_cast<uint8_t>(extranonce >> (8 * i));
+    }
+
+    Sha256::Context context;
+    context.update(prefix);
+    context.update(extranonceBytes);
+    context.update(suffix);
+    return Sha256::hash(context.finalize());
+}
+
+} // namespace miner
@@ -0,0 +1,141 @@
+#include <algorithm>
+#include <cerrno>
+#include <stdexcept>
+#include <thread>
+
+#include <poll.h>
+
+#include "miner/miner.h"
+#include "miner/work_client.h"
+
+namespace miner {
+
+WorkClient::WorkClient(const std::string &host, uint16_t port, unsigned nThreads, uint32_t batchSize) : 
+    mConnection(Connection::connect(host, port)), mThreadCount(std::max(nThreads, 1U)), 
+    mBatchSize(std::max(batchSize, 1U)), mWorkerStop(mThreadCount) {
+}
+
+/// Mines until the server sends Stop, the connection closes or stop() is called.
+void WorkClient::run(void) {
+
+    std::vector<std::jthread> threads;
+    threads.reserve(mThreadCount);
+    for (unsigned i = 0; i < mThreadCount; ++i) {
+        threads.emplace_back([this, i] { mineUnits(i); });
+    }
+
+    std::vector<Protocol::Message> messages;
+    while (!mStop.load()) {
+
+        // Ask for more work once the local queue is half empty, so the next batch arrives before it runs out.
+        {
+            std::scoped_lock lock(mQueueMutex);
+            if (!mRequestPending && mQueue.size() <= mBatchSize / 2) {
+                mConnection.send(Protocol::RequestWork{mBatchSize - static_cast<uint32_t>(mQueue.size())});
+                mRequestPending = true;
+            }
+        }
+        {
+            std::scoped_lock lock(mOutboxMutex);
+            for (const auto &message : mOutbox) {
+                mConnection.send(message);
+            }
+            mOutbox.clear();
+        }
+
+        struct pollfd pollFd{mConnection.fd(), 
+            static_cast<short>(POLLIN | (mConnection.wantsWrite() ? POLLOUT : 0)), 0};
+        if (::poll(&pollFd, 1, sPollTimeoutMs) < 0 && errno != EINTR) {
+            break;
+        }
+
+        messages.clear();
+        bool ok = true;
+        if (pollFd.revents & (POLLIN | POLLHUP | POLLERR)) {
+            ok = mConnection.receive(messages);
+        }
+        ok = mConnection.flush() && ok;
+
+        for (const auto &message : messages) {
+            if (const auto *batch = std::get_if<Protocol::WorkBatch>(&message)) {
+                // The server answers every request with one batch. When it is out of work it holds the request, and
+                // sends Stop once all the work is done.
+                std::scoped_lock lock(mQueueMutex);
+                mQueue.insert(mQueue.end(), batch->items.begin(), batch->items.end());
+                mRequestPending = false;
+                mQueueReady.notify_all();
+            } else if (std::holds_alternative<Protocol::Stop>(message)) {
+                ok = false;
+            }
+        }
+        if (!ok) {
+            break;
+        }
+    }
+
+    stop();
+    threads.clear();
+    mConnection.close();
+}
+
+void WorkClient::stop(void) {
+    mStop.store(true);
+    for (auto &flag : mWorkerStop) {
+        flag.store(true);
+    }
+    std::scoped_lock lock(mQueueMutex);
+    mQueueReady.notify_all();
+}
+
+void WorkClient::mineUnits(unsigned worker) {
+
+    auto &stop = mWorkerStop[worker];
+    while (true) {
+        Protocol::WorkItem item;
+        {
+            std::unique_lock lock(mQueueMutex);
+            mQueueReady.wait(lock, [this] { return mStop.load() || !mQueue.empty(); });
+            if (mStop.load()) {
+                return;
+            }
+            item = mQueue.front();
+            mQueue.pop_front();
+        }
+
+        BlockHeader header(item.header);
+        uint64_t hashes = 0;
+        uint64_t first = item.firstNonce;
+        while (first <= item.lastNonce) {
+            // stop() raises mStop before the worker flags, so checking mStop after the reset can't miss a stop.
+            stop.store(false);
+            if (mStop.load()) {
+                return;
+            }
+
+            uint64_t rangeHashes = 0;
+            auto nonce = Miner::mineRange(header, static_cast<uint32_t>(first), item.lastNonce, stop, rangeHashes);
+            hashes += rangeHashes;
+            mHashes.fetch_add(rangeHashes, std::memory_order_relaxed);
+
+            if (!nonce.has_value()) {
+                if (mStop.load()) {
+                    return;
+                }
+                break;
+            }
+            mShares.fetch_add(1, std::memory_order_relaxed);
+            post(Protocol::Share{item.unitId, *nonce});
+            first = uint64_t(*nonce) + 1;
+        }
+
+        mUnitsDone.fetch_add(1, std::memory_order_relaxed);
+        post(Protocol::UnitDone{item.unitId, hashes});
+    }
+}
+
+void WorkClient::post(const Protocol::Message &message) {
+    std::scoped_lock lock(mOutboxMutex);
+    mOutbox.push_back(message);
+}
+
+} // namespace miner
@@ -0,0 +1,228 @@
+#include <algorithm>
+#include <cerrno>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "miner/miner.h"
+#include "miner/work_server.h"
+
+namespace miner {
+
+/// Listens on every interface. Port 0 picks a free port, see port(). Throws std::runtime_error if the socket can't
+/// be set up.
+WorkServer::WorkServer(WorkGenerator &work, uint16_t port) : mWork(work) {
+
+    mListenFd = ::socket(AF_INET, SOCK_STREAM, 0);
+    if (mListenFd < 0) {
+        throw std::runtime_error("Failed to create socket");
+    }
+    int one = 1;
+    ::setsockopt(mListenFd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+    struct sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(port);
+    if (::bind(mListenFd, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)) < 0 || 
+        ::listen(mListenFd, SOMAXCONN) < 0) {
+        ::close(mListenFd);
+        throw std::runtime_error("Failed to listen on port " + std::to_string(port));
+    }
+
+    socklen_t len = sizeof(addr);
+    ::getsockname(mListenFd, reinterpret_cast<struct sockaddr *>(&addr), &len);
+    mPort = ntohs(addr.sin_port);
+}
+
+WorkServer::~WorkServer() {
+    ::close(mListenFd);
+}
+
+/// Serves workers until stop() is called or all the work is done, then tells every worker to stop.
+void WorkServer::run(void) {
+
+    std::vector<struct pollfd> pollFds;
+    while (!mStop.load() && !workDone()) {
+        pollFds.clear();
+        pollFds.push_back({mListenFd, POLLIN, 0});
+        for (const auto &peer : mPeers) {
+            const short events = static_cast<short>(POLLIN | (peer.connection.wantsWrite() ? POLLOUT : 0));
+            pollFds.push_back({peer.connection.fd(), events, 0});
+        }
+
+        if (::poll(pollFds.data(), pollFds.size(), sPollTimeoutMs) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw std::runtime_error("Poll failed");
+        }
+
+        if (pollFds[0].revents & POLLIN) {
+            accept();
+        }
+
+        // pollFds[i + 1] belongs to the i-th peer at the time of the poll. Peers accepted above are at the end of 
+        // the list and are not visited until the next poll.
+        auto it = mPeers.begin();
+        for (size_t i = 1; i < pollFds.size(); ++i) {
+            auto &peer = *it;
+            std::vector<Protocol::Message> messages;
+            bool ok = true;
+            if (pollFds[i].revents & (POLLIN | POLLHUP | POLLERR)) {
+                ok = peer.connection.receive(messages);
+            }
+            for (const auto &message : messages) {
+                handle(peer, message);
+            }
+            ok = peer.connection.flush() && ok;
+
+            if (!ok) {
+                dropPeer(peer);
+                it = mPeers.erase(it);
+            } else {
+                ++it;
+            }
+        }
+
+        // Units of dropped workers go to the workers whose requests are being held.
+        for (auto &peer : mPeers) {
+            if (mRequeue.empty()) {
+                break;
+            }
+            if (peer.deferred > 0) {
+                sendWork(peer, peer.deferred);
+            }
+        }
+    }
+
+    for (auto &peer : mPeers) {
+        peer.connection.send(Protocol::Stop{});
+        peer.connection.flush();
+    }
+    mPeers.clear();
+    mFinished.store(true);
+}
+
+void WorkServer::accept(void) {
+    const int fd = ::accept(mListenFd, nullptr, nullptr);
+    if (fd >= 0) {
+        mPeers.push_back(Peer{Connection(fd), {}});
+    }
+}
+
+void WorkServer::handle(Peer &peer, const Protocol::Message &message) {
+
+    if (const auto *request = std::get_if<Protocol::RequestWork>(&message)) {
+        sendWork(peer, std::min(request->count, sMaxBatchSize));
+
+    } else if (const auto *share = std::get_if<Protocol::Share>(&message)) {
+        // Shares are checked here, so a faulty worker can't report a hash that doesn't meet the target.
+        auto unit = peer.assigned.find(share->unitId);
+        bool valid = false;
+        if (unit != peer.assigned.end() && share->nonce >= unit->second.firstNonce && 
+            share->nonce <= unit->second.lastNonce) {
+            BlockHeader header = unit->second.header;
+            header.setNonce(share->nonce);
+            const auto threshold = BlockHeader::nbitsToThreshold(header.nbits());
+            valid = Miner::validHash(threshold, Sha256::doubleHashHeader(header.data()));
+            if (valid) {
+                std::scoped_lock lock(mMutex);
+                mShares.push_back(FoundShare{share->unitId, unit->second.extranonce, header});
+            }
+        }
+        if (!valid) {
+            std::scoped_lock lock(mMutex);
+            ++mStats.invalidShares;
+        }
+
+    } else if (const auto *done = std::get_if<Protocol::UnitDone>(&message)) {
+        if (peer.assigned.erase(done->unitId) > 0) {
+            std::scoped_lock lock(mMutex);
+            mCompleted.insert(done->unitId);
+            ++mStats.unitsCompleted;
+            mStats.hashes += done->hashes;
+        }
+    }
+}
+
+/// Sends up to count units in one frame. Units left behind by dropped workers go first. If there are none to send,
+/// the request is held instead: an empty batch would only have the worker ask again straight away.
+void WorkServer::sendWork(Peer &peer, uint32_t count) {
+
+    Protocol::WorkBatch batch;
+    batch.items.reserve(count);
+    uint64_t issued = 0;
+    uint64_t reassigned = 0;
+
+    while (batch.items.size() < count) {
+        uint64_t unitId = 0;
+        std::optional<WorkUnit> unit;
+        if (!mRequeue.empty()) {
+            std::tie(unitId, unit) = mRequeue.front();
+            mRequeue.pop_front();
+            ++reassigned;
+        } else {
+            unit = mWork.next();
+            if (!unit.has_value()) {
+                mExhausted = true;
+                break;
+            }
+            unitId = mNextUnitId++;
+            ++issued;
+        }
+
+        Protocol::WorkItem item{unitId, {}, unit->firstNonce, unit->lastNonce};
+        std::ranges::copy(unit->header.data(), item.header.begin());
+        batch.items.push_back(item);
+        peer.assigned.emplace(unitId, *unit);
+    }
+
+    {
+        std::scoped_lock lock(mMutex);
+        mStats.unitsIssued += issued;
+        mStats.unitsReassigned += reassigned;
+    }
+    if (batch.items.empty() && count > 0) {
+        peer.deferred = count;
+        return;
+    }
+    peer.deferred = 0;
+    peer.connection.send(batch);
+}
+
+/// Puts every unit the peer had not finished back in the queue.
+void WorkServer::dropPeer(Peer &peer) {
+    for (auto &[unitId, unit] : peer.assigned) {
+        mRequeue.emplace_back(unitId, unit);
+    }
+    peer.assigned.clear();
+}
+
+/// True once the generator is exhausted and no unit is still out with a worker or waiting to be reassigned.
+bool WorkServer::workDone(void) const {
+    return mExhausted && mRequeue.empty() && 
+        std::ranges::all_of(mPeers, [](const Peer &peer) { return peer.assigned.empty(); });
+}
+
+std::vector<WorkServer::FoundShare> WorkServer::shares(void) const {
+    std::scoped_lock lock(mMutex);
+    return mShares;
+}
+
+WorkServer::Stats WorkServer::stats(void) const {
+    std::scoped_lock lock(mMutex);
+    return mStats;
+}
+
+bool WorkServer::completed(uint64_t unitId) const {
+    std::scoped_lock lock(mMutex);
+    return mCompleted.contains(unitId);
+}
+
+} // namespace miner
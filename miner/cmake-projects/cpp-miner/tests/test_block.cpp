@@ -1,5 +1,6 @@
 #include <bit>
 #include <iostream>
+#include <stdexcept>
 #include <vector>
 
 #include "gtest/gtest.h"
@@ -95,4 +96,60 @@ TEST_F(TestFixture_Block, TestGenesisBlockContentCorrect) {
     ASSERT_EQ(header.nbits(), 0x1d00ffff);
     ASSERT_EQ(header.nonce(), 2083236893U);
     ASSERT_EQ(header.nonce(), 0x7C2BAC1D);
-}
\ No newline at end of file
+}
+
+TEST_F(TestFixture_Block, TestHexToWords) {
+    std::array<uint32_t, 2> words;
+    ASSERT_TRUE(miner::BlockHeader::hexToWords("0123456789abcdef", words));
+    ASSERT_EQ(words[0], 0x67452301);
+    ASSERT_EQ(words[1], 0xEFCDAB89);
+
+    ASSERT_TRUE(miner::BlockHeader::hexToWords("fFaA0099", std::span(words).first(1)));
+    ASSERT_EQ(words[0], 0x9900AAFF);
+
+    // Wrong sizes and every kind of near-miss character are rejected.
+    ASSERT_FALSE(miner::BlockHeader::hexToWords("0123456789ABCDEF", std::span(words).first(1)));
+    for (std::string bad : {"0123456G", "012345/7", "0123:567", "@1234567", "`1234567", "g1234567", "0123 567"}) {
+        ASSERT_FALSE(miner::BlockHeader::hexToWords(bad, std::span(words).first(1))) << bad;
+    }
+    ASSERT_THROW(miner::BlockHeader::hexStrToBinary("0123456Z"), std::out_of_range);
+}
+
+TEST_F(TestFixture_Block, TestBlockCreationRejectsMalformedHex) {
+    const std::string version = "01000000";
+    const std::string prevhash = "0000000000000000000000000000000000000000000000000000000000000000";
+    const std::string merkleRoot = "3BA3EDFD7A7B12B27AC72C3E67768F617FC81BC3888A51323A9FB8AA4B1E5E4A";
+    const std::string time = "29AB5F49";
+    const std::string nbits = "FFFF001D";
+
+    ASSERT_NO_THROW(miner::BlockHeader(version, prevhash, merkleRoot, time, nbits));
+    ASSERT_THROW(miner::BlockHeader("0100000X", prevhash, merkleRoot, time, nbits), std::out_of_range);
+    ASSERT_THROW(miner::BlockHeader(version, prevhash, merkleRoot.substr(1) + "G", time, nbits), std::out_of_range);
+    ASSERT_THROW(miner::BlockHeader(version, prevhash, merkleRoot, time, "FFFF 01D"), std::out_of_range);
+}
+
+TEST_F(TestFixture_Block, TestParseHeaders) {
+    // Block 125552 from https://en.bitcoin.it/wiki/Block_hashing_algorithm and the genesis block.
+    const std::string block125552 = "01000000"
+        "81cd02ab7e569e8bcd9317e2fe99f2de44d49ab2b8851ba4a308000000000000"
+        "e320b6c2fffc8d750423db8b1eb942ae710e951ed797f7affc8892b0f1fc122b"
+        "c7f5d74df2b9441a42a14695";
+    const std::string genesis = "01000000"
+        "0000000000000000000000000000000000000000000000000000000000000000"
+        "3BA3EDFD7A7B12B27AC72C3E67768F617FC81BC3888A51323A9FB8AA4B1E5E4A"
+        "29AB5F49FFFF001D1DAC2B7C";
+
+    std::vector<miner::BlockHeader> headers;
+    ASSERT_TRUE(miner::BlockHeader::parseHeaders(block125552 + "\r\n\n" + genesis, headers));
+    ASSERT_EQ(headers.size(), 2);
+
+    ASSERT_EQ(headers[0].nonce(), 0x9546a142);
+    ASSERT_EQ(headers[0].nbits(), 0x1a44b9f2);
+
+    auto expected = miner::BlockHeader::genesisBlock();
+    std::vector<uint32_t> expectedData{expected.data().begin(), expected.data().end()};
+    std::vector<uint32_t> actualData{headers[1].data().begin(), headers[1].data().end()};
+    ASSERT_EQ(actualData, expectedData);
+
+    ASSERT_FALSE(miner::BlockHeader::parseHeaders(genesis.substr(1), headers));
+}
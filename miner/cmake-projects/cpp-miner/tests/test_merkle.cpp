@@ -0,0 +1,114 @@
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "miner/block.h"
+#include "miner/merkle.h"
+#include "miner/sha256_lanes.h"
+
+using namespace ::testing;
+
+class TestFixture_Merkle : public Test {
+protected:
+
+    /// Converts a hash as displayed by block explorers, which is byte reversed, to a hash in block byte order.
+    miner::MerkleTree::Hash fromDisplayHex(const std::string &hex) {
+        std::string reversed;
+        for (size_t i = hex.size(); i >= 2; i -= 2) {
+            reversed += hex.substr(i - 2, 2);
+        }
+        miner::MerkleTree::Hash hash;
+        std::ranges::copy(miner::BlockHeader::hexStrToBinary(reversed), hash.begin());
+        return hash;
+    }
+
+    std::vector<miner::MerkleTree::Hash> makeLeaves(size_t n) {
+        std::vector<miner::MerkleTree::Hash> leaves(n);
+        uint32_t x = 1;
+        for (auto &leaf : leaves) {
+            for (auto &w : leaf) {
+                x = x * 1664525 + 1013904223;
+                w = x;
+            }
+        }
+        return leaves;
+    }
+
+    /// A straightforward merkle root to check the tree against.
+    miner::MerkleTree::Hash referenceRoot(std::vector<miner::MerkleTree::Hash> level) {
+        while (level.size() > 1) {
+            if (level.size() % 2 == 1) {
+                level.push_back(level.back());
+            }
+            std::vector<miner::MerkleTree::Hash> parents;
+            for (size_t i = 0; i < level.size(); i += 2) {
+                parents.push_back(miner::MerkleTree::hashPair(level[i], level[i + 1]));
+            }
+            level = parents;
+        }
+        return level.front();
+    }
+};
+
+TEST_F(TestFixture_Merkle, Block100000) {
+    // https://blockchain.info/block-height/100000
+    std::vector<miner::MerkleTree::Hash> txids = {
+        fromDisplayHex("8c14f0db3df150123e6f3dbbf30f8b955a8249b62ac1d1ff16284aefa3d06d87"),
+        fromDisplayHex("fff2525b8931402dd09222c50775608f75787bd2b87e56995a7bdd30f79702c4"),
+        fromDisplayHex("6359f0868171b1d194cbee1af2f16ea598ae8fad666d9b012c8ed2b79a236ec4"),
+        fromDisplayHex("e9a66845e05d5abc0ad04ec80f774a7e585c6e8db975962d069a522137b80c1d")
+    };
+
+    miner::MerkleTree tree(txids);
+
+    ASSERT_EQ(tree.root(), fromDisplayHex("f3e94742aca4b5ef85488dc37c06c3282295ffec960994b2c0d5ac2a25a95766"));
+}
+
+TEST_F(TestFixture_Merkle, SingleLeafIsRoot) {
+    auto leaves = makeLeaves(1);
+    miner::MerkleTree tree(leaves);
+    ASSERT_EQ(tree.root(), leaves.front());
+}
+
+TEST_F(TestFixture_Merkle, OddLevelsAndUpdates) {
+    for (size_t n : {2, 3, 5, 7, 33, 100}) {
+        auto leaves = makeLeaves(n);
+        miner::MerkleTree tree(leaves);
+        ASSERT_EQ(tree.root(), referenceRoot(leaves)) << n << " leaves";
+
+        for (size_t index : {size_t(0), n / 2, n - 1}) {
+            leaves[index][0] ^= 0xFFFFFFFF;
+            tree.updateLeaf(index, leaves[index]);
+            ASSERT_EQ(tree.root(), referenceRoot(leaves)) << n << " leaves, updated " << index;
+        }
+    }
+}
+
+TEST_F(TestFixture_Merkle, ParallelBuildMatchesSerial) {
+    auto leaves = makeLeaves(3 * miner::MerkleTree::sMinPairsPerThread * 2 + 1);
+    miner::MerkleTree serial(leaves, 1);
+    miner::MerkleTree parallel(leaves, 4);
+    ASSERT_EQ(parallel.root(), serial.root());
+    ASSERT_EQ(serial.root(), referenceRoot(leaves));
+}
+
+TEST_F(TestFixture_Merkle, HashPairsMatchesScalarOnEveryIsa) {
+    using Isa = miner::Sha256Lanes::Isa;
+
+    auto in = makeLeaves(2 * 37);
+    std::vector<miner::MerkleTree::Hash> expected(37);
+    for (size_t i = 0; i < expected.size(); ++i) {
+        expected[i] = miner::MerkleTree::hashPair(in[2*i], in[2*i + 1]);
+    }
+
+    for (auto isa : {Isa::Scalar, Isa::Sse2, Isa::Avx2, Isa::Avx512}) {
+        if (!miner::Sha256Lanes::supported(isa)) {
+            continue;
+        }
+        std::vector<miner::MerkleTree::Hash> actual(expected.size());
+        miner::Sha256Lanes::hashPairs(isa, in, actual);
+        ASSERT_EQ(actual, expected) << miner::Sha256Lanes::name(isa);
+    }
+}
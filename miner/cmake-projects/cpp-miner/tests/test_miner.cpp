@@ -24,3 +24,48 @@ TEST_F(TestFixture_Miner, TestValidHash) {
     miner::Sha256::HashValue h3 = {0x9, 0x1, 0, 0, 0, 0, 0, 0};
     ASSERT_FALSE(miner::Miner::validHash(t3, h3));
 }
+
+TEST_F(TestFixture_Miner, TestMineFindsGenesisNonce) {
+    auto header = miner::BlockHeader::genesisBlock();
+    const uint32_t expected = header.nonce();
+    const uint32_t time = header.time();
+
+    auto nonce = miner::Miner::mine(expected - 1000, header);
+
+    ASSERT_TRUE(nonce.has_value());
+    ASSERT_EQ(*nonce, expected);
+    ASSERT_EQ(header.nonce(), expected);
+    ASSERT_EQ(header.time(), time);
+}
+
+TEST_F(TestFixture_Miner, TestMineParallelFindsGenesisNonce) {
+    auto header = miner::BlockHeader::genesisBlock();
+    const uint32_t expected = header.nonce();
+
+    // Four chunks of 2501 nonces, the genesis nonce sits in the second one.
+    auto result = miner::Miner::mineParallel(header, 4, expected - 5000, expected + 5000);
+
+    ASSERT_TRUE(result.nonce.has_value());
+    ASSERT_EQ(*result.nonce, expected);
+    ASSERT_EQ(result.worker, 1);
+    ASSERT_GT(result.hashes, 0);
+}
+
+TEST_F(TestFixture_Miner, TestMineParallelNoSolution) {
+    auto header = miner::BlockHeader::genesisBlock();
+
+    auto result = miner::Miner::mineParallel(header, 3, 0, 999);
+
+    ASSERT_FALSE(result.nonce.has_value());
+    ASSERT_EQ(result.hashes, 1000);
+}
+
+TEST_F(TestFixture_Miner, TestMineParallelEndOfNonceSpace) {
+    auto header = miner::BlockHeader::genesisBlock();
+
+    // More threads than nonces, and a range that ends on the largest nonce must not wrap around.
+    auto result = miner::Miner::mineParallel(header, 8, miner::Miner::sMaxNonce - 4, miner::Miner::sMaxNonce);
+
+    ASSERT_FALSE(result.nonce.has_value());
+    ASSERT_EQ(result.hashes, 5);
+}
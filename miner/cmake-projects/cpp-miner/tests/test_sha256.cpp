@@ -1,5 +1,7 @@
 #include <algorithm>
 #include <bit>
+#include <cstdio>
+#include <fstream>
 #include <iostream>
 #include <vector>
 
@@ -7,6 +9,7 @@
 
 #include "miner/block.h"
 #include "miner/sha256.h"
+#include "miner/sha256_lanes.h"
 
 using namespace ::testing;
 
@@ -163,4 +166,210 @@ TEST_F(TestFixture_Sha256, HashGenesisBlock) {
     };
 
     ASSERT_EQ(hashValue, expectedHash);
-}
\ No newline at end of file
+}
+
+TEST_F(TestFixture_Sha256, HashGenesisBlockFromMidstate) {
+    auto block = miner::BlockHeader::genesisBlock();
+
+    auto midstate = miner::Sha256::midstate(block.data());
+    auto tail = miner::Sha256::tailBlock(block.data());
+    ASSERT_EQ(miner::Sha256::hashTail(midstate, tail), miner::Sha256::hash(block.data()));
+
+    // The midstate is reused when only the nonce changes.
+    for (uint32_t nonce : {0U, 1U, 0xDEADBEEFU, 0xFFFFFFFFU}) {
+        block.setNonce(nonce);
+        tail[3] = nonce;
+        ASSERT_EQ(miner::Sha256::hashTail(midstate, tail), miner::Sha256::hash(block.data()));
+    }
+}
+
+TEST_F(TestFixture_Sha256, HashNoncesMatchesScalarOnEveryIsa) {
+    using Isa = miner::Sha256Lanes::Isa;
+
+    auto block = miner::BlockHeader::genesisBlock();
+    const uint32_t firstNonce = block.nonce() - 20;
+    auto midstate = miner::Sha256::midstate(block.data());
+    auto tail = miner::Sha256::tailBlock(block.data());
+
+    // 37 nonces is not a multiple of any lane count, so the partial final batch is exercised too.
+    std::vector<miner::Sha256::HashValue> expected(37);
+    for (uint32_t i = 0; i < expected.size(); ++i) {
+        block.setNonce(firstNonce + i);
+        expected[i] = miner::Sha256::hash(miner::Sha256::hash(block.data()));
+    }
+
+    for (auto isa : {Isa::Scalar, Isa::Sse2, Isa::Avx2, Isa::Avx512}) {
+        if (!miner::Sha256Lanes::supported(isa)) {
+            continue;
+        }
+        std::vector<miner::Sha256::HashValue> actual(expected.size());
+        miner::Sha256Lanes::hashNonces(isa, midstate, tail, firstNonce, actual);
+        ASSERT_EQ(actual, expected) << miner::Sha256Lanes::name(isa);
+    }
+}
+
+TEST_F(TestFixture_Sha256, HashBlockShaNiMatchesScalar) {
+    if (!miner::Sha256::shaNiSupported()) {
+        GTEST_SKIP() << "CPU does not support the SHA extensions";
+    }
+
+    // Chain the output of each compression into the next so every round constant and schedule word gets exercised
+    // with a wide range of values.
+    miner::Sha256::HashValue scalar = miner::Sha256::sInitialHash;
+    miner::Sha256::HashValue shaNi = miner::Sha256::sInitialHash;
+    miner::Sha256::Block block;
+    uint32_t x = 0x12345678;
+    for (int i = 0; i < 1000; ++i) {
+        for (auto &w : block) {
+            x = x * 1664525 + 1013904223;
+            w = x;
+        }
+        scalar = miner::Sha256::hashBlockScalar(scalar, block);
+        shaNi = miner::Sha256::hashBlockShaNi(shaNi, block);
+        ASSERT_EQ(shaNi, scalar) << "block " << i;
+    }
+}
+
+TEST_F(TestFixture_Sha256, DoubleHashHeader) {
+    auto block = miner::BlockHeader::genesisBlock();
+    auto midstate = miner::Sha256::midstate(block.data());
+    auto tail = miner::Sha256::tailBlock(block.data());
+    auto expected = miner::Sha256::hash(miner::Sha256::hash(block.data()));
+
+    ASSERT_EQ(miner::Sha256::doubleHashHeader(block.data()), expected);
+
+    miner::Sha256::HashValue actual;
+    ASSERT_TRUE(miner::Sha256::doubleHashHeader(midstate, tail, 0, actual));
+    ASSERT_EQ(actual, expected);
+
+    // One nonce earlier the top word is non-zero, so a zero limit rejects it after writing only the top word.
+    block.setNonce(block.nonce() - 1);
+    tail[3] = block.nonce();
+    expected = miner::Sha256::hash(miner::Sha256::hash(block.data()));
+    ASSERT_NE(expected[7], 0);
+    ASSERT_FALSE(miner::Sha256::doubleHashHeader(midstate, tail, 0, actual));
+    ASSERT_EQ(actual[7], expected[7]);
+    ASSERT_TRUE(miner::Sha256::doubleHashHeader(midstate, tail, expected[7], actual));
+    ASSERT_EQ(actual, expected);
+}
+
+TEST_F(TestFixture_Sha256, DoubleHashHeaderScalarRejectsOnTopWord) {
+    // doubleHashHeader uses the SHA extensions when the CPU has them, so the scalar early exit is called directly.
+    auto block = miner::BlockHeader::genesisBlock();
+    auto midstate = miner::Sha256::midstate(block.data());
+    auto tail = miner::Sha256::tailBlock(block.data());
+    auto expected = miner::Sha256::hash(miner::Sha256::hash(block.data()));
+
+    miner::Sha256::HashValue actual;
+    ASSERT_TRUE(miner::Sha256::doubleHashHeaderScalar(midstate, tail, 0, actual));
+    ASSERT_EQ(actual, expected);
+
+    // A rejected hash has only its top word written.
+    block.setNonce(block.nonce() - 1);
+    tail[3] = block.nonce();
+    expected = miner::Sha256::hash(miner::Sha256::hash(block.data()));
+    ASSERT_NE(expected[7], 0);
+    actual.fill(0xDEADBEEF);
+    ASSERT_FALSE(miner::Sha256::doubleHashHeaderScalar(midstate, tail, expected[7] - 1, actual));
+    ASSERT_EQ(actual[7], expected[7]);
+    for (size_t i = 0; i < 7; ++i) {
+        ASSERT_EQ(actual[i], 0xDEADBEEF) << "word " << i;
+    }
+
+    // The top word equal to the limit is accepted.
+    ASSERT_TRUE(miner::Sha256::doubleHashHeaderScalar(midstate, tail, expected[7], actual));
+    ASSERT_EQ(actual, expected);
+
+    if (miner::Sha256::shaNiSupported()) {
+        ASSERT_FALSE(miner::Sha256::doubleHashHeaderShaNi(midstate, tail, expected[7] - 1, actual));
+        ASSERT_EQ(actual, expected);
+        ASSERT_TRUE(miner::Sha256::doubleHashHeaderShaNi(midstate, tail, expected[7], actual));
+        ASSERT_EQ(actual, expected);
+    }
+}
+
+TEST_F(TestFixture_Sha256, HashNoncesEarlyExitKeepsTopWord) {
+    using Isa = miner::Sha256Lanes::Isa;
+
+    auto block = miner::BlockHeader::genesisBlock();
+    const uint32_t genesisNonce = block.nonce();
+    const uint32_t firstNonce = genesisNonce - 40;
+    auto midstate = miner::Sha256::midstate(block.data());
+    auto tail = miner::Sha256::tailBlock(block.data());
+
+    std::vector<miner::Sha256::HashValue> expected(41);
+    for (uint32_t i = 0; i < expected.size(); ++i) {
+        block.setNonce(firstNonce + i);
+        expected[i] = miner::Sha256::hash(miner::Sha256::hash(block.data()));
+    }
+
+    for (auto isa : {Isa::Scalar, Isa::Sse2, Isa::Avx2, Isa::Avx512}) {
+        if (!miner::Sha256Lanes::supported(isa)) {
+            continue;
+        }
+        std::vector<miner::Sha256::HashValue> actual(expected.size());
+        miner::Sha256Lanes::hashNonces(isa, midstate, tail, firstNonce, actual, 0);
+        for (uint32_t i = 0; i < expected.size(); ++i) {
+            ASSERT_EQ(actual[i][7], expected[i][7]) << miner::Sha256Lanes::name(isa) << " nonce " << i;
+        }
+        // Only the genesis nonce meets the limit, and its hash must be complete.
+        ASSERT_EQ(actual.back(), expected.back()) << miner::Sha256Lanes::name(isa);
+    }
+}
+
+TEST_F(TestFixture_Sha256, ContextKnownVectors) {
+    auto digest = [](const std::string &message, size_t chunkSize) {
+        miner::Sha256::Context context;
+        std::span<const uint8_t> bytes(reinterpret_cast<const uint8_t *>(message.data()), message.size());
+        while (!bytes.empty()) {
+            const size_t n = std::min(chunkSize, bytes.size());
+            context.update(bytes.first(n));
+            bytes = bytes.subspan(n);
+        }
+        return miner::Sha256::toHex(context.finalize());
+    };
+
+    const std::string twoBlocks = "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq";
+    const std::string million(1000000, 'a');
+
+    // Chunk sizes that split the input across block boundaries in different ways.
+    for (size_t chunkSize : {1, 3, 55, 56, 63, 64, 65, 1000}) {
+        ASSERT_EQ(digest("", chunkSize), "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855");
+        ASSERT_EQ(digest("abc", chunkSize), "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+        ASSERT_EQ(digest(twoBlocks, chunkSize), "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1");
+    }
+    ASSERT_EQ(digest(million, 4096), "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0");
+}
+
+TEST_F(TestFixture_Sha256, ContextMatchesWordHash) {
+    auto block = miner::BlockHeader::genesisBlock();
+    auto data = block.data();
+
+    miner::Sha256::Context context;
+    context.update(std::span<const uint8_t>(reinterpret_cast<const uint8_t *>(data.data()), data.size_bytes()));
+
+    ASSERT_EQ(context.finalize(), miner::Sha256::hash(data));
+}
+
+TEST_F(TestFixture_Sha256, HashFile) {
+    const std::string path = ::testing::TempDir() + "miner_hash_file_test.bin";
+    std::string contents;
+    for (int i = 0; i < 300000; ++i) {
+        contents.push_back(static_cast<char>(i * 7));
+    }
+    {
+        std::ofstream file(path, std::ios::binary);
+        file << contents;
+    }
+
+    miner::Sha256::Context context;
+    context.update(std::span<const uint8_t>(reinterpret_cast<const uint8_t *>(contents.data()), contents.size()));
+    auto expected = context.finalize();
+
+    auto actual = miner::Sha256::hashFile(path);
+    std::remove(path.c_str());
+
+    ASSERT_TRUE(actual.has_value());
+    ASSERT_EQ(*actual, expected);
+    ASSERT_FALSE(miner::Sha256::hashFile(path).has_value());
+}
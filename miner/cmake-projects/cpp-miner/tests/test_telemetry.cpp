@@ -0,0 +1,81 @@
+#include <chrono>
+#include <sstream>
+#include <thread>
+
+#include "gtest/gtest.h"
+
+#include "miner/miner.h"
+#include "miner/telemetry.h"
+
+using namespace ::testing;
+using namespace std::chrono_literals;
+
+class TestFixture_Telemetry : public Test {
+protected:
+};
+
+TEST_F(TestFixture_Telemetry, LatencyBucketsRoundTrip) {
+    for (uint64_t ns : {0ULL, 1ULL, 3ULL, 4ULL, 7ULL, 100ULL, 4096ULL, 123456789ULL, ~0ULL}) {
+        const auto bucket = miner::Telemetry::latencyBucket(ns);
+        ASSERT_LT(bucket, miner::Telemetry::sLatencyBuckets);
+        const auto lower = miner::Telemetry::bucketLowerBound(bucket);
+        ASSERT_LE(lower, ns);
+        ASSERT_GE(lower, ns - ns / 4);
+    }
+}
+
+TEST_F(TestFixture_Telemetry, RatesAndPercentiles) {
+    miner::Telemetry telemetry(2);
+    const auto t0 = miner::Telemetry::Clock::time_point{};
+    telemetry.sample(t0);
+
+    // 20 seconds at 1000 hashes per second, then 10 seconds at 4000.
+    for (int s = 1; s <= 30; ++s) {
+        const uint64_t hashes = s <= 20 ? 1000 : 4000;
+        telemetry.recordBatch(0, hashes / 2, 1us);
+        telemetry.recordBatch(1, hashes / 2, 1us);
+        telemetry.sample(t0 + std::chrono::seconds(s));
+    }
+
+    auto snapshot = telemetry.snapshot();
+    ASSERT_EQ(snapshot.hashes, 20 * 1000 + 10 * 4000);
+    ASSERT_DOUBLE_EQ(snapshot.hashRates[0], 4000);
+    ASSERT_DOUBLE_EQ(snapshot.hashRates[1], 4000);
+    ASSERT_DOUBLE_EQ(snapshot.hashRates[2], 2000);
+
+    // 98 fast batches and 2 slow ones in the last interval.
+    for (int i = 0; i < 98; ++i) {
+        telemetry.recordBatch(i % 2, 1, 1000ns);
+    }
+    telemetry.recordBatch(0, 1, 1ms);
+    telemetry.recordBatch(1, 1, 1ms);
+    telemetry.recordShare(1);
+    telemetry.recordStale(0);
+    telemetry.sample(t0 + 31s);
+
+    snapshot = telemetry.snapshot();
+    ASSERT_EQ(snapshot.shares, 1);
+    ASSERT_EQ(snapshot.staleUnits, 1);
+    ASSERT_EQ(snapshot.batchLatencyP50, 
+        miner::Telemetry::bucketLowerBound(miner::Telemetry::latencyBucket(1000)) * 1ns);
+    ASSERT_EQ(snapshot.batchLatencyP99, 
+        miner::Telemetry::bucketLowerBound(miner::Telemetry::latencyBucket(1000000)) * 1ns);
+}
+
+TEST_F(TestFixture_Telemetry, SamplerLogsWhileMining) {
+    const unsigned nThreads = 2;
+    miner::Telemetry telemetry(nThreads);
+    std::ostringstream log;
+    telemetry.start(10ms, &log, 1);
+
+    auto header = miner::BlockHeader::genesisBlock();
+    auto result = miner::Miner::mineParallel(header, nThreads, 0, (1U << 16) - 1, &telemetry);
+    std::this_thread::sleep_for(50ms);
+    telemetry.stop();
+
+    const auto snapshot = telemetry.snapshot();
+    ASSERT_EQ(snapshot.hashes, result.hashes);
+    ASSERT_EQ(snapshot.shares, 0);
+    ASSERT_GT(snapshot.hashRates[2], 0);
+    ASSERT_NE(log.str().find("Hash rate"), std::string::npos);
+}
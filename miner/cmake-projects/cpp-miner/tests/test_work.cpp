@@ -0,0 +1,100 @@
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "miner/block.h"
+#include "miner/merkle.h"
+#include "miner/miner.h"
+#include "miner/work.h"
+
+using namespace ::testing;
+
+class TestFixture_Work : public Test {
+protected:
+
+    static constexpr uint64_t sNonceSpace = uint64_t(1) << 32;
+
+    std::vector<miner::MerkleTree::Hash> makeLeaves(size_t n) {
+        std::vector<miner::MerkleTree::Hash> leaves(n);
+        uint32_t x = 7;
+        for (auto &leaf : leaves) {
+            for (auto &w : leaf) {
+                x = x * 1664525 + 1013904223;
+                w = x;
+            }
+        }
+        return leaves;
+    }
+
+    static miner::MerkleTree::Hash coinbase(uint64_t extranonce) {
+        static const std::vector<uint8_t> prefix = {0x01, 0x00, 0x00, 0x00, 0x01};
+        static const std::vector<uint8_t> suffix = {0xFF, 0xFF, 0xFF, 0xFF};
+        return miner::WorkGenerator::coinbaseHash(prefix, extranonce, suffix);
+    }
+};
+
+TEST_F(TestFixture_Work, UnitsCoverNonceSpaceThenRollTime) {
+    auto header = miner::BlockHeader::genesisBlock();
+    miner::WorkGenerator work(header, sNonceSpace / 2);
+
+    auto u1 = work.next();
+    auto u2 = work.next();
+    auto u3 = work.next();
+    ASSERT_TRUE(u1.has_value() && u2.has_value() && u3.has_value());
+
+    ASSERT_EQ(u1->firstNonce, 0);
+    ASSERT_EQ(u1->lastNonce, 0x7FFFFFFF);
+    ASSERT_EQ(u2->firstNonce, 0x80000000);
+    ASSERT_EQ(u2->lastNonce, 0xFFFFFFFF);
+    ASSERT_EQ(u1->header.time(), header.time());
+    ASSERT_EQ(u2->header.time(), header.time());
+
+    ASSERT_EQ(u3->firstNonce, 0);
+    ASSERT_EQ(u3->header.time(), header.time() + 1);
+}
+
+TEST_F(TestFixture_Work, TimeRollIsBounded) {
+    auto header = miner::BlockHeader::genesisBlock();
+    miner::WorkGenerator work(header, sNonceSpace);
+
+    for (uint32_t i = 0; i <= miner::WorkGenerator::sMaxTimeRoll; ++i) {
+        auto unit = work.next();
+        ASSERT_TRUE(unit.has_value());
+        ASSERT_EQ(unit->header.time(), header.time() + i);
+    }
+    ASSERT_FALSE(work.next().has_value());
+}
+
+TEST_F(TestFixture_Work, ExtranonceRollsMerkleRoot) {
+    auto leaves = makeLeaves(11);
+    miner::WorkGenerator work(miner::BlockHeader::genesisBlock(), miner::MerkleTree(leaves), coinbase, sNonceSpace);
+
+    for (uint64_t extranonce = 0; extranonce < 3; ++extranonce) {
+        auto unit = work.next();
+        ASSERT_TRUE(unit.has_value());
+        ASSERT_EQ(unit->extranonce, extranonce);
+
+        leaves[0] = coinbase(extranonce);
+        miner::MerkleTree expected(leaves);
+        std::vector<uint32_t> actualRoot{unit->header.merkleRoot().begin(), unit->header.merkleRoot().end()};
+        std::vector<uint32_t> expectedRoot{expected.root().begin(), expected.root().end()};
+        ASSERT_EQ(actualRoot, expectedRoot);
+    }
+}
+
+TEST_F(TestFixture_Work, MineWorkFindsValidHash) {
+    // A very easy target so a valid hash turns up within a few hundred nonces.
+    miner::BlockHeader header("01000000", std::string(64, '0'), 
+        "3BA3EDFD7A7B12B27AC72C3E67768F617FC81BC3888A51323A9FB8AA4B1E5E4A", "29AB5F49", "FFFF0020");
+    miner::WorkGenerator work(header, 64);
+
+    auto result = miner::Miner::mineWork(work, 3);
+
+    ASSERT_TRUE(result.unit.has_value());
+    auto solved = result.unit->header;
+    ASSERT_GE(solved.nonce(), result.unit->firstNonce);
+    ASSERT_LE(solved.nonce(), result.unit->lastNonce);
+    auto threshold = miner::BlockHeader::nbitsToThreshold(solved.nbits());
+    ASSERT_TRUE(miner::Miner::validHash(threshold, miner::Sha256::doubleHashHeader(solved.data())));
+}
@@ -0,0 +1,213 @@
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <poll.h>
+
+#include "gtest/gtest.h"
+
+#include "miner/miner.h"
+#include "miner/protocol.h"
+#include "miner/work.h"
+#include "miner/work_client.h"
+#include "miner/work_server.h"
+
+using namespace ::testing;
+
+class TestFixture_WorkServer : public Test {
+protected:
+
+    static constexpr auto sTimeout = std::chrono::seconds(30);
+
+    /// A very easy target so shares turn up within a few hundred nonces.
+    static miner::BlockHeader easyHeader(void) {
+        return miner::BlockHeader("01000000", std::string(64, '0'), 
+            "3BA3EDFD7A7B12B27AC72C3E67768F617FC81BC3888A51323A9FB8AA4B1E5E4A", "29AB5F49", "FFFF0020");
+    }
+
+    template <typename Predicate>
+    static bool waitFor(Predicate predicate) {
+        const auto deadline = std::chrono::steady_clock::now() + sTimeout;
+        while (!predicate()) {
+            if (std::chrono::steady_clock::now() > deadline) {
+                return false;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        return true;
+    }
+
+    /// Polls a raw connection once, writing what it has queued and reading what has arrived.
+    static void pump(miner::Connection &peer, std::vector<miner::Protocol::Message> &messages) {
+        struct pollfd pollFd{peer.fd(), static_cast<short>(POLLIN | (peer.wantsWrite() ? POLLOUT : 0)), 0};
+        ::poll(&pollFd, 1, 5);
+        peer.flush();
+        peer.receive(messages);
+    }
+};
+
+TEST_F(TestFixture_WorkServer, EncodeDecodeRoundTrip) {
+    miner::Protocol::WorkBatch batch;
+    for (uint32_t i = 0; i < 3; ++i) {
+        miner::Protocol::WorkItem item{i + 100, {}, i * 1000, i * 1000 + 999};
+        item.header.fill(0xA5A50000 + i);
+        batch.items.push_back(item);
+    }
+
+    std::vector<uint8_t> buffer;
+    miner::Protocol::encode(miner::Protocol::RequestWork{7}, buffer);
+    miner::Protocol::encode(batch, buffer);
+    miner::Protocol::encode(miner::Protocol::Share{42, 0xDEADBEEF}, buffer);
+    miner::Protocol::encode(miner::Protocol::UnitDone{43, uint64_t(1) << 40}, buffer);
+    miner::Protocol::encode(miner::Protocol::Stop{}, buffer);
+
+    bool error = false;
+    auto request = miner::Protocol::decode(buffer, error);
+    ASSERT_TRUE(request.has_value());
+    ASSERT_EQ(std::get<miner::Protocol::RequestWork>(*request).count, 7);
+
+    auto decoded = miner::Protocol::decode(buffer, error);
+    ASSERT_TRUE(decoded.has_value());
+    const auto &items = std::get<miner::Protocol::WorkBatch>(*decoded).items;
+    ASSERT_EQ(items.size(), 3);
+    for (size_t i = 0; i < items.size(); ++i) {
+        ASSERT_EQ(items[i].unitId, batch.items[i].unitId);
+        ASSERT_EQ(items[i].header, batch.items[i].header);
+        ASSERT_EQ(items[i].firstNonce, batch.items[i].firstNonce);
+        ASSERT_EQ(items[i].lastNonce, batch.items[i].lastNonce);
+    }
+
+    auto share = miner::Protocol::decode(buffer, error);
+    ASSERT_TRUE(share.has_value());
+    ASSERT_EQ(std::get<miner::Protocol::Share>(*share).unitId, 42);
+    ASSERT_EQ(std::get<miner::Protocol::Share>(*share).nonce, 0xDEADBEEF);
+
+    auto done = miner::Protocol::decode(buffer, error);
+    ASSERT_TRUE(done.has_value());
+    ASSERT_EQ(std::get<miner::Protocol::UnitDone>(*done).hashes, uint64_t(1) << 40);
+
+    auto stop = miner::Protocol::decode(buffer, error);
+    ASSERT_TRUE(stop.has_value());
+    ASSERT_TRUE(std::holds_alternative<miner::Protocol::Stop>(*stop));
+
+    ASSERT_TRUE(buffer.empty());
+    ASSERT_FALSE(error);
+}
+
+TEST_F(TestFixture_WorkServer, DecodeWaitsForFullFrameAndRejectsBadFrames) {
+    std::vector<uint8_t> frame;
+    miner::Protocol::encode(miner::Protocol::Share{1, 2}, frame);
+
+    bool error = false;
+    std::vector<uint8_t> partial(frame.begin(), frame.end() - 1);
+    ASSERT_FALSE(miner::Protocol::decode(partial, error).has_value());
+    ASSERT_FALSE(error);
+    ASSERT_EQ(partial.size(), frame.size() - 1);
+
+    std::vector<uint8_t> badType = frame;
+    badType[0] = 0x7F;
+    ASSERT_FALSE(miner::Protocol::decode(badType, error).has_value());
+    ASSERT_TRUE(error);
+
+    error = false;
+    std::vector<uint8_t> oversized = {3, 0, 0, 0, 0xFF, 0xFF, 0xFF, 0xFF};
+    ASSERT_FALSE(miner::Protocol::decode(oversized, error).has_value());
+    ASSERT_TRUE(error);
+}
+
+TEST_F(TestFixture_WorkServer, DroppedUnitsAreReassignedAndMined) {
+    miner::WorkGenerator work(easyHeader(), 1024);
+    miner::WorkServer server(work);
+    std::jthread serverThread([&] { server.run(); });
+
+    // A worker that takes four units and disconnects without doing them.
+    {
+        auto peer = miner::Connection::connect("127.0.0.1", server.port());
+        peer.send(miner::Protocol::RequestWork{4});
+        std::vector<miner::Protocol::Message> messages;
+        ASSERT_TRUE(waitFor([&] {
+            pump(peer, messages);
+            return !messages.empty();
+        }));
+        ASSERT_EQ(std::get<miner::Protocol::WorkBatch>(messages[0]).items.size(), 4);
+    }
+
+    miner::WorkClient client("127.0.0.1", server.port(), 2, 4);
+    std::jthread clientThread([&] { client.run(); });
+
+    ASSERT_TRUE(waitFor([&] {
+        for (uint64_t unitId = 0; unitId < 4; ++unitId) {
+            if (!server.completed(unitId)) {
+                return false;
+            }
+        }
+        return true;
+    }));
+
+    server.stop();
+    serverThread.join();
+    clientThread.join();
+
+    const auto stats = server.stats();
+    ASSERT_EQ(stats.unitsReassigned, 4);
+    ASSERT_GE(stats.unitsCompleted, 4);
+    ASSERT_GE(stats.hashes, 4 * 1024);
+    ASSERT_EQ(stats.invalidShares, 0);
+    ASSERT_GT(client.unitsDone(), 0);
+
+    const auto shares = server.shares();
+    ASSERT_FALSE(shares.empty());
+    for (auto share : shares) {
+        auto threshold = miner::BlockHeader::nbitsToThreshold(share.header.nbits());
+        ASSERT_TRUE(miner::Miner::validHash(threshold, miner::Sha256::doubleHashHeader(share.header.data())));
+    }
+}
+
+TEST_F(TestFixture_WorkServer, WorkersAreStoppedWhenWorkIsDone) {
+    // A generator with a single unit left.
+    miner::WorkGenerator work(easyHeader(), uint64_t(1) << 32);
+    for (uint32_t i = 0; i < miner::WorkGenerator::sMaxTimeRoll; ++i) {
+        ASSERT_TRUE(work.next().has_value());
+    }
+    miner::WorkServer server(work);
+    std::jthread serverThread([&] { server.run(); });
+
+    auto first = miner::Connection::connect("127.0.0.1", server.port());
+    first.send(miner::Protocol::RequestWork{4});
+    std::vector<miner::Protocol::Message> firstMessages;
+    ASSERT_TRUE(waitFor([&] {
+        pump(first, firstMessages);
+        return !firstMessages.empty();
+    }));
+    const auto items = std::get<miner::Protocol::WorkBatch>(firstMessages[0]).items;
+    ASSERT_EQ(items.size(), 1);
+
+    // The second worker's request is held rather than answered with an empty batch.
+    auto second = miner::Connection::connect("127.0.0.1", server.port());
+    second.send(miner::Protocol::RequestWork{4});
+    std::vector<miner::Protocol::Message> secondMessages;
+    for (int i = 0; i < 20; ++i) {
+        pump(second, secondMessages);
+    }
+    ASSERT_TRUE(secondMessages.empty());
+    ASSERT_FALSE(server.finished());
+
+    // Finishing the last unit ends the work. Both workers are told to stop and run() returns by itself.
+    first.send(miner::Protocol::UnitDone{items[0].unitId, 0});
+    firstMessages.clear();
+    ASSERT_TRUE(waitFor([&] {
+        pump(first, firstMessages);
+        return !firstMessages.empty();
+    }));
+    ASSERT_TRUE(std::holds_alternative<miner::Protocol::Stop>(firstMessages[0]));
+    ASSERT_TRUE(waitFor([&] {
+        pump(second, secondMessages);
+        return !secondMessages.empty();
+    }));
+    ASSERT_TRUE(std::holds_alternative<miner::Protocol::Stop>(secondMessages[0]));
+
+    ASSERT_TRUE(waitFor([&] { return server.finished(); }));
+    serverThread.join();
+    ASSERT_EQ(server.stats().unitsCompleted, 1);
+}